@@ -30,6 +30,7 @@
  */
 
 #include <iostream>
+#include <sys/time.h>
 #include "ns3/aodv-module.h"
 #include "ns3/core-module.h"
 #include "ns3/mobility-module.h"
@@ -48,6 +49,10 @@
 #include "ns3/nstime.h"
 #include "ns3/bundle-protocol-helper.h"
 #include "ns3/one-traffic-helper.h"
+#include "ns3/ns2-mobility-cache-helper.h"
+#include "ns3/event-counting-scheduler.h"
+#include "ns3/bp-data-gatherer.h"
+#include "ns3/bp-eviction-policy.h"
 
 NS_LOG_COMPONENT_DEFINE("AODVTest");
 
@@ -102,6 +107,7 @@ private:
 	std::string traffic_;
 	int num_nodes_;
 	int len_buff_;
+	bool ip_stack_;
 	void createNodes();
 	void createDevices();
 	void createDevices80211p();
@@ -123,6 +129,7 @@ Experiment::Experiment() {
 	traffic_ = "traffic_04";
 	num_nodes_ = 9;
 	len_buff_ = 0;
+	ip_stack_ = false;
 }
 
 void Experiment::configure(int argc, char **argv) {
@@ -135,6 +142,7 @@ void Experiment::configure(int argc, char **argv) {
 	cmd.AddValue("tr", "Traffic of cenario",traffic_);
 	cmd.AddValue("nn", "Number of Nodes",num_nodes_);
 	cmd.AddValue("buff", "Number of bundle for each buffer",len_buff_);
+	cmd.AddValue("ip", "Install IPv4 with AODV, the DTN stack runs on packet sockets and does not need it",ip_stack_);
 	cmd.Parse(argc, argv);
 
 	std::cout<<"st:"<<simulation_time_<<" ss:"<<simulation_seed_<<" pt:"<<protocol_<<" ce:"<<cenario_<<" tr:"<<traffic_<<" nn:"<<num_nodes_<<" buff:"<<len_buff_<<"\n";
@@ -143,17 +151,37 @@ void Experiment::configure(int argc, char **argv) {
 }
 
 void Experiment::run() {
+	// Counts the events, the order of the events is the one of the default scheduler
+	ObjectFactory scheduler;
+	scheduler.SetTypeId("ns3::EventCountingScheduler");
+	Simulator::SetScheduler(scheduler);
 	createNodes();
 	createMobility();
 	createDevices();
 	//createDevices80211p();
-	installInternetStack();
+	// AODV hellos and routing cost events and airtime the DTN stack does not use
+	if (ip_stack_)
+		installInternetStack();
 	installApplications();
 	//createTraffic();
 	//createStats();
+	bundleProtocol::DataGatherer gatherer(protocol_, num_nodes_);
+	Config::ConnectWithoutContext("/NodeList/*/$ns3::bundleProtocol::BundleRouter/Evicted",
+			MakeCallback(&bundleProtocol::DataGatherer::Evicted, &gatherer));
 	Simulator::Stop(Seconds(simulation_time_));
+	struct timeval start, end;
+	gettimeofday(&start, 0);
 	Simulator::Run();
+	gettimeofday(&end, 0);
+	// Read before Destroy, which empties the queue
+	uint64_t events = EventCountingScheduler::GetNExecuted();
 	Simulator::Destroy();
+	double wall = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+	std::cout << "Simulation ran " << events << " events in " << wall << " s" << (ip_stack_ ? " with" : " without") << " IP\n";
+	std::cout << "Evicted: " << gatherer.m_evicted;
+	for (bundleProtocol::IntPerPolicy::iterator iter = gatherer.m_evictedPerPolicy.begin(); iter != gatherer.m_evictedPerPolicy.end(); ++iter)
+		std::cout << " " << bundleProtocol::GetEvictionPolicyName(iter->first) << ":" << iter->second;
+	std::cout << "\n";
 	Ptr<DataOutputInterface> output = 0;
 	output = CreateObject<OmnetDataOutput> ();
 	output->Output(data);
@@ -316,7 +344,7 @@ void Experiment::createMobility() {
 	mh.Install(nodes_);
 	*/
 
-	Ns2MobilityHelper ns2 = Ns2MobilityHelper(filename);
+	Ns2MobilityCacheHelper ns2 = Ns2MobilityCacheHelper(filename);
 	ns2.Install();
 
 	/*
@@ -364,7 +392,11 @@ void Experiment::installApplications() {
 
 	BundleProtocolHelper bphelper;
 	std::string brouter = "ns3::bundleProtocol::" + protocol_;
+	// ORWAR needs its own link manager for the contact setup
+	if (protocol_ == "OrwarRouterChangedOrder")
+		bphelper.SetLinkManager("ns3::bundleProtocol::OrwarLinkManager");
 	bphelper.SetBundleRouter(brouter,"BufferSize",UintegerValue(len_buff_ * 512));
+	bphelper.SetMobilityTrace(_mobs);
 	bphelper.Install(nodes_,num_nodes_);
 	//bphelper.Start();
 
@@ -0,0 +1,285 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Measures the contact detection latency against the hello overhead for a
+ * range of fixed hello intervalls, and for the adaptive hello.
+ *
+ * A contact starts when two nodes come within the transmission range, the
+ * positions are sampled every --step seconds. It is detected when the
+ * NewNeighbour trace of the node fires for the other node, the latency is
+ * the time in between. Contacts that end before they are detected are
+ * counted as missed. The overhead is the number of hellos and bytes given
+ * by the SentHelloBytes trace.
+ *
+ * Each intervall runs in a process of its own, so no state is shared
+ * between the runs.
+ *
+ * User Arguments:
+ --his: Hello intervalls in seconds, comma separated
+ --ah: Add a run with AdaptiveHello
+ --pt: BundleRouter protocol, it must send hellos without bundles
+ --st, --ss, --ce, --nn: As in dtn-test
+ --step: Seconds between the samples of the positions
+ --out: The table, one line per run
+ *
+ * ./waf --run "dtn-hello-sweep --his=0.1,0.3,0.8,1.5,3 --ah=1 --st=600"
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/packet-socket-address.h"
+#include "ns3/bundle-protocol-helper.h"
+#include "ns3/ns2-mobility-cache-helper.h"
+
+NS_LOG_COMPONENT_DEFINE("DtnHelloSweep");
+
+using namespace ns3;
+string _mobs;
+
+/* One line of the table */
+struct HelloResult {
+	double hello_intervall;
+	bool adaptive;
+	uint64_t hellos;
+	uint64_t bytes;
+	uint64_t contacts;
+	uint64_t detected;
+	uint64_t missed;
+	double latency_sum;
+	double latency_max;
+};
+
+/* State of one run, each run is a process of its own */
+static NodeContainer nodes_;
+static std::map<Mac48Address, uint32_t> node_by_mac_;
+static std::vector<double> contact_start_;
+static std::vector<char> contact_detected_;
+static double range_;
+static double step_;
+static HelloResult result_;
+
+static std::vector<std::string> split(const std::string &list) {
+	std::vector<std::string> result;
+	std::istringstream iss(list);
+	std::string item;
+	while (std::getline(iss, item, ',')) {
+		if (!item.empty())
+			result.push_back(item);
+	}
+	return result;
+}
+
+/* "/NodeList/<id>/..." */
+static uint32_t nodeFromContext(const std::string &context) {
+	return atoi(context.c_str() + std::string("/NodeList/").size());
+}
+
+static void sentHello(uint32_t bytes) {
+	result_.hellos++;
+	result_.bytes += bytes;
+}
+
+static void newNeighbour(std::string context, const Address &from) {
+	Mac48Address mac = Mac48Address::ConvertFrom(PacketSocketAddress::ConvertFrom(from).GetPhysicalAddress());
+	std::map<Mac48Address, uint32_t>::iterator iter = node_by_mac_.find(mac);
+	if (iter == node_by_mac_.end())
+		return;
+	uint32_t pair = nodeFromContext(context) * nodes_.GetN() + iter->second;
+	// Hellos heard beyond the range, through fading, are no contacts
+	if (contact_start_[pair] < 0 || contact_detected_[pair])
+		return;
+	double latency = Simulator::Now().GetSeconds() - contact_start_[pair];
+	contact_detected_[pair] = 1;
+	result_.detected++;
+	result_.latency_sum += latency;
+	if (latency > result_.latency_max)
+		result_.latency_max = latency;
+}
+
+static void sampleContacts() {
+	uint32_t n = nodes_.GetN();
+	double now = Simulator::Now().GetSeconds();
+	for (uint32_t i = 0; i < n; i++) {
+		Vector a = nodes_.Get(i)->GetObject<MobilityModel> ()->GetPosition();
+		for (uint32_t j = 0; j < n; j++) {
+			if (i == j)
+				continue;
+			Vector b = nodes_.Get(j)->GetObject<MobilityModel> ()->GetPosition();
+			bool in_range = CalculateDistance(a, b) <= range_;
+			uint32_t pair = i * n + j;
+			if (in_range && contact_start_[pair] < 0) {
+				contact_start_[pair] = now;
+				contact_detected_[pair] = 0;
+				result_.contacts++;
+			} else if (!in_range && contact_start_[pair] >= 0) {
+				if (!contact_detected_[pair])
+					result_.missed++;
+				contact_start_[pair] = -1;
+			}
+		}
+	}
+	Simulator::Schedule(Seconds(step_), &sampleContacts);
+}
+
+static void createDevices(NetDeviceContainer &devices) {
+	// The same radio as dtn-test
+	YansWifiChannelHelper chn;
+	chn.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+	chn.AddPropagationLoss("ns3::FriisPropagationLossModel");
+	chn.AddPropagationLoss("ns3::NakagamiPropagationLossModel");
+	YansWifiPhyHelper phy = YansWifiPhyHelper::Default();
+	phy.Set("TxPowerStart", DoubleValue(16.0));
+	phy.Set("TxPowerEnd", DoubleValue(16.0));
+	phy.Set("TxPowerLevels", UintegerValue(1));
+	double threshold = -79.0779;
+	phy.Set("EnergyDetectionThreshold", DoubleValue(threshold));
+	phy.Set("CcaMode1Threshold", DoubleValue(threshold + 3.0));
+	phy.Set("RxNoiseFigure", DoubleValue(4.0));
+	phy.SetChannel(chn.Create());
+	NqosWifiMacHelper mac = NqosWifiMacHelper::Default();
+	mac.SetType("ns3::AdhocWifiMac");
+	WifiHelper wifi = WifiHelper::Default();
+	wifi.SetStandard(WIFI_PHY_STANDARD_80211p_CCH);
+	wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager");
+	devices = wifi.Install(phy, mac, nodes_);
+}
+
+static void runOne(double hello_intervall, bool adaptive, const std::string &protocol,
+		const std::string &cenario, int num_nodes, double simulation_time) {
+	result_.hello_intervall = hello_intervall;
+	result_.adaptive = adaptive;
+
+	nodes_.Create(num_nodes);
+	_mobs = "./examples/mobility/" + cenario;
+	Ns2MobilityCacheHelper ns2(_mobs);
+	ns2.Install();
+	NetDeviceContainer devices;
+	createDevices(devices);
+
+	BundleProtocolHelper bphelper;
+	if (protocol == "OrwarRouterChangedOrder")
+		bphelper.SetLinkManager("ns3::bundleProtocol::OrwarLinkManager");
+	bphelper.SetNeighbourhoodDetectionAgent("ns3::bundleProtocol::NeighbourhoodDetectionAgent",
+			"HelloIntervall", TimeValue(Seconds(hello_intervall)), "AdaptiveHello", BooleanValue(adaptive));
+	bphelper.SetBundleRouter("ns3::bundleProtocol::" + protocol);
+	bphelper.SetMobilityTrace(_mobs);
+	bphelper.Install(nodes_, num_nodes);
+
+	for (uint32_t i = 0; i < devices.GetN(); i++)
+		node_by_mac_[Mac48Address::ConvertFrom(devices.Get(i)->GetAddress())] = i;
+	range_ = nodes_.Get(0)->GetObject<bundleProtocol::BundleProtocolAgent> ()->GetConvergenceLayerAgent()->GetTransmissionRange();
+	contact_start_.assign(num_nodes * num_nodes, -1);
+	contact_detected_.assign(num_nodes * num_nodes, 0);
+
+	Config::ConnectWithoutContext("/NodeList/*/$ns3::bundleProtocol::NeighbourhoodDetectionAgent/SentHelloBytes",
+			MakeCallback(&sentHello));
+	Config::Connect("/NodeList/*/$ns3::bundleProtocol::NeighbourhoodDetectionAgent/NewNeighbour",
+			MakeCallback(&newNeighbour));
+	Simulator::ScheduleNow(&sampleContacts);
+
+	Simulator::Stop(Seconds(simulation_time));
+	Simulator::Run();
+	Simulator::Destroy();
+}
+
+/* Main Program */
+int main(int argc, char **argv) {
+	std::string his = "0.1,0.3,0.8,1.5,3";
+	bool adaptive = true;
+	std::string protocol = "RTEpidemic";
+	double simulation_time = 1000.0;
+	double simulation_seed = 1978.0;
+	std::string cenario = "s2.tcl";
+	int num_nodes = 9;
+	std::string out = "hello-sweep.txt";
+	step_ = 0.05;
+
+	CommandLine cmd;
+	cmd.AddValue("his", "Hello intervalls in seconds, comma separated", his);
+	cmd.AddValue("ah", "Add a run with AdaptiveHello", adaptive);
+	cmd.AddValue("pt", "BundleRoter Protocol", protocol);
+	cmd.AddValue("st", "Simulation Time", simulation_time);
+	cmd.AddValue("ss", "Simulation Seed", simulation_seed);
+	cmd.AddValue("ce", "Tcl of cenario", cenario);
+	cmd.AddValue("nn", "Number of Nodes", num_nodes);
+	cmd.AddValue("step", "Seconds between the samples of the positions", step_);
+	cmd.AddValue("out", "The table, one line per run", out);
+	cmd.Parse(argc, argv);
+
+	std::vector<std::string> intervalls = split(his);
+	std::vector<std::pair<double, bool> > runs;
+	for (unsigned int i = 0; i < intervalls.size(); i++)
+		runs.push_back(std::make_pair(atof(intervalls[i].c_str()), false));
+	// The adaptive run starts from the attribute default
+	if (adaptive)
+		runs.push_back(std::make_pair(0.8, true));
+
+	std::ofstream table(out.c_str());
+	table << "hi\tah\thellos\thello_bytes\tbytes_per_node_s\tcontacts\tdetected\tmissed\tlatency_mean\tlatency_max\n";
+	for (unsigned int r = 0; r < runs.size(); r++) {
+		int fds[2];
+		if (pipe(fds) != 0) {
+			std::cerr << "dtn-hello-sweep: no pipe\n";
+			return 1;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			// Worker, the result goes back through the pipe
+			close(fds[0]);
+			SeedManager::SetSeed(simulation_seed);
+			runOne(runs[r].first, runs[r].second, protocol, cenario, num_nodes, simulation_time);
+			ssize_t written = write(fds[1], &result_, sizeof(result_));
+			_exit(written == sizeof(result_) ? 0 : 1);
+		}
+		close(fds[1]);
+		HelloResult result;
+		bool ok = pid > 0 && read(fds[0], &result, sizeof(result)) == sizeof(result);
+		close(fds[0]);
+		int status;
+		if (pid > 0)
+			waitpid(pid, &status, 0);
+		if (!ok) {
+			std::cerr << "dtn-hello-sweep: run " << runs[r].first << (runs[r].second ? " adaptive" : "") << " failed\n";
+			continue;
+		}
+
+		double latency = result.detected > 0 ? result.latency_sum / result.detected : 0;
+		double rate = result.bytes / (num_nodes * simulation_time);
+		table << result.hello_intervall << "\t" << result.adaptive << "\t" << result.hellos
+				<< "\t" << result.bytes << "\t" << rate << "\t" << result.contacts
+				<< "\t" << result.detected << "\t" << result.missed << "\t" << latency
+				<< "\t" << result.latency_max << "\n";
+		std::cout << "hi " << result.hello_intervall << (result.adaptive ? " adaptive" : "")
+				<< ": " << rate << " hello bytes per node per s, latency " << latency
+				<< " s mean, " << result.missed << " of " << result.contacts << " contacts missed\n";
+	}
+	table.close();
+
+	std::cout << "dtn-hello-sweep: wrote " << out << "\n";
+	return 0;
+}
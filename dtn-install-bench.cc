@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Times the startup of a large scenario: the wifi devices, and the bundle
+ * protocol stack installed with one Install per node against one Install
+ * for the whole container.
+ *
+ * The nodes stand on a grid and the mobility table is built in memory, all
+ * nodes active from 0 s, so no trace is read. Each way of installing runs
+ * in a process of its own, Simulator::Destroy is timed apart.
+ *
+ * User Arguments:
+ --nn: Nodes
+ --pt: BundleRouter protocol
+ --ss: Seed
+ *
+ * ./waf --run "dtn-install-bench --nn=10000 --pt=RTTrendOfDelivery"
+ */
+
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/bundle-protocol-helper.h"
+#include "ns3/bp-node-activity.h"
+
+NS_LOG_COMPONENT_DEFINE("DtnInstallBench");
+
+using namespace ns3;
+string _mobs;
+
+/* Wall times of one run, in seconds */
+struct InstallTimes {
+	double devices;
+	double install;
+	double destroy;
+};
+
+static double now() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void createDevices(NodeContainer &nodes) {
+	// The same radio as dtn-test
+	YansWifiChannelHelper chn;
+	chn.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+	chn.AddPropagationLoss("ns3::FriisPropagationLossModel");
+	YansWifiPhyHelper phy = YansWifiPhyHelper::Default();
+	phy.Set("TxPowerStart", DoubleValue(16.0));
+	phy.Set("TxPowerEnd", DoubleValue(16.0));
+	phy.Set("TxPowerLevels", UintegerValue(1));
+	phy.SetChannel(chn.Create());
+	NqosWifiMacHelper mac = NqosWifiMacHelper::Default();
+	mac.SetType("ns3::AdhocWifiMac");
+	WifiHelper wifi = WifiHelper::Default();
+	wifi.SetStandard(WIFI_PHY_STANDARD_80211p_CCH);
+	wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager");
+	wifi.Install(phy, mac, nodes);
+
+	MobilityHelper mobility;
+	mobility.SetPositionAllocator("ns3::GridPositionAllocator", "DeltaX", DoubleValue(100.0),
+			"DeltaY", DoubleValue(100.0), "GridWidth", UintegerValue(100));
+	mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+	mobility.Install(nodes);
+}
+
+static InstallTimes runOne(bool bulk, const std::string &protocol, int num_nodes) {
+	InstallTimes times;
+	NodeContainer nodes;
+	nodes.Create(num_nodes);
+
+	double start = now();
+	createDevices(nodes);
+	times.devices = now() - start;
+
+	Ptr<bundleProtocol::NodeActivity> activity = Create<bundleProtocol::NodeActivity> ();
+	for (int i = 0; i < num_nodes; i++) {
+		activity->SetStartTime(i, 0.0);
+		activity->SetEndTime(i, 1000.0);
+	}
+	_mobs = "install-bench";
+	bundleProtocol::NodeActivity::Add(_mobs, activity);
+
+	BundleProtocolHelper bphelper;
+	if (protocol == "OrwarRouterChangedOrder")
+		bphelper.SetLinkManager("ns3::bundleProtocol::OrwarLinkManager");
+	bphelper.SetBundleRouter("ns3::bundleProtocol::" + protocol);
+	bphelper.SetMobilityTrace(_mobs);
+
+	start = now();
+	if (bulk) {
+		bphelper.Install(nodes, num_nodes);
+	} else {
+		for (int i = 0; i < num_nodes; i++)
+			bphelper.Install(nodes.Get(i), num_nodes);
+	}
+	times.install = now() - start;
+
+	start = now();
+	Simulator::Destroy();
+	times.destroy = now() - start;
+	return times;
+}
+
+/* Main Program */
+int main(int argc, char **argv) {
+	int num_nodes = 10000;
+	std::string protocol = "RTTrendOfDelivery";
+	double simulation_seed = 1978.0;
+
+	CommandLine cmd;
+	cmd.AddValue("nn", "Number of Nodes", num_nodes);
+	cmd.AddValue("pt", "BundleRoter Protocol", protocol);
+	cmd.AddValue("ss", "Simulation Seed", simulation_seed);
+	cmd.Parse(argc, argv);
+
+	const char *names[] = { "per node", "bulk" };
+	for (int bulk = 0; bulk < 2; bulk++) {
+		int fds[2];
+		if (pipe(fds) != 0) {
+			std::cerr << "dtn-install-bench: no pipe\n";
+			return 1;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			// Worker, the times go back through the pipe
+			close(fds[0]);
+			SeedManager::SetSeed(simulation_seed);
+			InstallTimes times = runOne(bulk == 1, protocol, num_nodes);
+			ssize_t written = write(fds[1], &times, sizeof(times));
+			_exit(written == sizeof(times) ? 0 : 1);
+		}
+		close(fds[1]);
+		InstallTimes times;
+		bool ok = pid > 0 && read(fds[0], &times, sizeof(times)) == sizeof(times);
+		close(fds[0]);
+		int status;
+		if (pid > 0)
+			waitpid(pid, &status, 0);
+		if (!ok) {
+			std::cerr << "dtn-install-bench: " << names[bulk] << " run failed\n";
+			return 1;
+		}
+
+		std::cout << names[bulk] << ": " << num_nodes << " nodes, devices " << times.devices
+				<< " s, install " << times.install << " s (" << times.install * 1e6 / num_nodes
+				<< " us per node), destroy " << times.destroy << " s\n";
+	}
+	return 0;
+}
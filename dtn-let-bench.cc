@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Times LinkLifeTime::getExpirationTime, one neighbour at a time, against
+ * LinkLifeTime::getLinkLifeTimes, all neighbours at once, on random
+ * neighbours around a node, and checks that both give the same lifetimes.
+ *
+ * User Arguments:
+ --nn: Neighbours
+ --rep: Times each version runs over all neighbours
+ --tr: Transmission range
+ --ss: Seed
+ *
+ * ./waf --run "dtn-let-bench --nn=1000 --rep=10000"
+ *
+ * The batch loop is only vectorized with -O3 -fno-math-errno -fno-trapping-math
+ * (CXXFLAGS when configuring waf), otherwise it runs branch free but scalar.
+ */
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <sys/time.h>
+#include "ns3/core-module.h"
+#include "ns3/vector2d.h"
+#include "ns3/link-life-time.h"
+
+NS_LOG_COMPONENT_DEFINE("DtnLetBench");
+
+using namespace ns3;
+
+static double now() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Main Program */
+int main(int argc, char **argv) {
+	uint32_t num_neighbours = 1000;
+	uint32_t repetitions = 10000;
+	double transmission_range = 350.0;
+	uint32_t seed = 1978;
+
+	CommandLine cmd;
+	cmd.AddValue("nn", "Neighbours", num_neighbours);
+	cmd.AddValue("rep", "Times each version runs over all neighbours", repetitions);
+	cmd.AddValue("tr", "Transmission range", transmission_range);
+	cmd.AddValue("ss", "Seed", seed);
+	cmd.Parse(argc, argv);
+
+	SeedManager::SetSeed(seed);
+	UniformVariable position(-transmission_range, transmission_range);
+	UniformVariable velocity(-30.0, 30.0);
+	UniformVariable stopped(0.0, 1.0);
+
+	Vector2d my_pos(0.0, 0.0), my_vel(10.0, 0.0);
+	std::vector<double> pos_x(num_neighbours), pos_y(num_neighbours);
+	std::vector<double> vel_x(num_neighbours), vel_y(num_neighbours);
+	for (uint32_t i = 0; i < num_neighbours; i++) {
+		pos_x[i] = position.GetValue();
+		pos_y[i] = position.GetValue();
+		// Some neighbours stand still or move along with the node
+		double s = stopped.GetValue();
+		vel_x[i] = s < 0.1 ? 0.0 : (s < 0.2 ? my_vel.x : velocity.GetValue());
+		vel_y[i] = s < 0.1 ? 0.0 : (s < 0.2 ? my_vel.y : velocity.GetValue());
+	}
+
+	std::vector<double> scalar(num_neighbours), batch(num_neighbours);
+	double checksum = 0;
+
+	double start = now();
+	for (uint32_t r = 0; r < repetitions; r++) {
+		for (uint32_t i = 0; i < num_neighbours; i++) {
+			scalar[i] = LinkLifeTime::getExpirationTime(my_pos, my_vel,
+					Vector2d(pos_x[i], pos_y[i]), Vector2d(vel_x[i], vel_y[i]),
+					transmission_range).GetSeconds();
+		}
+		checksum += scalar[r % num_neighbours];
+	}
+	double scalar_time = now() - start;
+
+	start = now();
+	for (uint32_t r = 0; r < repetitions; r++) {
+		LinkLifeTime::getLinkLifeTimes(my_pos.x, my_pos.y, my_vel.x, my_vel.y,
+				&pos_x[0], &pos_y[0], &vel_x[0], &vel_y[0], num_neighbours,
+				transmission_range, &batch[0]);
+		checksum += batch[r % num_neighbours];
+	}
+	double batch_time = now() - start;
+
+	// The scalar version goes through Time, which keeps nanoseconds
+	uint32_t mismatches = 0;
+	double max_error = 0;
+	for (uint32_t i = 0; i < num_neighbours; i++) {
+		double error = std::fabs(scalar[i] - batch[i]);
+		max_error = std::max(max_error, error);
+		if (error > 1e-6)
+			mismatches++;
+	}
+
+	double pairs = (double) num_neighbours * repetitions;
+	std::cout << "neighbours " << num_neighbours << " repetitions " << repetitions << "\n";
+	std::cout << "scalar " << scalar_time * 1e9 / pairs << " ns per neighbour\n";
+	std::cout << "batch  " << batch_time * 1e9 / pairs << " ns per neighbour\n";
+	std::cout << "speedup " << scalar_time / batch_time << "\n";
+	std::cout << "max error " << max_error << " s, " << mismatches << " mismatches"
+			<< " (checksum " << checksum << ")\n";
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,317 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*
+ * Runs dtn-buff for every combination of routers, buffer sizes and seeds,
+ * a number of runs at a time, and merges the results into one table.
+ *
+ * Each run is a separate process in its own directory under --dir, as the
+ * routers write their counters to files in the working directory. The
+ * mobility trace is converted to its binary cache before the runs start,
+ * so the runs only read the cache.
+ *
+ * User Arguments:
+ --bin: The dtn-buff program
+ --pts: Routers, comma separated
+ --buffs: Buffer sizes in bundles, comma separated
+ --seeds: Seeds, comma separated
+ --jobs: Runs at a time, the number of cores by default
+ --ips: 0 without and 1 with the IP stack, comma separated, "0,1" compares both
+ --st, --ce, --tr, --nn: Passed on to every run
+ --dir: Where the runs are made
+ --out: The merged table
+ *
+ * ./waf --run "dtn-sweep --bin=build/debug/scratch/dtn-buff --pts=RTEpidemic,RTProphet --buffs=10,50 --seeds=1,2,3"
+ *
+ * The table also holds the events and the wall time of Simulator::Run that
+ * each run prints, so "--ips=0,1" gives the saving of leaving IP out.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <ctime>
+#include "ns3/core-module.h"
+#include "ns3/ns2-mobility-cache-helper.h"
+
+NS_LOG_COMPONENT_DEFINE("DtnSweep");
+
+using namespace ns3;
+
+/* One combination of the matrix */
+struct Run {
+	std::string protocol;
+	int buff;
+	int seed;
+	bool ip;
+	std::string dir;
+	int status;
+};
+
+/* What the routers leave in the working directory at the end of a run */
+struct Result {
+	double delivered;
+	double delay_sum;
+	int delay_n;
+	double copies;
+	double custody_transfers;
+	double efficiency;
+	double overflows;
+	double expired;
+	double events;
+	double wall;
+};
+
+static std::vector<std::string> split(const std::string &list) {
+	std::vector<std::string> result;
+	std::istringstream iss(list);
+	std::string item;
+	while (std::getline(iss, item, ',')) {
+		if (!item.empty())
+			result.push_back(item);
+	}
+	return result;
+}
+
+static std::string absolute(const std::string &path) {
+	char resolved[PATH_MAX];
+	if (realpath(path.c_str(), resolved) == 0)
+		return path;
+	return resolved;
+}
+
+/* The counter files hold the last value written, the delay file one line per bundle */
+static double readLast(const std::string &file) {
+	std::ifstream in(file.c_str());
+	double value = 0, tmp;
+	while (in >> tmp)
+		value = tmp;
+	return value;
+}
+
+static Result readResult(const Run &run) {
+	std::string base = run.dir + "/" + run.protocol;
+	// SetBundleReceived appends its suffixes to "<Router>.out", the buffer counters do not
+	std::string received = base + ".out";
+	Result result;
+	result.delivered = readLast(received);
+	result.delay_sum = 0;
+	result.delay_n = 0;
+	std::ifstream delays((received + ".t").c_str());
+	double delay;
+	while (delays >> delay) {
+		result.delay_sum += delay;
+		result.delay_n++;
+	}
+	result.copies = readLast(received + ".r");
+	result.custody_transfers = readLast(received + ".tr");
+	result.efficiency = readLast(received + ".efi2");
+	result.overflows = readLast(base + ".buff");
+	result.expired = readLast(base + ".expired");
+	// "Simulation ran <events> events in <wall> s ..."
+	result.events = -1;
+	result.wall = -1;
+	std::ifstream log((run.dir + "/log.txt").c_str());
+	std::string line;
+	while (std::getline(log, line)) {
+		std::istringstream iss(line);
+		std::string simulation, ran, events, in;
+		double n, wall;
+		if (iss >> simulation >> ran >> n >> events >> in >> wall && simulation == "Simulation" && ran == "ran") {
+			result.events = n;
+			result.wall = wall;
+		}
+	}
+	return result;
+}
+
+static pid_t startRun(const Run &run, const std::string &bin,
+		const std::string &examples, const std::vector<std::string> &common) {
+	mkdir(run.dir.c_str(), 0755);
+	// The runs open ./examples/mobility/<ce> and <tr>
+	std::string link = run.dir + "/examples";
+	unlink(link.c_str());
+	if (symlink(examples.c_str(), link.c_str()) != 0) {
+		std::cerr << "dtn-sweep: could not link " << link << "\n";
+		return -1;
+	}
+
+	std::vector<std::string> args;
+	args.push_back(bin);
+	std::ostringstream pt, buff, ss;
+	pt << "--pt=" << run.protocol;
+	buff << "--buff=" << run.buff;
+	ss << "--ss=" << run.seed;
+	args.push_back(pt.str());
+	args.push_back(buff.str());
+	args.push_back(ss.str());
+	if (run.ip)
+		args.push_back("--ip=1");
+	args.insert(args.end(), common.begin(), common.end());
+
+	pid_t pid = fork();
+	if (pid != 0)
+		return pid;
+
+	// Worker
+	if (chdir(run.dir.c_str()) != 0)
+		_exit(127);
+	int log = open("log.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (log >= 0) {
+		dup2(log, 1);
+		dup2(log, 2);
+		close(log);
+	}
+	std::vector<char *> argv;
+	for (unsigned int i = 0; i < args.size(); i++)
+		argv.push_back(const_cast<char *> (args[i].c_str()));
+	argv.push_back(0);
+	execv(bin.c_str(), &argv[0]);
+	_exit(127);
+}
+
+/* Main Program */
+int main(int argc, char **argv) {
+	std::string bin = "./dtn-buff";
+	std::string pts = "RTEpidemic";
+	std::string buffs = "0";
+	std::string seeds = "1978";
+	int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	double simulation_time = 1000.0;
+	std::string cenario = "s2.tcl";
+	std::string traffic = "traffic_04";
+	int num_nodes = 9;
+	std::string ips = "0";
+	std::string dir = "sweep";
+	std::string out = "sweep.txt";
+
+	CommandLine cmd;
+	cmd.AddValue("bin", "The dtn-buff program", bin);
+	cmd.AddValue("pts", "Routers, comma separated", pts);
+	cmd.AddValue("buffs", "Buffer sizes in bundles, comma separated", buffs);
+	cmd.AddValue("seeds", "Seeds, comma separated", seeds);
+	cmd.AddValue("jobs", "Runs at a time", jobs);
+	cmd.AddValue("st", "Simulation Time", simulation_time);
+	cmd.AddValue("ce", "Tcl of cenario", cenario);
+	cmd.AddValue("tr", "Traffic of cenario", traffic);
+	cmd.AddValue("nn", "Number of Nodes", num_nodes);
+	cmd.AddValue("ips", "0 without and 1 with the IP stack, comma separated", ips);
+	cmd.AddValue("dir", "Where the runs are made", dir);
+	cmd.AddValue("out", "The merged table", out);
+	cmd.Parse(argc, argv);
+
+	if (jobs < 1)
+		jobs = 1;
+	bin = absolute(bin);
+	std::string examples = absolute("./examples");
+
+	// Converted once here, the runs then only read the binary cache
+	Ns2MobilityCacheHelper mobility(examples + "/mobility/" + cenario);
+
+	std::vector<std::string> common;
+	std::ostringstream st, ce, tr, nn;
+	st << "--st=" << simulation_time;
+	ce << "--ce=" << cenario;
+	tr << "--tr=" << traffic;
+	nn << "--nn=" << num_nodes;
+	common.push_back(st.str());
+	common.push_back(ce.str());
+	common.push_back(tr.str());
+	common.push_back(nn.str());
+
+	std::vector<Run> runs;
+	std::vector<std::string> protocols = split(pts);
+	std::vector<std::string> buffers = split(buffs);
+	std::vector<std::string> seedList = split(seeds);
+	std::vector<std::string> ipList = split(ips);
+	for (unsigned int p = 0; p < protocols.size(); p++) {
+		for (unsigned int b = 0; b < buffers.size(); b++) {
+			for (unsigned int s = 0; s < seedList.size(); s++) {
+				for (unsigned int i = 0; i < ipList.size(); i++) {
+					Run run;
+					run.protocol = protocols[p];
+					run.buff = atoi(buffers[b].c_str());
+					run.seed = atoi(seedList[s].c_str());
+					run.ip = atoi(ipList[i].c_str()) != 0;
+					std::ostringstream name;
+					name << dir << "/" << run.protocol << "-b" << run.buff << "-s" << run.seed << (run.ip ? "-ip" : "");
+					run.dir = name.str();
+					run.status = -1;
+					runs.push_back(run);
+				}
+			}
+		}
+	}
+
+	mkdir(dir.c_str(), 0755);
+	std::cout << "dtn-sweep: " << runs.size() << " runs, " << jobs << " at a time\n";
+	time_t start = time(0);
+
+	std::vector<pid_t> pids(runs.size(), -1);
+	unsigned int next = 0;
+	int running = 0;
+	while (next < runs.size() || running > 0) {
+		if (next < runs.size() && running < jobs) {
+			pids[next] = startRun(runs[next], bin, examples, common);
+			if (pids[next] > 0)
+				running++;
+			next++;
+			continue;
+		}
+		int status;
+		pid_t pid = wait(&status);
+		if (pid < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		running--;
+		for (unsigned int i = 0; i < runs.size(); i++) {
+			if (pids[i] == pid) {
+				runs[i].status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+				std::cout << "dtn-sweep: " << runs[i].dir << " exit " << runs[i].status << "\n";
+			}
+		}
+	}
+
+	std::ofstream table(out.c_str());
+	table << "pt\tbuff\tss\tip\tstatus\tdelivered\tdelay_mean\tcopies\tcustody_transfers\tefficiency\toverflows\texpired\tevents\twall_s\n";
+	for (unsigned int i = 0; i < runs.size(); i++) {
+		Result result = readResult(runs[i]);
+		double delay = result.delay_n > 0 ? result.delay_sum / result.delay_n : 0;
+		table << runs[i].protocol << "\t" << runs[i].buff << "\t" << runs[i].seed
+				<< "\t" << runs[i].ip << "\t" << runs[i].status << "\t" << result.delivered
+				<< "\t" << delay << "\t" << result.copies
+				<< "\t" << result.custody_transfers << "\t" << result.efficiency
+				<< "\t" << result.overflows << "\t" << result.expired
+				<< "\t" << result.events << "\t" << result.wall << "\n";
+	}
+	table.close();
+
+	std::cout << "dtn-sweep: wrote " << out << " after " << difftime(time(0), start) << " s\n";
+	return 0;
+}
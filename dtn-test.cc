@@ -30,6 +30,7 @@
  */
 
 #include <iostream>
+#include <sys/time.h>
 #include "ns3/aodv-module.h"
 #include "ns3/core-module.h"
 #include "ns3/mobility-module.h"
@@ -48,6 +49,8 @@
 #include "ns3/nstime.h"
 #include "ns3/bundle-protocol-helper.h"
 #include "ns3/one-traffic-helper.h"
+#include "ns3/ns2-mobility-cache-helper.h"
+#include "ns3/event-counting-scheduler.h"
 
 NS_LOG_COMPONENT_DEFINE("AODVTest");
 
@@ -102,6 +105,12 @@ private:
 	std::string cenario_;
 	std::string traffic_;
 	int num_nodes_;
+	bool contact_window_;
+	bool reactive_fragmentation_;
+	bool proactive_fragmentation_;
+	bool adaptive_hello_;
+	bool piggyback_;
+	bool ip_stack_;
 	void createNodes();
 	void createDevices();
 	void createDevices80211p();
@@ -122,6 +131,12 @@ Experiment::Experiment() {
 	cenario_ = "s2.tcl";
 	traffic_ = "traffic_04";
 	num_nodes_ = 9;
+	contact_window_ = false;
+	reactive_fragmentation_ = false;
+	proactive_fragmentation_ = false;
+	adaptive_hello_ = false;
+	piggyback_ = false;
+	ip_stack_ = false;
 }
 
 void Experiment::configure(int argc, char **argv) {
@@ -133,6 +148,12 @@ void Experiment::configure(int argc, char **argv) {
 	cmd.AddValue("ce", "Tcl of cenario",cenario_);
 	cmd.AddValue("tr", "Traffic of cenario",traffic_);
 	cmd.AddValue("nn", "Number of Nodes",num_nodes_);
+	cmd.AddValue("cw", "Skip bundles that do not fit the estimated contact window",contact_window_);
+	cmd.AddValue("rf", "Keep partially received bundles as fragments",reactive_fragmentation_);
+	cmd.AddValue("pf", "Split bundles into fragments sized to the contact window (needs cw)",proactive_fragmentation_);
+	cmd.AddValue("ah", "Adapt the hello intervall to the neighbour churn, speed and channel load",adaptive_hello_);
+	cmd.AddValue("pb", "Piggyback neighbour liveness on segments and leave out hellos while data flows",piggyback_);
+	cmd.AddValue("ip", "Install IPv4 with AODV, the DTN stack runs on packet sockets and does not need it",ip_stack_);
 	cmd.Parse(argc, argv);
 
 	std::cout<<"st:"<<simulation_time_<<" ss:"<<simulation_seed_<<" pt:"<<protocol_<<" ce:"<<cenario_<<" tr:"<<traffic_<<" nn:"<<num_nodes_<<"\n";
@@ -140,17 +161,30 @@ void Experiment::configure(int argc, char **argv) {
 }
 
 void Experiment::run() {
+	// Counts the events, the order of the events is the one of the default scheduler
+	ObjectFactory scheduler;
+	scheduler.SetTypeId("ns3::EventCountingScheduler");
+	Simulator::SetScheduler(scheduler);
 	createNodes();
 	createMobility();
 	createDevices();
 	//createDevices80211p();
-	installInternetStack();
+	// AODV hellos and routing cost events and airtime the DTN stack does not use
+	if (ip_stack_)
+		installInternetStack();
 	installApplications();
 	//createTraffic();
 	//createStats();
 	Simulator::Stop(Seconds(simulation_time_));
+	struct timeval start, end;
+	gettimeofday(&start, 0);
 	Simulator::Run();
+	gettimeofday(&end, 0);
+	// Read before Destroy, which empties the queue
+	uint64_t events = EventCountingScheduler::GetNExecuted();
 	Simulator::Destroy();
+	double wall = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+	std::cout << "Simulation ran " << events << " events in " << wall << " s" << (ip_stack_ ? " with" : " without") << " IP\n";
 	Ptr<DataOutputInterface> output = 0;
 	output = CreateObject<OmnetDataOutput> ();
 	output->Output(data);
@@ -313,7 +347,7 @@ void Experiment::createMobility() {
 	mh.Install(nodes_);
 	*/
 
-	Ns2MobilityHelper ns2 = Ns2MobilityHelper(filename);
+	Ns2MobilityCacheHelper ns2 = Ns2MobilityCacheHelper(filename);
 	ns2.Install();
 
 	/*
@@ -361,7 +395,13 @@ void Experiment::installApplications() {
 
 	BundleProtocolHelper bphelper;
 	std::string brouter = "ns3::bundleProtocol::" + protocol_;
-	bphelper.SetBundleRouter(brouter);
+	// ORWAR needs its own link manager for the contact setup
+	if (protocol_ == "OrwarRouterChangedOrder")
+		bphelper.SetLinkManager("ns3::bundleProtocol::OrwarLinkManager");
+	bphelper.SetConvergenceLayer("ns3::bundleProtocol::ConvergenceLayerAgent","ReactiveFragmentation",BooleanValue(reactive_fragmentation_),"PiggybackNeighbourInfo",BooleanValue(piggyback_));
+	bphelper.SetNeighbourhoodDetectionAgent("ns3::bundleProtocol::NeighbourhoodDetectionAgent","AdaptiveHello",BooleanValue(adaptive_hello_));
+	bphelper.SetBundleRouter(brouter,"ContactWindowAware",BooleanValue(contact_window_),"ProactiveFragmentation",BooleanValue(proactive_fragmentation_));
+	bphelper.SetMobilityTrace(_mobs);
 	bphelper.Install(nodes_,num_nodes_);
 	//bphelper.Start();
 
@@ -148,6 +148,11 @@ BundleProtocolHelper::SetBundleProtocolAgent (std::string tid,
   m_bundleProtocolAgentFactory.Set (n7, v7);
 }
 
+void
+BundleProtocolHelper::SetMobilityTrace (std::string filename)
+{
+  m_nodeActivity = NodeActivity::Get (filename);
+}
 
 void
 BundleProtocolHelper::Install (NodeContainer container,int num)
@@ -158,12 +163,27 @@ BundleProtocolHelper::Install (NodeContainer container,int num)
 void
 BundleProtocolHelper::Install (NodeContainer::Iterator begin, NodeContainer::Iterator end,int num)
 {
+  // Checked for every node first, so a missing device does not leave half of the nodes installed
+  NodeContainer withoutSockets;
+  for (NodeContainer::Iterator i = begin; i != end; ++i)
+    {
+      if ((*i)->GetDevice (0) == 0)
+        {
+          NS_FATAL_ERROR ("BundleProtocolHelper::Install (): Needs a net device installed");
+        }
+      if ((*i)->GetObject<PacketSocketFactory> () == 0)
+        {
+          withoutSockets.Add (*i);
+        }
+    }
+  PacketSocketHelper helper = PacketSocketHelper ();
+  helper.Install (withoutSockets);
 
   for (NodeContainer::Iterator i = begin; i != end; ++i)
     {
       Ptr<Node> node = *i;
 	  NS_LOG_DEBUG("--> Node (" << node->GetId() << ")");
-      Install (node,num);
+      InstallStack (node, node->GetDevice (0), num);
     }
 
 }
@@ -184,6 +204,12 @@ BundleProtocolHelper::Install (Ptr<Node> node,int num)
       helper.Install (node);
     }
 
+  InstallStack (node, device, num);
+}
+
+void
+BundleProtocolHelper::InstallStack (Ptr<Node> node, Ptr<NetDevice> device, int num)
+{
   stringstream ss;
   ss << node->GetId ();
   BundleEndpointId eid = BundleEndpointId ("dtn", ss.str ());
@@ -204,6 +230,10 @@ BundleProtocolHelper::Install (Ptr<Node> node,int num)
   br->SetLinkManager (lm);
   br->SetNeighbourhoodDetectionAgent (nda);
   br->SetBundleEndpointId (eid);
+  if (m_nodeActivity != 0)
+    {
+      br->SetNodeActivity (m_nodeActivity);
+    }
 
   bpa = m_bundleProtocolAgentFactory.Create<BundleProtocolAgent> ();
 
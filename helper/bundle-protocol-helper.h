@@ -1 +1 @@
-/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */#ifndef BUNDLE_PROTOCOL_HELPER_H#define BUNDLE_PROTOCOL_HELPER_H#include "ns3/object-factory.h"#include "ns3/node-container.h"#include "ns3/node.h"#include "ns3/bp-convergence-layer-agent.h"#include "ns3/bp-bundle-protocol-agent.h"#include "ns3/bp-neighbourhood-detection-agent.h"#include "ns3/bp-bundle-router.h"#include "ns3/packet-socket-helper.h"#include "ns3/packet-socket-factory.h"//#include "ns3/bp-orwar-router.h"#include "ns3/bp-bundle-endpoint-id.h"#include "ns3/bp-link-manager.h"#include "ns3/bp-registration-factory.h"#include "ns3/wifi-net-device.h"namespace ns3 {class BundleProtocolHelper{ public:  BundleProtocolHelper ();  void SetConvergenceLayer (std::string tid,                            std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                            std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                            std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                            std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                            std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                            std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                            std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                            std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    void SetNeighbourhoodDetectionAgent (std::string tid,                      std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                      std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                      std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                      std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                      std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                      std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                      std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                      std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    void SetLinkManager (std::string tid,                          std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                          std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                          std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                          std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                          std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                          std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                          std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                          std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    void SetBundleRouter (std::string tid,                        std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                        std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                        std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                        std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                        std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                        std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                        std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                        std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());  void SetBundleProtocolAgent (std::string tid,                               std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                               std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                               std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                               std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                               std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                               std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                               std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                               std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    void Install (NodeContainer container,int num);  void Install (NodeContainer::Iterator begin, NodeContainer::Iterator end,int num);  void Install (Ptr<Node> node, int num);  void Start();private:  ObjectFactory m_claFactory;  ObjectFactory m_neighbourhoodDetectionAgentFactory;  ObjectFactory m_linkManagerFactory;  ObjectFactory m_bundleRouterFactory;  ObjectFactory m_bundleProtocolAgentFactory;  /* sergiosvieira */  Ptr<ns3::bundleProtocol::ConvergenceLayerAgent> cla;  Ptr<ns3::bundleProtocol::BundleProtocolAgent> bpa;  Ptr<ns3::bundleProtocol::NeighbourhoodDetectionAgent> nda;  Ptr<ns3::bundleProtocol::BundleRouter> br;  /* sergiosvieira */};} // namespace ns3#endif /* BUNDLE_PROTOCOL_HELPER_H */
\ No newline at end of file
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */#ifndef BUNDLE_PROTOCOL_HELPER_H#define BUNDLE_PROTOCOL_HELPER_H#include "ns3/object-factory.h"#include "ns3/node-container.h"#include "ns3/node.h"#include "ns3/bp-convergence-layer-agent.h"#include "ns3/bp-bundle-protocol-agent.h"#include "ns3/bp-neighbourhood-detection-agent.h"#include "ns3/bp-bundle-router.h"#include "ns3/packet-socket-helper.h"#include "ns3/packet-socket-factory.h"//#include "ns3/bp-orwar-router.h"#include "ns3/bp-bundle-endpoint-id.h"#include "ns3/bp-link-manager.h"#include "ns3/bp-registration-factory.h"#include "ns3/bp-node-activity.h"#include "ns3/wifi-net-device.h"namespace ns3 {class BundleProtocolHelper{ public:  BundleProtocolHelper ();  void SetConvergenceLayer (std::string tid,                            std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                            std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                            std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                            std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                            std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                            std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                            std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                            std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    void SetNeighbourhoodDetectionAgent (std::string tid,                      std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                      std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                      std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                      std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                      std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                      std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                      std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                      std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    void SetLinkManager (std::string tid,                          std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                          std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                          std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                          std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                          std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                          std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                          std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                          std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    void SetBundleRouter (std::string tid,                        std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                        std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                        std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                        std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                        std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                        std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                        std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                        std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());  void SetBundleProtocolAgent (std::string tid,                               std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),                               std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),                               std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),                               std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue (),                               std::string n4 = "", const AttributeValue &v4 = EmptyAttributeValue (),                               std::string n5 = "", const AttributeValue &v5 = EmptyAttributeValue (),                               std::string n6 = "", const AttributeValue &v6 = EmptyAttributeValue (),                               std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue ());    /**   * \brief Reads the start and end times of the nodes from the ns-2 mobility   * trace once, and shares them between all the routers installed after.   */  void SetMobilityTrace (std::string filename);  /**   * \brief Installs the stack on all the nodes at once.   *   * The devices of all the nodes are checked before any object is created,   * and the packet sockets are installed in one go. The objects of each   * node are then created, initialised and started in node order, as with   * one Install per node, so the events of a seed are the same.   */  void Install (NodeContainer container,int num);  void Install (NodeContainer::Iterator begin, NodeContainer::Iterator end,int num);  void Install (Ptr<Node> node, int num);  void Start();private:  void InstallStack (Ptr<Node> node, Ptr<NetDevice> device, int num);  ObjectFactory m_claFactory;  ObjectFactory m_neighbourhoodDetectionAgentFactory;  ObjectFactory m_linkManagerFactory;  ObjectFactory m_bundleRouterFactory;  ObjectFactory m_bundleProtocolAgentFactory;  Ptr<ns3::bundleProtocol::NodeActivity> m_nodeActivity;  /* sergiosvieira */  Ptr<ns3::bundleProtocol::ConvergenceLayerAgent> cla;  Ptr<ns3::bundleProtocol::BundleProtocolAgent> bpa;  Ptr<ns3::bundleProtocol::NeighbourhoodDetectionAgent> nda;  Ptr<ns3::bundleProtocol::BundleRouter> br;  /* sergiosvieira */};} // namespace ns3#endif /* BUNDLE_PROTOCOL_HELPER_H */
\ No newline at end of file
@@ -0,0 +1,68 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "event-counting-scheduler.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (EventCountingScheduler);
+
+uint64_t EventCountingScheduler::m_nScheduled = 0;
+uint64_t EventCountingScheduler::m_nExecuted = 0;
+uint64_t EventCountingScheduler::m_nRemoved = 0;
+
+TypeId
+EventCountingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EventCountingScheduler")
+    .SetParent<MapScheduler> ()
+    .AddConstructor<EventCountingScheduler> ()
+    ;
+  return tid;
+}
+
+EventCountingScheduler::EventCountingScheduler ()
+{}
+
+EventCountingScheduler::~EventCountingScheduler ()
+{}
+
+void
+EventCountingScheduler::Insert (const Event &ev)
+{
+  m_nScheduled++;
+  MapScheduler::Insert (ev);
+}
+
+Scheduler::Event
+EventCountingScheduler::RemoveNext (void)
+{
+  m_nExecuted++;
+  return MapScheduler::RemoveNext ();
+}
+
+void
+EventCountingScheduler::Remove (const Event &ev)
+{
+  m_nRemoved++;
+  MapScheduler::Remove (ev);
+}
+
+uint64_t
+EventCountingScheduler::GetNScheduled (void)
+{
+  return m_nScheduled;
+}
+
+uint64_t
+EventCountingScheduler::GetNExecuted (void)
+{
+  return m_nExecuted;
+}
+
+uint64_t
+EventCountingScheduler::GetNRemoved (void)
+{
+  return m_nRemoved;
+}
+
+} // namespace ns3
@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef EVENT_COUNTING_SCHEDULER_H
+#define EVENT_COUNTING_SCHEDULER_H
+
+#include <stdint.h>
+#include "ns3/map-scheduler.h"
+
+namespace ns3 {
+
+/**
+ * \brief The default MapScheduler, counting the events it hands out.
+ *
+ * The simulator offers no event counter, so the experiments install this
+ * scheduler to compare the event load of two configurations. The order of
+ * the events is the one of MapScheduler. The counters are per process, as
+ * there is one simulator per process. Read them before Simulator::Destroy,
+ * which empties the queue through RemoveNext.
+ *
+ *   ObjectFactory scheduler;
+ *   scheduler.SetTypeId ("ns3::EventCountingScheduler");
+ *   Simulator::SetScheduler (scheduler);
+ */
+class EventCountingScheduler : public MapScheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  EventCountingScheduler ();
+  virtual ~EventCountingScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+  /**
+   * \return The events scheduled so far, including the cancelled ones.
+   */
+  static uint64_t GetNScheduled (void);
+  /**
+   * \return The events run so far. An event cancelled through its EventId
+   * still leaves the queue this way and is counted.
+   */
+  static uint64_t GetNExecuted (void);
+  /**
+   * \return The events taken out of the queue by Simulator::Remove.
+   */
+  static uint64_t GetNRemoved (void);
+
+private:
+  static uint64_t m_nScheduled;
+  static uint64_t m_nExecuted;
+  static uint64_t m_nRemoved;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_COUNTING_SCHEDULER_H */
@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <sys/stat.h>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/assert.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns2-mobility-cache-helper.h"
+
+NS_LOG_COMPONENT_DEFINE ("Ns2MobilityCacheHelper");
+
+using namespace std;
+
+namespace ns3 {
+
+static const char CACHE_MAGIC[8] = {'B', 'P', 'N', 'S', '2', 'M', 'O', 'B'};
+static const uint32_t CACHE_VERSION = 2;
+
+/*
+ * Each field is written on its own, so no padding of the structs ends up in
+ * the cache. The byte order is the one of the machine, the cache is only
+ * read on the machine that wrote it.
+ */
+template <typename T>
+static bool
+WriteField (FILE *fp, const T& value)
+{
+  return fwrite (&value, sizeof (value), 1, fp) == 1;
+}
+
+template <typename T>
+static bool
+ReadField (FILE *fp, T& value)
+{
+  return fread (&value, sizeof (value), 1, fp) == 1;
+}
+
+static void
+SetMovement (Ptr<ConstantVelocityMobilityModel> model, Vector position, Vector velocity)
+{
+  model->SetPosition (position);
+  model->SetVelocity (velocity);
+}
+
+Ns2MobilityCacheHelper::NodeTrace::NodeTrace ()
+  : m_id (0),
+    m_initialPosition (),
+    m_hasStart (0),
+    m_start (0),
+    m_hasEnd (0),
+    m_end (0),
+    m_waypoints ()
+{}
+
+Ns2MobilityCacheHelper::Ns2MobilityCacheHelper (std::string filename)
+  : m_filename (filename),
+    m_nodes (),
+    m_nodeActivity ()
+{
+  Load ();
+}
+
+std::string
+Ns2MobilityCacheHelper::GetCacheName () const
+{
+  return m_filename + ".cache";
+}
+
+bool
+Ns2MobilityCacheHelper::GetSourceStat (uint64_t& size, int64_t& mtime) const
+{
+  struct stat st;
+  if (stat (m_filename.c_str (), &st) != 0)
+    {
+      return false;
+    }
+  size = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+void
+Ns2MobilityCacheHelper::Load ()
+{
+  if (ReadCache ())
+    {
+      NS_LOG_DEBUG ("Read " << m_nodes.size () << " nodes from " << GetCacheName ());
+    }
+  else if (ReadTrace ())
+    {
+      NS_LOG_DEBUG ("Read " << m_nodes.size () << " nodes from " << m_filename);
+      WriteCache ();
+    }
+  else
+    {
+      cout << "Ns2MobilityCacheHelper: Could not open the file: " << m_filename << endl;
+      NS_ASSERT_MSG (false, "Ns2MobilityCacheHelper: Could not open the file: " << m_filename);
+    }
+
+  m_nodeActivity = Create<bundleProtocol::NodeActivity> ();
+  for (vector<NodeTrace>::const_iterator node = m_nodes.begin (); node != m_nodes.end (); ++node)
+    {
+      if (node->m_hasStart)
+        {
+          m_nodeActivity->SetStartTime (node->m_id, node->m_start);
+        }
+      if (node->m_hasEnd)
+        {
+          m_nodeActivity->SetEndTime (node->m_id, node->m_end);
+        }
+    }
+  // The routers look the times up by the name of the trace
+  bundleProtocol::NodeActivity::Add (m_filename, m_nodeActivity);
+}
+
+// $node_(0) set X_ 150.0
+// $ns_ at 2.0 "$node_(0) setdest 150.0 100.0 5.0"
+
+bool
+Ns2MobilityCacheHelper::ReadTrace ()
+{
+  ifstream file (m_filename.c_str ());
+  if (!file.is_open ())
+    {
+      return false;
+    }
+
+  // The start and end times follow the same rules as when the routers read the trace
+  Ptr<bundleProtocol::NodeActivity> activity = Create<bundleProtocol::NodeActivity> ();
+  map<uint32_t, NodeTrace> nodes;
+  string line;
+  bundleProtocol::Ns2TraceLine parsed;
+  while (getline (file, line))
+    {
+      if (!parsed.Parse (line))
+        {
+          continue;
+        }
+      activity->Update (parsed);
+      NodeTrace& node = nodes[parsed.m_node];
+      node.m_id = parsed.m_node;
+
+      Waypoint waypoint;
+      waypoint.m_time = parsed.m_time;
+      waypoint.m_x = parsed.m_x;
+      waypoint.m_y = parsed.m_y;
+      waypoint.m_speed = parsed.m_speed;
+      switch (parsed.m_command)
+        {
+        case bundleProtocol::Ns2TraceLine::NS2_SETDEST:
+          if (!parsed.m_hasTime)
+            {
+              continue;
+            }
+          waypoint.m_type = WAYPOINT_SETDEST;
+          break;
+        case bundleProtocol::Ns2TraceLine::NS2_SET_X:
+          if (!parsed.m_hasTime)
+            {
+              node.m_initialPosition.x = parsed.m_x;
+              continue;
+            }
+          waypoint.m_type = WAYPOINT_SET_X;
+          break;
+        case bundleProtocol::Ns2TraceLine::NS2_SET_Y:
+          if (!parsed.m_hasTime)
+            {
+              node.m_initialPosition.y = parsed.m_x;
+              continue;
+            }
+          waypoint.m_type = WAYPOINT_SET_Y;
+          break;
+        case bundleProtocol::Ns2TraceLine::NS2_SET_Z:
+          if (!parsed.m_hasTime)
+            {
+              node.m_initialPosition.z = parsed.m_x;
+              continue;
+            }
+          waypoint.m_type = WAYPOINT_SET_Z;
+          break;
+        default:
+          continue;
+        }
+      node.m_waypoints.push_back (waypoint);
+    }
+
+  for (map<uint32_t, NodeTrace>::iterator iter = nodes.begin (); iter != nodes.end (); ++iter)
+    {
+      NodeTrace& node = iter->second;
+      node.m_hasStart = activity->GetStartTime (node.m_id, node.m_start);
+      node.m_hasEnd = activity->GetEndTime (node.m_id, node.m_end);
+    }
+
+  m_nodes.clear ();
+  m_nodes.reserve (nodes.size ());
+  for (map<uint32_t, NodeTrace>::iterator iter = nodes.begin (); iter != nodes.end (); ++iter)
+    {
+      // Same time waypoints keep the order of the trace
+      stable_sort (iter->second.m_waypoints.begin (), iter->second.m_waypoints.end ());
+      m_nodes.push_back (iter->second);
+    }
+  return true;
+}
+
+bool
+Ns2MobilityCacheHelper::ReadCache ()
+{
+  uint64_t size;
+  int64_t mtime;
+  if (!GetSourceStat (size, mtime))
+    {
+      return false;
+    }
+
+  FILE *fp = fopen (GetCacheName ().c_str (), "rb");
+  if (fp == 0)
+    {
+      return false;
+    }
+
+  char magic[8];
+  uint32_t version;
+  uint32_t nNodes;
+  uint64_t sourceSize;
+  int64_t sourceMtime;
+  if (fread (magic, sizeof (magic), 1, fp) != 1 || memcmp (magic, CACHE_MAGIC, sizeof (CACHE_MAGIC)) != 0 ||
+      !ReadField (fp, version) || version != CACHE_VERSION ||
+      !ReadField (fp, nNodes) || !ReadField (fp, sourceSize) || !ReadField (fp, sourceMtime) ||
+      sourceSize != size || sourceMtime != mtime)
+    {
+      NS_LOG_DEBUG ("Stale or foreign cache " << GetCacheName ());
+      fclose (fp);
+      return false;
+    }
+
+  vector<NodeTrace> nodes (nNodes);
+  bool ok = true;
+  for (vector<NodeTrace>::iterator node = nodes.begin (); ok && node != nodes.end (); ++node)
+    {
+      uint32_t nWaypoints;
+      ok = ReadField (fp, node->m_id) && ReadField (fp, nWaypoints) &&
+        ReadField (fp, node->m_initialPosition.x) && ReadField (fp, node->m_initialPosition.y) &&
+        ReadField (fp, node->m_initialPosition.z) &&
+        ReadField (fp, node->m_hasStart) && ReadField (fp, node->m_start) &&
+        ReadField (fp, node->m_hasEnd) && ReadField (fp, node->m_end);
+      if (ok)
+        {
+          node->m_waypoints.resize (nWaypoints);
+        }
+      for (vector<Waypoint>::iterator waypoint = node->m_waypoints.begin (); ok && waypoint != node->m_waypoints.end (); ++waypoint)
+        {
+          ok = ReadField (fp, waypoint->m_time) && ReadField (fp, waypoint->m_x) &&
+            ReadField (fp, waypoint->m_y) && ReadField (fp, waypoint->m_speed) &&
+            ReadField (fp, waypoint->m_type);
+        }
+    }
+  fclose (fp);
+  if (!ok)
+    {
+      NS_LOG_DEBUG ("Truncated cache " << GetCacheName ());
+      return false;
+    }
+
+  m_nodes.swap (nodes);
+  return true;
+}
+
+void
+Ns2MobilityCacheHelper::WriteCache () const
+{
+  uint64_t sourceSize;
+  int64_t sourceMtime;
+  if (!GetSourceStat (sourceSize, sourceMtime))
+    {
+      return;
+    }
+
+  // Written aside and renamed, so that a run started at the same time never reads half a cache
+  std::string temporary = GetCacheName () + ".tmp";
+  FILE *fp = fopen (temporary.c_str (), "wb");
+  if (fp == 0)
+    {
+      NS_LOG_WARN ("Can not write the mobility cache " << temporary);
+      return;
+    }
+
+  uint32_t nNodes = m_nodes.size ();
+  bool ok = fwrite (CACHE_MAGIC, sizeof (CACHE_MAGIC), 1, fp) == 1 &&
+    WriteField (fp, CACHE_VERSION) && WriteField (fp, nNodes) &&
+    WriteField (fp, sourceSize) && WriteField (fp, sourceMtime);
+  for (vector<NodeTrace>::const_iterator node = m_nodes.begin (); ok && node != m_nodes.end (); ++node)
+    {
+      uint32_t nWaypoints = node->m_waypoints.size ();
+      ok = WriteField (fp, node->m_id) && WriteField (fp, nWaypoints) &&
+        WriteField (fp, node->m_initialPosition.x) && WriteField (fp, node->m_initialPosition.y) &&
+        WriteField (fp, node->m_initialPosition.z) &&
+        WriteField (fp, node->m_hasStart) && WriteField (fp, node->m_start) &&
+        WriteField (fp, node->m_hasEnd) && WriteField (fp, node->m_end);
+      for (vector<Waypoint>::const_iterator waypoint = node->m_waypoints.begin (); ok && waypoint != node->m_waypoints.end (); ++waypoint)
+        {
+          ok = WriteField (fp, waypoint->m_time) && WriteField (fp, waypoint->m_x) &&
+            WriteField (fp, waypoint->m_y) && WriteField (fp, waypoint->m_speed) &&
+            WriteField (fp, waypoint->m_type);
+        }
+    }
+  ok = (fclose (fp) == 0) && ok;
+
+  if (!ok || rename (temporary.c_str (), GetCacheName ().c_str ()) != 0)
+    {
+      NS_LOG_WARN ("Can not write the mobility cache " << GetCacheName ());
+      remove (temporary.c_str ());
+    }
+}
+
+void
+Ns2MobilityCacheHelper::InstallNode (Ptr<Object> object, const NodeTrace& trace) const
+{
+  Ptr<ConstantVelocityMobilityModel> model = object->GetObject<ConstantVelocityMobilityModel> ();
+  if (model == 0)
+    {
+      model = CreateObject<ConstantVelocityMobilityModel> ();
+      object->AggregateObject (model);
+    }
+  model->SetPosition (trace.m_initialPosition);
+
+  // The positions are worked out here, so each waypoint is one event and a move needs no cancelling
+  Vector position = trace.m_initialPosition;
+  Vector velocity (0, 0, 0);
+  Vector destination = position;
+  double time = 0;
+  double stopTime = 0;
+  bool moving = false;
+  for (uint32_t i = 0; i < trace.m_waypoints.size (); ++i)
+    {
+      const Waypoint& waypoint = trace.m_waypoints[i];
+      if (moving && waypoint.m_time >= stopTime)
+        {
+          position = destination;
+        }
+      else if (moving)
+        {
+          position = Vector (position.x + velocity.x * (waypoint.m_time - time),
+                             position.y + velocity.y * (waypoint.m_time - time),
+                             position.z);
+        }
+      time = waypoint.m_time;
+      velocity = Vector (0, 0, 0);
+      moving = false;
+
+      switch (waypoint.m_type)
+        {
+        case WAYPOINT_SETDEST:
+          {
+            destination = Vector (waypoint.m_x, waypoint.m_y, position.z);
+            double dx = destination.x - position.x;
+            double dy = destination.y - position.y;
+            double distance = sqrt (dx * dx + dy * dy);
+            if (distance > 0 && waypoint.m_speed > 0)
+              {
+                velocity = Vector (dx / distance * waypoint.m_speed, dy / distance * waypoint.m_speed, 0);
+                stopTime = time + distance / waypoint.m_speed;
+                moving = true;
+              }
+            break;
+          }
+        case WAYPOINT_SET_X:
+          position.x = waypoint.m_x;
+          break;
+        case WAYPOINT_SET_Y:
+          position.y = waypoint.m_x;
+          break;
+        case WAYPOINT_SET_Z:
+          position.z = waypoint.m_x;
+          break;
+        }
+
+      Simulator::Schedule (Seconds (time), &SetMovement, model, position, velocity);
+      // The stop is left out when the next waypoint comes first
+      if (moving && (i + 1 == trace.m_waypoints.size () || trace.m_waypoints[i + 1].m_time > stopTime))
+        {
+          Simulator::Schedule (Seconds (stopTime), &SetMovement, model, destination, Vector (0, 0, 0));
+        }
+    }
+}
+
+void
+Ns2MobilityCacheHelper::LayoutObjectStore (const ObjectStore &store) const
+{
+  for (vector<NodeTrace>::const_iterator node = m_nodes.begin (); node != m_nodes.end (); ++node)
+    {
+      Ptr<Object> object = store.Get (node->m_id);
+      if (object == 0)
+        {
+          continue;
+        }
+      InstallNode (object, *node);
+    }
+}
+
+Ptr<bundleProtocol::NodeActivity>
+Ns2MobilityCacheHelper::GetNodeActivity () const
+{
+  return m_nodeActivity;
+}
+
+void
+Ns2MobilityCacheHelper::Install (void) const
+{
+  Install (NodeList::Begin (), NodeList::End ());
+}
+
+} // namespace ns3
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef NS2_MOBILITY_CACHE_HELPER_H
+#define NS2_MOBILITY_CACHE_HELPER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/object.h"
+#include "ns3/vector.h"
+#include "ns3/bp-node-activity.h"
+
+namespace ns3 {
+
+/**
+ * \brief Installs the movements of an ns-2 mobility trace from a binary cache of the trace.
+ *
+ * The first run converts the text trace into per node waypoint arrays and
+ * writes them next to the trace, in <trace>.cache. Later runs read the cache
+ * instead, as long as the size and modification time of the trace still
+ * match the ones recorded in the cache.
+ *
+ * The nodes get a ConstantVelocityMobilityModel, as with Ns2MobilityHelper.
+ * The start and end times of the nodes are handed to the routers through
+ * bundleProtocol::NodeActivity, so the trace is not read again for them.
+ */
+class Ns2MobilityCacheHelper
+{
+public:
+  Ns2MobilityCacheHelper (std::string filename);
+
+  /**
+   * Configures the movements of all nodes in the global ns3::NodeList
+   * whose id matches a node of the trace.
+   */
+  void Install (void) const;
+
+  template <typename T>
+  void Install (T begin, T end) const;
+
+  Ptr<bundleProtocol::NodeActivity> GetNodeActivity () const;
+
+private:
+  enum WaypointType
+  {
+    WAYPOINT_SETDEST = 0,
+    WAYPOINT_SET_X,
+    WAYPOINT_SET_Y,
+    WAYPOINT_SET_Z
+  };
+
+  struct Waypoint
+  {
+    double m_time;
+    double m_x; // Destination, or the new coordinate for the WAYPOINT_SET_*
+    double m_y;
+    double m_speed;
+    uint32_t m_type;
+
+    bool operator< (const Waypoint& other) const
+    {
+      return m_time < other.m_time;
+    }
+  };
+
+  struct NodeTrace
+  {
+    NodeTrace ();
+
+    uint32_t m_id;
+    Vector m_initialPosition;
+    uint8_t m_hasStart;
+    double m_start;
+    uint8_t m_hasEnd;
+    double m_end;
+    std::vector<Waypoint> m_waypoints;
+  };
+
+  class ObjectStore
+  {
+  public:
+    virtual ~ObjectStore () {}
+    virtual Ptr<Object> Get (uint32_t i) const = 0;
+  };
+
+  void Load ();
+  bool ReadTrace ();
+  bool ReadCache ();
+  void WriteCache () const;
+  bool GetSourceStat (uint64_t& size, int64_t& mtime) const;
+  std::string GetCacheName () const;
+  void LayoutObjectStore (const ObjectStore &store) const;
+  void InstallNode (Ptr<Object> object, const NodeTrace& trace) const;
+
+  std::string m_filename;
+  std::vector<NodeTrace> m_nodes;
+  Ptr<bundleProtocol::NodeActivity> m_nodeActivity;
+};
+
+} // namespace ns3
+
+namespace ns3 {
+
+template <typename T>
+void
+Ns2MobilityCacheHelper::Install (T begin, T end) const
+{
+  class MyObjectStore : public ObjectStore
+  {
+  public:
+    MyObjectStore (T begin, T end)
+      : m_begin (begin),
+      m_end (end)
+        {}
+    virtual Ptr<Object> Get (uint32_t i) const {
+      T iterator = m_begin;
+      iterator += i;
+      if (iterator >= m_end)
+        {
+          return 0;
+        }
+      return *iterator;
+    }
+  private:
+    T m_begin;
+    T m_end;
+  };
+  LayoutObjectStore (MyObjectStore (begin, end));
+}
+
+} // namespace ns3
+
+#endif /* NS2_MOBILITY_CACHE_HELPER_H */
@@ -18,14 +18,21 @@
  */
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <map>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/node-list.h"
 #include "ns3/node.h"
 #include "ns3/packet.h"
 #include "ns3/assert.h"
+#include "ns3/ref-count-base.h"
 #include "one-traffic-helper.h"
 
 #include "ns3/bp-header.h"
@@ -41,20 +48,278 @@
 
 namespace ns3 {
 
+/* Blanks inside a line, a trailing \r of a DOS file included */
+static bool
+IsBlank (char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
 
-OneTrafficHelper::OneTrafficHelper (string filename, uint32_t divider, uint64_t ttl)
-  : m_filename (filename), m_divider (divider), m_ttl (ttl)
+static const char *
+SkipBlanks (const char *p, const char *end)
+{
+  while (p != end && IsBlank (*p))
+    {
+      ++p;
+    }
+  return p;
+}
+
+static const char *
+SkipLine (const char *p, const char *end)
+{
+  const char *newline = (const char *) memchr (p, '\n', end - p);
+  return newline == 0 ? end : newline + 1;
+}
+
+static bool
+ParseToken (const char *&p, const char *end, const char *&token, size_t &length)
+{
+  p = SkipBlanks (p, end);
+  token = p;
+  while (p != end && !IsBlank (*p) && *p != '\n')
+    {
+      ++p;
+    }
+  length = p - token;
+  return length > 0;
+}
+
+static bool
+ParseUnsigned (const char *&p, const char *end, uint32_t &value)
+{
+  p = SkipBlanks (p, end);
+  const char *start = p;
+  value = 0;
+  while (p != end && *p >= '0' && *p <= '9')
+    {
+      value = value * 10 + (*p - '0');
+      ++p;
+    }
+  return p != start;
+}
+
+/* Parses [-]digits[.digits][e[+-]digits] in place, the mapped file is not null terminated */
+static bool
+ParseDouble (const char *&p, const char *end, double &value)
+{
+  p = SkipBlanks (p, end);
+  bool negative = p != end && *p == '-';
+  if (negative)
+    {
+      ++p;
+    }
+  const char *start = p;
+  double mantissa = 0;
+  int exponent = 0;
+  while (p != end && *p >= '0' && *p <= '9')
+    {
+      mantissa = mantissa * 10 + (*p - '0');
+      ++p;
+    }
+  if (p != end && *p == '.')
+    {
+      ++p;
+      while (p != end && *p >= '0' && *p <= '9')
+        {
+          mantissa = mantissa * 10 + (*p - '0');
+          --exponent;
+          ++p;
+        }
+    }
+  if (p == start)
+    {
+      return false;
+    }
+  if (p != end && (*p == 'e' || *p == 'E'))
+    {
+      ++p;
+      bool negativeExponent = p != end && *p == '-';
+      if (p != end && (*p == '-' || *p == '+'))
+        {
+          ++p;
+        }
+      uint32_t e;
+      if (!ParseUnsigned (p, end, e))
+        {
+          return false;
+        }
+      exponent += negativeExponent ? - (int) e : (int) e;
+    }
+  // Dividing by an exact power of ten rounds like strtod for the short fractions of the traffic files
+  value = exponent < 0 ? mantissa / pow (10.0, -exponent) : mantissa * pow (10.0, exponent);
+  if (negative)
+    {
+      value = -value;
+    }
+  return true;
+}
+
+static bundleProtocol::BundlePriority
+GetUtility (const char *utility, size_t length)
+{
+  if (length == 2 && strncmp (utility, "u1", 2) == 0)
+    {
+      return bundleProtocol::BULK;
+    }
+  else if (length == 2 && strncmp (utility, "u2", 2) == 0)
+    {
+      return bundleProtocol::NORMAL;
+    }
+  else if (length == 2 && strncmp (utility, "u3", 2) == 0)
+    {
+      return bundleProtocol::EXPEDITED;
+    }
+  else
+    {
+      return bundleProtocol::BULK;
+    }
+}
+
+/**
+ * \brief Reads a memory mapped ONE traffic file during the simulation and
+ * schedules its messages one window at a time.
+ *
+ * The file is never copied and a payload is only created when its message
+ * is sent, so the memory used does not grow with the number of messages.
+ * Kept alive by its own window events.
+ */
+class OneTrafficSchedule : public RefCountBase
+{
+public:
+  OneTrafficSchedule (uint32_t divider, uint64_t ttl, Time window);
+  virtual ~OneTrafficSchedule ();
+
+  bool Map (const string& filename);
+  void Start (const vector<Ptr<Object> >& objects);
+  void ScheduleWindow ();
+
+private:
+  struct Message
+  {
+    double m_at;
+    uint32_t m_from;
+    uint32_t m_to;
+    uint32_t m_size;
+    bundleProtocol::BundlePriority m_utility;
+  };
+
+  bool ParseMessage (const char *&p, Message& message) const;
+  Ptr<bundleProtocol::Registration> GetRegistration (uint32_t id, const vector<Ptr<Object> >& objects) const;
+  void ScheduleMessage (const Message& message);
+  void Unmap ();
+  static void SendMessage (Ptr<bundleProtocol::Registration> reg, uint32_t size, uint32_t to, bundleProtocol::BundlePriority utility, Time ttl);
+
+  uint32_t m_divider;
+  uint64_t m_ttl;
+  Time m_window;
+  void *m_map;
+  size_t m_length;
+  const char *m_cursor;
+  const char *m_end;
+  map<uint32_t, Ptr<bundleProtocol::Registration> > m_registrations;
+};
+
+OneTrafficSchedule::OneTrafficSchedule (uint32_t divider, uint64_t ttl, Time window)
+  : m_divider (divider),
+    m_ttl (ttl),
+    m_window (window),
+    m_map (0),
+    m_length (0),
+    m_cursor (0),
+    m_end (0),
+    m_registrations ()
 {}
 
+OneTrafficSchedule::~OneTrafficSchedule ()
+{
+  Unmap ();
+}
+
+bool
+OneTrafficSchedule::Map (const string& filename)
+{
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      return false;
+    }
+  struct stat st;
+  if (fstat (fd, &st) < 0)
+    {
+      close (fd);
+      return false;
+    }
+  m_length = st.st_size;
+  if (m_length > 0)
+    {
+      m_map = mmap (0, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m_map == MAP_FAILED)
+        {
+          m_map = 0;
+          close (fd);
+          return false;
+        }
+      // Read front to back, once
+      madvise (m_map, m_length, MADV_SEQUENTIAL);
+    }
+  close (fd);
+  m_cursor = (const char *) m_map;
+  m_end = m_cursor + m_length;
+  return true;
+}
+
+void
+OneTrafficSchedule::Unmap ()
+{
+  if (m_map != 0)
+    {
+      munmap (m_map, m_length);
+      m_map = 0;
+    }
+  m_cursor = m_end = 0;
+}
+
+   // 3600	C	M1	91	37	15850	u2
+
+bool
+OneTrafficSchedule::ParseMessage (const char *&p, Message& message) const
+{
+  while (p != m_end)
+    {
+      const char *line = p;
+      p = SkipLine (p, m_end);
+
+      const char *token;
+      size_t length;
+      if (!ParseDouble (line, p, message.m_at) ||
+          !ParseToken (line, p, token, length) || length != 1 || *token != 'C' ||
+          !ParseToken (line, p, token, length) ||
+          !ParseUnsigned (line, p, message.m_from) ||
+          !ParseUnsigned (line, p, message.m_to) ||
+          !ParseUnsigned (line, p, message.m_size) ||
+          !ParseToken (line, p, token, length))
+        {
+          continue;
+        }
+      message.m_utility = GetUtility (token, length);
+
+      if (message.m_size > 1)
+        message.m_size = ceil ((double) message.m_size / (double) m_divider);
+
+      return true;
+    }
+  return false;
+}
+
  Ptr<bundleProtocol::Registration>
- OneTrafficHelper::GetRegistration (uint32_t id, const ObjectStore &store) const
+ OneTrafficSchedule::GetRegistration (uint32_t id, const vector<Ptr<Object> >& objects) const
  {
-   Ptr<Object> object = store.Get (id);
-   
-   if (object == 0)
+   if (id >= objects.size ())
      {
        return 0;
      }
+   Ptr<Object> object = objects[id];
    
    Ptr<bundleProtocol::Registration> reg = object->GetObject<bundleProtocol::Registration> ();
    if (reg == 0)
@@ -71,88 +336,113 @@ OneTrafficHelper::OneTrafficHelper (string filename, uint32_t divider, uint64_t
    return reg;
  }
 
-   // 3600	C	M1	91	37	15850	u2
-
-void 
-OneTrafficHelper::LayoutObjectStore (const ObjectStore &store) const
+void
+OneTrafficSchedule::Start (const vector<Ptr<Object> >& objects)
 {
-  ifstream file (m_filename.c_str ());
-  if (file.is_open())
+  // The senders are registered at the start, as when all messages were scheduled up front
+  Message message;
+  const char *p = m_cursor;
+  while (ParseMessage (p, message))
     {
-      while (!file.eof() )
+      if (m_registrations.find (message.m_from) != m_registrations.end ())
+        {
+          continue;
+        }
+      Ptr<bundleProtocol::Registration> reg = GetRegistration (message.m_from, objects);
+      if (reg == 0)
         {
-          string line;
-          getline (file, line);
-          double at;
-          string command,message,util;
-          uint32_t from,to,size;
-          
-          istringstream iss (line);
-          iss >> at;
-          iss >> command;
-          if (command != "C")
-            {
-              continue;
-            }
-          
-          iss >> message;
-          iss >> from;
-          iss >> to;
-          iss >> size;
-          iss >> util;
-          
-         
-          if (size > 1)
-            size = ceil ((double) size / (double) m_divider);
-         
-          
-          // size = 2 * size;
-          
-          Ptr<bundleProtocol::Registration> reg = GetRegistration (from, store);
-          if (reg == 0)
-            {
-              cout << "%%%%%%%%%%%%%% Nooo" << endl;
-              cout << "%%%%%%%%%%%%%% Could not find a registration for node (" << from << ")" << endl;
-              continue;
-            }
-          bundleProtocol::BundlePriority utility = GetUtility (util);
-
-          stringstream ss;
-          ss << to;
-
-          bundleProtocol::BundleEndpointId destination = bundleProtocol::BundleEndpointId ("dtn",ss.str ());
-
-          Simulator::Schedule (Seconds (at), &bundleProtocol::Registration::Send, reg, Create<Packet> (size), destination, utility, Seconds (m_ttl), bundleProtocol::PrimaryProcessingControlFlags ());
-          NS_LOG_DEBUG ("At " << at << " send message " << message << " from node " << from << " to node " << to << " with utility " << util << " and size " << size);
+          cout << "%%%%%%%%%%%%%% Nooo" << endl;
+          cout << "%%%%%%%%%%%%%% Could not find a registration for node (" << message.m_from << ")" << endl;
         }
-      file.close();
+      m_registrations[message.m_from] = reg;
     }
-  else 
+
+  ScheduleWindow ();
+}
+
+void
+OneTrafficSchedule::ScheduleWindow ()
+{
+  Time windowEnd = Simulator::Now () + m_window;
+  uint32_t n = 0;
+  Message message;
+  const char *p = m_cursor;
+  while (ParseMessage (p, message))
     {
-      cout << "OneTrafficHelper: Could not open the file: " << m_filename << endl;
-      NS_ASSERT_MSG (false, "OneTrafficHelper: Could not open the file: " << m_filename);
-      NS_LOG_DEBUG ("Could not open the file: " << m_filename);
+      if (Seconds (message.m_at) > windowEnd)
+        {
+          // Left for the window that starts just before it
+          Time next = Max (windowEnd, Seconds (message.m_at) - m_window);
+          Simulator::Schedule (next - Simulator::Now (), &OneTrafficSchedule::ScheduleWindow, Ptr<OneTrafficSchedule> (this));
+          NS_LOG_DEBUG ("Scheduled " << n << " messages up to " << windowEnd.GetSeconds ());
+          return;
+        }
+      m_cursor = p;
+      ScheduleMessage (message);
+      ++n;
     }
+
+  NS_LOG_DEBUG ("Scheduled the last " << n << " messages");
+  Unmap ();
+  m_registrations.clear ();
 }
-   
-bundleProtocol::BundlePriority
-OneTrafficHelper::GetUtility (string utility) const
+
+void
+OneTrafficSchedule::ScheduleMessage (const Message& message)
 {
-  if (utility == "u1")
+  Ptr<bundleProtocol::Registration> reg = m_registrations[message.m_from];
+  if (reg == 0)
     {
-      return bundleProtocol::BULK;
+      return;
     }
-  else if (utility == "u2")
+
+  Time delay = Seconds (message.m_at) - Simulator::Now ();
+  if (delay.IsStrictlyNegative ())
     {
-      return bundleProtocol::NORMAL;
+      // The file is not in time order
+      NS_LOG_WARN ("Message at " << message.m_at << " is out of order, sent now");
+      delay = Seconds (0);
     }
-  else if (utility == "u3")
+  Simulator::Schedule (delay, &OneTrafficSchedule::SendMessage, reg, message.m_size, message.m_to, message.m_utility, Seconds (m_ttl));
+  NS_LOG_DEBUG ("At " << message.m_at << " send a message from node " << message.m_from << " to node " << message.m_to << " with utility " << message.m_utility << " and size " << message.m_size);
+}
+
+void
+OneTrafficSchedule::SendMessage (Ptr<bundleProtocol::Registration> reg, uint32_t size, uint32_t to, bundleProtocol::BundlePriority utility, Time ttl)
+{
+  reg->Send (Create<Packet> (size), bundleProtocol::BundleEndpointId (to), utility, ttl, bundleProtocol::PrimaryProcessingControlFlags ());
+}
+
+OneTrafficHelper::OneTrafficHelper (string filename, uint32_t divider, uint64_t ttl)
+  : m_filename (filename), m_divider (divider), m_ttl (ttl), m_window (Seconds (100))
+{}
+
+void
+OneTrafficHelper::SetWindow (Time window)
+{
+  NS_ASSERT (window.IsStrictlyPositive ());
+  m_window = window;
+}
+
+void 
+OneTrafficHelper::LayoutObjectStore (const ObjectStore &store) const
+{
+  Ptr<OneTrafficSchedule> schedule = Create<OneTrafficSchedule> (m_divider, m_ttl, m_window);
+  if (schedule->Map (m_filename))
     {
-      return bundleProtocol::EXPEDITED;
+      // The store only lives as long as Install, the schedule outlives it
+      vector<Ptr<Object> > objects;
+      for (Ptr<Object> object = store.Get (0); object != 0; object = store.Get (objects.size ()))
+        {
+          objects.push_back (object);
+        }
+      schedule->Start (objects);
     }
-  else
+  else 
     {
-      return bundleProtocol::BULK;
+      cout << "OneTrafficHelper: Could not open the file: " << m_filename << endl;
+      NS_ASSERT_MSG (false, "OneTrafficHelper: Could not open the file: " << m_filename);
+      NS_LOG_DEBUG ("Could not open the file: " << m_filename);
     }
 }
 
@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include "ns3/ptr.h"
 #include "ns3/object.h"
+#include "ns3/nstime.h"
 #include "ns3/bp-registration.h"
 #include "ns3/bp-registration-factory.h"
 
@@ -39,6 +40,13 @@ public:
 
   OneTrafficHelper (std::string filename, uint32_t divider = 1, uint64_t ttl = 43000);
 
+  /**
+   * \brief How far ahead the messages are read and scheduled.
+   *
+   * The file is read one window at a time during the simulation, so only the
+   * messages of the current window are in the event queue.
+   */
+  void SetWindow (Time window);
  
   void Install (void) const;
 
@@ -52,11 +60,10 @@ private:
     virtual Ptr<Object> Get (uint32_t i) const = 0;
   };
   void LayoutObjectStore (const ObjectStore &store) const;
-  Ptr<bundleProtocol::Registration> GetRegistration (uint32_t id, const ObjectStore &store) const;
-  bundleProtocol::BundlePriority GetUtility (string utility) const;
   std::string m_filename;
   uint32_t m_divider;
   uint64_t m_ttl;
+  Time m_window;
 };
 
 } // namespace ns3
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "bp-administrative-record-header.h"
+#include "bp-sdnv.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+NS_OBJECT_ENSURE_REGISTERED (AdministrativeRecordHeader);
+
+TypeId
+AdministrativeRecordHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::bundleProtocol::AdministrativeRecordHeader")
+    .SetParent<Header> ()
+    .AddConstructor<AdministrativeRecordHeader> ()
+    ;
+  return tid;
+}
+
+TypeId
+AdministrativeRecordHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+AdministrativeRecordHeader::AdministrativeRecordHeader ()
+  : m_type (UNKOWN_TYPE),
+    m_flag (UNKOWN_FLAG),
+    m_custodySignal (),
+    m_aggregateCustodySignal ()
+{}
+
+AdministrativeRecordHeader::AdministrativeRecordHeader (const CustodySignal& signal)
+  : m_type (CUSTODY_SIGNAL),
+    m_flag (signal.GetAdminRecordFlag ()),
+    m_custodySignal (signal),
+    m_aggregateCustodySignal ()
+{}
+
+AdministrativeRecordHeader::AdministrativeRecordHeader (const AggregateCustodySignal& signal)
+  : m_type (AGGREGATE_CUSTODY_SIGNAL),
+    m_flag (signal.GetAdminRecordFlag ()),
+    m_custodySignal (),
+    m_aggregateCustodySignal (signal)
+{}
+
+AdministrativeRecordHeader::~AdministrativeRecordHeader ()
+{}
+
+AdminRecordType
+AdministrativeRecordHeader::GetRecordType () const
+{
+  return m_type;
+}
+
+CustodySignal
+AdministrativeRecordHeader::GetCustodySignal () const
+{
+  return m_custodySignal;
+}
+
+AggregateCustodySignal
+AdministrativeRecordHeader::GetAggregateCustodySignal () const
+{
+  return m_aggregateCustodySignal;
+}
+
+void
+AdministrativeRecordHeader::Print (std::ostream &os) const
+{
+  os << "type=" << m_type << " flag=" << m_flag;
+  if (m_type == AGGREGATE_CUSTODY_SIGNAL)
+    {
+      os << " bundles=" << m_aggregateCustodySignal.GetNBundles ();
+    }
+}
+
+uint32_t
+AdministrativeRecordHeader::GetSerializedSize (void) const
+{
+  switch (m_type)
+    {
+    case CUSTODY_SIGNAL:
+      return m_custodySignal.GetSerializedSize ();
+    case AGGREGATE_CUSTODY_SIGNAL:
+      return m_aggregateCustodySignal.GetSerializedSize ();
+    default:
+      return Sdnv::EncodingLength (m_type) + Sdnv::EncodingLength (m_flag);
+    }
+}
+
+void
+AdministrativeRecordHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  switch (m_type)
+    {
+    case CUSTODY_SIGNAL:
+      m_custodySignal.Serialize (i);
+      break;
+    case AGGREGATE_CUSTODY_SIGNAL:
+      m_aggregateCustodySignal.Serialize (i);
+      break;
+    default:
+      Sdnv::Encode (m_type, i);
+      Sdnv::Encode (m_flag, i);
+      break;
+    }
+}
+
+uint32_t
+AdministrativeRecordHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  AdministrativeRecord record = AdministrativeRecord::Deserialize (i);
+  m_type = record.GetRecordType ();
+  m_flag = record.GetAdminRecordFlag ();
+
+  switch (m_type)
+    {
+    case CUSTODY_SIGNAL:
+      i = start;
+      m_custodySignal = CustodySignal::Deserialize (i);
+      break;
+    case AGGREGATE_CUSTODY_SIGNAL:
+      i = start;
+      m_aggregateCustodySignal = AggregateCustodySignal::Deserialize (i);
+      break;
+    default:
+      break;
+    }
+  return i.GetDistanceFrom (start);
+}
+
+}} // namespace bundleProtocol, ns3
@@ -0,0 +1,52 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_ADMINISTRATIVE_RECORD_HEADER_H
+#define BP_ADMINISTRATIVE_RECORD_HEADER_H
+
+#include "ns3/header.h"
+
+#include "bp-administrative-record.h"
+#include "bp-custody-signal.h"
+#include "bp-aggregate-custody-signal.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+/**
+ * \ingroup bundle
+ *
+ * \brief Reads and writes the administrative record in the payload of a bundle.
+ *
+ * The record is read in place with Packet::PeekHeader, only the bytes of the
+ * record are touched and the payload is not copied. Records of other types
+ * than the custody signals only have their type and flag read.
+ */
+class AdministrativeRecordHeader : public Header
+{
+public:
+  AdministrativeRecordHeader ();
+  AdministrativeRecordHeader (const CustodySignal& signal);
+  AdministrativeRecordHeader (const AggregateCustodySignal& signal);
+  virtual ~AdministrativeRecordHeader ();
+
+  AdminRecordType GetRecordType () const;
+  CustodySignal GetCustodySignal () const;
+  AggregateCustodySignal GetAggregateCustodySignal () const;
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  AdminRecordType m_type;
+  AdminRecordFlag m_flag;
+  CustodySignal m_custodySignal;
+  AggregateCustodySignal m_aggregateCustodySignal;
+};
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_ADMINISTRATIVE_RECORD_HEADER_H */
@@ -81,4 +81,20 @@ AdministrativeRecord::Deserialize (uint8_t const*buffer)
   return AdministrativeRecord (type,flag);
 }
 
+void
+AdministrativeRecord::Serialize (Buffer::Iterator& start) const
+{
+  Sdnv::Encode (m_type, start);
+  Sdnv::Encode (m_flag, start);
+}
+
+AdministrativeRecord
+AdministrativeRecord::Deserialize (Buffer::Iterator& start)
+{
+  AdminRecordType type = (AdminRecordType) Sdnv::Decode (start);
+  AdminRecordFlag flag = (AdminRecordFlag) Sdnv::Decode (start);
+
+  return AdministrativeRecord (type,flag);
+}
+
 }} // namespace bundleProtocol, ns3
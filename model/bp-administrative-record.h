@@ -4,6 +4,7 @@
 #define BP_ADMINISTRATIVE_RECORD_H
 
 #include <stdint.h>
+#include "ns3/buffer.h"
 #include "bp-bundle.h"
 
 namespace ns3 {
@@ -12,7 +13,8 @@ namespace bundleProtocol {
 enum AdminRecordType {
     BUNDLE_STATUS_REPORT = 1,
     CUSTODY_SIGNAL = 2,
-    UNKOWN_TYPE = 3
+    UNKOWN_TYPE = 3,
+    AGGREGATE_CUSTODY_SIGNAL = 4
 };
   
 enum AdminRecordFlag {
@@ -36,6 +38,8 @@ public:
   uint32_t GetSerializedSize () const;
   virtual void Serialize (uint8_t *buffer) const;
   static AdministrativeRecord Deserialize (uint8_t const*buffer);
+  void Serialize (Buffer::Iterator& start) const;
+  static AdministrativeRecord Deserialize (Buffer::Iterator& start);
   
 protected:
   AdministrativeRecord (AdminRecordType type, AdminRecordFlag flag);
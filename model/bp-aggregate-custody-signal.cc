@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "bp-aggregate-custody-signal.h"
+#include "bp-sdnv.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+AggregateCustodySignal::AggregateCustodySignal ()
+  : AdministrativeRecord (AGGREGATE_CUSTODY_SIGNAL, RECORD_IS_NOT_FOR_A_FRAGMENT),
+    m_succeeded (false),
+    m_reason (CUSTODY_NO_ADDITIONAL_INFORMATION),
+    m_bundles ()
+{}
+
+AggregateCustodySignal::AggregateCustodySignal (bool succeeded, CustodySignalReason reason)
+  : AdministrativeRecord (AGGREGATE_CUSTODY_SIGNAL, RECORD_IS_NOT_FOR_A_FRAGMENT),
+    m_succeeded (succeeded),
+    m_reason (reason),
+    m_bundles ()
+{}
+
+AggregateCustodySignal::~AggregateCustodySignal ()
+{}
+
+void
+AggregateCustodySignal::SetCustodyTransferSucceeded (bool b)
+{
+  m_succeeded = b;
+}
+
+bool
+AggregateCustodySignal::GetCustodyTransferSucceeded () const
+{
+  return m_succeeded;
+}
+
+void
+AggregateCustodySignal::SetReasonCode (CustodySignalReason reason)
+{
+  m_reason = reason;
+}
+
+CustodySignalReason
+AggregateCustodySignal::GetReasonCode () const
+{
+  return m_reason;
+}
+
+void
+AggregateCustodySignal::AddBundle (const GlobalBundleIdentifier& gbid)
+{
+  m_bundles.insert (gbid);
+}
+
+uint32_t
+AggregateCustodySignal::GetNBundles () const
+{
+  return m_bundles.size ();
+}
+
+GlobalBundleIdentifiers
+AggregateCustodySignal::GetBundles () const
+{
+  return GlobalBundleIdentifiers (m_bundles.begin (), m_bundles.end ());
+}
+
+void
+AggregateCustodySignal::Clear ()
+{
+  m_bundles.clear ();
+}
+
+uint32_t
+AggregateCustodySignal::GetSerializedSize (void) const
+{
+  uint32_t size = this->AdministrativeRecord::GetSerializedSize ();
+  size += 1; // status
+
+  uint64_t nSources = 0;
+  for (Bundles::const_iterator begin = m_bundles.begin (); begin != m_bundles.end ();)
+    {
+      BundleEndpointId source = begin->GetSourceEid ();
+      Bundles::const_iterator end = begin;
+      uint64_t nBundles = 0;
+      uint64_t seconds = 0;
+      uint64_t sequence = 0;
+      for (; end != m_bundles.end () && end->GetSourceEid () == source; ++end)
+        {
+          CreationTimestamp timestamp = end->GetCreationTimestamp ();
+          bool sameSecond = end != begin && timestamp.GetSeconds () == seconds;
+          size += Sdnv::EncodingLength (timestamp.GetSeconds () - seconds);
+          size += Sdnv::EncodingLength (((sameSecond ? timestamp.GetSequence () - sequence : timestamp.GetSequence ()) << 1) | end->IsFragment ());
+          if (end->IsFragment ())
+            {
+              size += Sdnv::EncodingLength (end->GetFragmentOffset ());
+              size += Sdnv::EncodingLength (end->GetFragmentLength ());
+            }
+          seconds = timestamp.GetSeconds ();
+          sequence = timestamp.GetSequence ();
+          ++nBundles;
+        }
+      size += Sdnv::EncodingLength (source.GetId () + 1);
+      size += Sdnv::EncodingLength (nBundles);
+      ++nSources;
+      begin = end;
+    }
+  size += Sdnv::EncodingLength (nSources);
+  return size;
+}
+
+void
+AggregateCustodySignal::Serialize (Buffer::Iterator& start) const
+{
+  this->AdministrativeRecord::Serialize (start);
+
+  start.WriteU8 ((m_succeeded << 7) | m_reason);
+
+  uint64_t nSources = 0;
+  for (Bundles::const_iterator iter = m_bundles.begin (); iter != m_bundles.end (); ++iter)
+    {
+      Bundles::const_iterator previous = iter;
+      if (iter == m_bundles.begin () || (--previous)->GetSourceEid () != iter->GetSourceEid ())
+        {
+          ++nSources;
+        }
+    }
+  Sdnv::Encode (nSources, start);
+
+  for (Bundles::const_iterator begin = m_bundles.begin (); begin != m_bundles.end ();)
+    {
+      BundleEndpointId source = begin->GetSourceEid ();
+      Bundles::const_iterator end = begin;
+      uint64_t nBundles = 0;
+      while (end != m_bundles.end () && end->GetSourceEid () == source)
+        {
+          ++end;
+          ++nBundles;
+        }
+
+      // Adjusted one step as in BundleEndpointId::Serialize, so the any eid is 0
+      Sdnv::Encode (source.GetId () + 1, start);
+      Sdnv::Encode (nBundles, start);
+
+      uint64_t seconds = 0;
+      uint64_t sequence = 0;
+      for (Bundles::const_iterator iter = begin; iter != end; ++iter)
+        {
+          CreationTimestamp timestamp = iter->GetCreationTimestamp ();
+          bool sameSecond = iter != begin && timestamp.GetSeconds () == seconds;
+
+          // The sequence, relative within the same second, and the fragment flag share an SDNV
+          Sdnv::Encode (timestamp.GetSeconds () - seconds, start);
+          Sdnv::Encode (((sameSecond ? timestamp.GetSequence () - sequence : timestamp.GetSequence ()) << 1) | iter->IsFragment (), start);
+          if (iter->IsFragment ())
+            {
+              Sdnv::Encode (iter->GetFragmentOffset (), start);
+              Sdnv::Encode (iter->GetFragmentLength (), start);
+            }
+
+          seconds = timestamp.GetSeconds ();
+          sequence = timestamp.GetSequence ();
+        }
+      begin = end;
+    }
+}
+
+AggregateCustodySignal
+AggregateCustodySignal::Deserialize (Buffer::Iterator& start)
+{
+  AdministrativeRecord adminRecord = AdministrativeRecord::Deserialize (start);
+
+  AggregateCustodySignal signal = AggregateCustodySignal ();
+  signal.SetRecordType (adminRecord.GetRecordType ());
+  signal.SetAdminRecordFlag (adminRecord.GetAdminRecordFlag ());
+
+  uint8_t status = start.ReadU8 ();
+  signal.SetCustodyTransferSucceeded ((status >> 7) & 1);
+  signal.SetReasonCode ((CustodySignalReason) (status & 0x7f));
+
+  uint64_t nSources = Sdnv::Decode (start);
+  for (uint64_t s = 0; s < nSources; ++s)
+    {
+      BundleEndpointId source = BundleEndpointId ((int) (Sdnv::Decode (start) - 1));
+      uint64_t nBundles = Sdnv::Decode (start);
+
+      uint64_t seconds = 0;
+      uint64_t sequence = 0;
+      for (uint64_t b = 0; b < nBundles; ++b)
+        {
+          uint64_t secondsDelta = Sdnv::Decode (start);
+          uint64_t sequenceAndFragment = Sdnv::Decode (start);
+          uint64_t tmp = sequenceAndFragment >> 1;
+          sequence = (b != 0 && secondsDelta == 0) ? sequence + tmp : tmp;
+          seconds += secondsDelta;
+
+          if (sequenceAndFragment & 1)
+            {
+              uint64_t offset = Sdnv::Decode (start);
+              uint64_t length = Sdnv::Decode (start);
+              signal.AddBundle (GlobalBundleIdentifier (source, CreationTimestamp (seconds, sequence), offset, length));
+            }
+          else
+            {
+              signal.AddBundle (GlobalBundleIdentifier (source, CreationTimestamp (seconds, sequence)));
+            }
+        }
+    }
+
+  return signal;
+}
+
+}} // namespace bundleProtocol, ns3
@@ -0,0 +1,71 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_AGGREGATE_CUSTODY_SIGNAL_H
+#define BP_AGGREGATE_CUSTODY_SIGNAL_H
+
+#include <set>
+#include <vector>
+
+#include "bp-administrative-record.h"
+#include "bp-custody-signal.h"
+#include "bp-global-bundle-identifier.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+typedef vector<GlobalBundleIdentifier> GlobalBundleIdentifiers;
+
+/**
+ * \ingroup bundle
+ *
+ * \brief A custody signal for several bundles with the same status.
+ *
+ * The bundles are grouped by source and, for each source, sorted by creation
+ * timestamp. Each bundle takes an SDNV for the seconds since the previous
+ * bundle of the source and one for the sequence, relative to the previous
+ * bundle when in the same second, with the fragment flag as its lowest bit.
+ * Fragments add their offset and length. The sequence is the nanoseconds
+ * within the second, so a bundle created on a whole second takes about 2
+ * bytes and one created within the second up to 6, a few more for the first
+ * bundle of each source.
+ *
+ * The sequences are not dense, so there are no ranges of bundles, the gain
+ * is that one bundle carries the signals of up to CustodySignalMaxBundles
+ * bundles.
+ *
+ * It is carried as the payload of a bundle with a CUSTODY_SIGNAL_BLOCK, see
+ * AdministrativeRecordHeader.
+ */
+class AggregateCustodySignal : public AdministrativeRecord
+{
+public:
+  AggregateCustodySignal ();
+  AggregateCustodySignal (bool succeeded, CustodySignalReason reason);
+  ~AggregateCustodySignal ();
+
+  void SetCustodyTransferSucceeded (bool b);
+  bool GetCustodyTransferSucceeded () const;
+
+  void SetReasonCode (CustodySignalReason reason);
+  CustodySignalReason GetReasonCode () const;
+
+  void AddBundle (const GlobalBundleIdentifier& gbid);
+  uint32_t GetNBundles () const;
+  GlobalBundleIdentifiers GetBundles () const;
+  void Clear ();
+
+  uint32_t GetSerializedSize (void) const;
+  void Serialize (Buffer::Iterator& start) const;
+  static AggregateCustodySignal Deserialize (Buffer::Iterator& start);
+
+private:
+  typedef set<GlobalBundleIdentifier> Bundles;
+
+  bool m_succeeded;
+  CustodySignalReason m_reason;
+  Bundles m_bundles;
+};
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_AGGREGATE_CUSTODY_SIGNAL_H */
@@ -218,6 +218,13 @@ operator>> (istream &is, BundleEndpointId& eid)
   return is;
 }
 
+size_t
+BundleEndpointIdHash::operator() (const BundleEndpointId& eid) const
+{
+  // Equal endpoint ids have the same id
+  return eid.GetId ();
+}
+
 }} // namespace bundleProtocol, ns3
 
 
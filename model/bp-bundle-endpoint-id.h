@@ -130,6 +130,15 @@ ATTRIBUTE_HELPER_HEADER (BundleEndpointId);
 ostream& operator<< (ostream& os, const BundleEndpointId& eid);
 istream& operator>> (istream& is, BundleEndpointId& eid);
 
+/**
+ * \brief Hash of a BundleEndpointId, to keep them in the tr1 unordered containers.
+ */
+class BundleEndpointIdHash
+{
+public:
+  size_t operator() (const BundleEndpointId& eid) const;
+};
+
 
 }} // namespace bundleProtocol, ns3
 
@@ -0,0 +1,80 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/simulator.h"
+
+#include "bp-bundle-history.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+BundleHistory::BundleHistory ()
+  : m_entries (),
+    m_expirations ()
+{}
+
+BundleHistory::~BundleHistory ()
+{
+  Clear ();
+}
+
+void
+BundleHistory::Insert (const GlobalBundleIdentifier& gbid, Time expiration)
+{
+  RemoveExpired ();
+
+  Entries::iterator iter = m_entries.find (gbid);
+  if (iter != m_entries.end ())
+    {
+      m_expirations.erase (make_pair (iter->second, gbid));
+      iter->second = expiration;
+    }
+  else
+    {
+      m_entries.insert (make_pair (gbid, expiration));
+    }
+  m_expirations.insert (make_pair (expiration, gbid));
+}
+
+bool
+BundleHistory::Contains (const GlobalBundleIdentifier& gbid) const
+{
+  Entries::const_iterator iter = m_entries.find (gbid);
+  return iter != m_entries.end () && iter->second > Simulator::Now ();
+}
+
+void
+BundleHistory::Erase (const GlobalBundleIdentifier& gbid)
+{
+  Entries::iterator iter = m_entries.find (gbid);
+  if (iter != m_entries.end ())
+    {
+      m_expirations.erase (make_pair (iter->second, gbid));
+      m_entries.erase (iter);
+    }
+}
+
+uint32_t
+BundleHistory::GetNBundles () const
+{
+  return m_entries.size ();
+}
+
+void
+BundleHistory::Clear ()
+{
+  m_entries.clear ();
+  m_expirations.clear ();
+}
+
+void
+BundleHistory::RemoveExpired ()
+{
+  Time now = Simulator::Now ();
+  while (!m_expirations.empty () && m_expirations.begin ()->first <= now)
+    {
+      m_entries.erase (m_expirations.begin ()->second);
+      m_expirations.erase (m_expirations.begin ());
+    }
+}
+
+}} // namespace bundleProtocol, ns3
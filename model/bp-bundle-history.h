@@ -0,0 +1,60 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_BUNDLE_HISTORY_H
+#define BP_BUNDLE_HISTORY_H
+
+#include <set>
+#include <tr1/unordered_map>
+#include <utility>
+#include <stdint.h>
+
+#include "ns3/nstime.h"
+
+#include "bp-global-bundle-identifier.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief The bundles a router remembers, e.g the ones it has delivered or handed the custody of.
+ *
+ * Each bundle is remembered until its expiration time. Expired bundles are
+ * not found any more and are removed when new bundles are inserted, so the
+ * history does not grow with the length of the simulation.
+ */
+class BundleHistory
+{
+ public:
+  BundleHistory ();
+  ~BundleHistory ();
+
+  /**
+   * \brief Remembers the bundle, or moves its expiration if already remembered.
+   * \param gbid The bundle.
+   * \param expiration When the bundle is forgotten.
+   */
+  void Insert (const GlobalBundleIdentifier& gbid, Time expiration);
+  bool Contains (const GlobalBundleIdentifier& gbid) const;
+  void Erase (const GlobalBundleIdentifier& gbid);
+
+  uint32_t GetNBundles () const;
+  void Clear ();
+
+ private:
+  // Looked up by every Contains, hashed for O(1), the expirations are ordered for RemoveExpired
+  typedef tr1::unordered_map<GlobalBundleIdentifier, Time, GlobalBundleIdentifierHash> Entries;
+  typedef set<pair<Time, GlobalBundleIdentifier> > Expirations;
+
+  void RemoveExpired ();
+
+  Entries m_entries;
+  Expirations m_expirations;
+};
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_BUNDLE_HISTORY_H */
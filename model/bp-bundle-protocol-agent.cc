@@ -6,10 +6,12 @@
 #include "ns3/object.h"
 #include "ns3/mac48-address.h"
 #include "ns3/log.h"
+#include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
 
 #include "bp-bundle-protocol-agent.h"
 #include "bp-sdnv.h"
+#include "bp-administrative-record-header.h"
 
 NS_LOG_COMPONENT_DEFINE ("BundleProtocolAgent");
 namespace ns3 {
@@ -28,6 +30,16 @@ BundleProtocolAgent::GetTypeId (void)
                    BundleEndpointIdValue (BundleEndpointId ()),
                    MakeBundleEndpointIdAccessor (&BundleProtocolAgent::m_eid),
                    MakeBundleEndpointIdChecker ())
+    .AddAttribute ("CustodySignalDelay",
+                   "The time a custody signal waits for signals for other bundles to the same custodian.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&BundleProtocolAgent::m_custodySignalDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("CustodySignalMaxBundles",
+                   "The number of bundles after which a custody signal is sent without waiting.",
+                   UintegerValue (32),
+                   MakeUintegerAccessor (&BundleProtocolAgent::m_custodySignalMaxBundles),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddTraceSource ("Created", "Created a new bundle",
                      MakeTraceSourceAccessor (&BundleProtocolAgent::m_createLogger))
     .AddTraceSource ("Relayed", "A relayed message have been received.",
@@ -44,7 +56,11 @@ BundleProtocolAgent::BundleProtocolAgent ()
   : m_node (),
     m_cla (),
     m_bundleRouter (),
-    m_registrationManager (new RegistrationManager ())
+    m_registrationManager (new RegistrationManager ()),
+    m_reassembler (),
+    m_pendingCustodySignals (),
+    m_custodySignalDelay (MilliSeconds (100)),
+    m_custodySignalMaxBundles (32)
 {}
 
 
@@ -56,7 +72,11 @@ BundleProtocolAgent::BundleProtocolAgent (BundleEndpointId defaultEndpointId,
     m_cla (cla),
     m_bundleRouter (bundleRouter),
     m_eid (defaultEndpointId),
-    m_registrationManager (new RegistrationManager ())
+    m_registrationManager (new RegistrationManager ()),
+    m_reassembler (),
+    m_pendingCustodySignals (),
+    m_custodySignalDelay (MilliSeconds (100)),
+    m_custodySignalMaxBundles (32)
 {}
 
 BundleProtocolAgent::~BundleProtocolAgent ()
@@ -72,6 +92,12 @@ BundleProtocolAgent::DoDispose ()
       delete m_registrationManager;
       m_registrationManager = 0;
     }
+  m_reassembler.Clear ();
+  for (PendingCustodySignals::iterator iter = m_pendingCustodySignals.begin (); iter != m_pendingCustodySignals.end (); ++iter)
+    {
+      Simulator::Cancel (iter->second.m_flushEvent);
+    }
+  m_pendingCustodySignals.clear ();
   m_node = 0;
   Object::DoDispose ();
 }
@@ -83,8 +109,10 @@ BundleProtocolAgent::Init ()
   m_cla->SetBundleSentOkCallback (MakeCallback (&BundleProtocolAgent::BundleSentOk, this));
   m_cla->SetBundleSentFailedCallback (MakeCallback (&BundleProtocolAgent::BundleSentFailed, this));
   m_cla->SetTransmissionCancelledCallback (MakeCallback (&BundleProtocolAgent::TransmissionCancelled, this));
+  m_cla->SetBundlePartiallySentCallback (MakeCallback (&BundleProtocolAgent::BundlePartiallySent, this));
   m_bundleRouter->SetBundleSendCallback (MakeCallback (&BundleProtocolAgent::SendBundle, this));
   m_bundleRouter->SetCancelTransmisisonCallback (MakeCallback (&BundleProtocolAgent::CancelTransmission, this));
+  m_bundleRouter->SetBufferChangedCallback (MakeCallback (&BundleProtocolAgent::BufferChanged, this));
 }
 
 
@@ -187,18 +215,9 @@ void
 BundleProtocolAgent::BundleReceivedFromConvergenceLayer (Ptr<Bundle> bundle)
 {
   //std::cout<<"Received From: ("<<bundle->GetCustodianEndpoint().GetId()<<")"<<" To me ("<< m_node->GetId ()<<") Bundle Id *"<<bundle->GetGlobalId()<<"*\n";
-  if(bundle->GetReplicationFactor() == 20)/*Indica que é uma resposta de custódia*/
+  if (bundle->GetCanonicalHeaders ().front ().GetBlockType () == CUSTODY_SIGNAL_BLOCK)
   {
-	  if(bundle->GetReportCustodyAcceptance()) /*Custódia aceita, pode apagar o bundle*/
-	  {
-		  NS_LOG_DEBUG("(" << m_node->GetId () << ") " << "-> Custodia Aceita " << bundle->GetBundleId());
-		  m_bundleRouter->DeleteBundle(bundle->GetCustody(),false);
-	  }
-	  else
-	  {
-		  NS_LOG_DEBUG("(" << m_node->GetId () << ") " << "-> Custodia Não Aceita ");
-		  m_bundleRouter->EraseCustodyHistoricalPending(bundle->GetCustody());
-	  }
+	  CustodySignalBundleReception (bundle);
   }
   else if (m_bundleRouter->isBundleDelivery(bundle))/*Nesse caso esse no ja tem o bundle, então ele denvolve apenas um sinal de custodia aceita para no requisitante apagar sua copia*/
   {
@@ -207,11 +226,7 @@ BundleProtocolAgent::BundleReceivedFromConvergenceLayer (Ptr<Bundle> bundle)
 		Ptr<Link> link = this->m_bundleRouter->GetLinkManager()->FindLink(bundle->GetCustodianEndpoint());
 		if(link)
 		{
-			Ptr<Bundle> bundleS = bundle->Copy();//GenerateBundle (Create<Packet> (1), bundle->GetCustodianEndpoint(), bundleProtocol::EXPEDITED,Seconds(100), bundleProtocol::PrimaryProcessingControlFlags ());
-			bundleS->SetReportCustodyAcceptance(true);
-			bundleS->SetReplicationFactor(20);
-			bundleS->SetCustody(bundle->GetBundleId());
-			m_bundleRouter->SendBundle(link,bundleS);
+			QueueCustodySignal (bundle->GetCustodianEndpoint(), bundle->GetBundleId(), true);
 		}
 	}
   }
@@ -250,19 +265,14 @@ BundleProtocolAgent::BundleReceivedFromConvergenceLayer (Ptr<Bundle> bundle)
 		  if (bundle->IsAdministrativeRecord ())
 			{
 			//  NS_LOG_DEBUG("-> IsAdministrativeRecord ()");
-			  Ptr<Packet> payload;
-			  /*Essa linha provavelmente foi esquecida*/
-			  payload = bundle->GetPayload();
-			  /*****************************************/
-			  uint8_t buffer[payload->GetSize ()];
-			  payload->CopyData (buffer,payload->GetSize ());
-			  AdministrativeRecord adminRecord = AdministrativeRecord::Deserialize (buffer);
+			  AdministrativeRecordHeader adminRecord;
+			  bundle->GetPayload ()->PeekHeader (adminRecord);
 			  // The other option for a administrative record is an bundle status report
 			  // but these are only of interest for the application?
 			  if (adminRecord.GetRecordType () == CUSTODY_SIGNAL)
 			   {
 				 // NS_LOG_DEBUG("	-> CUSTODY_SIGNAL");
-				  CustodySignal custodySignal = CustodySignal::Deserialize (buffer);
+				  CustodySignal custodySignal = adminRecord.GetCustodySignal ();
 				  custodySignal.SetCustodyTransferSucceeded(true);
 				  CustodySignalReception (custodySignal);
 				  bundle->AddRetentionConstraint(RC_CUSTODY_ACCEPTED);
@@ -342,12 +352,8 @@ BundleProtocolAgent::GenerateCustodySignal (Ptr<Bundle> bundle, bool status)
 			Ptr<Link> link = this->m_bundleRouter->GetLinkManager()->FindLink(bundle->GetCustodianEndpoint());
 		if(link)
 		{
-			Ptr<Bundle> bundleS = bundle->Copy();//GenerateBundle (Create<Packet> (1), bundle->GetCustodianEndpoint(), bundleProtocol::EXPEDITED,Seconds(100), bundleProtocol::PrimaryProcessingControlFlags ());
-			bundleS->SetReportCustodyAcceptance(true);
-			bundleS->SetReplicationFactor(20);
-			bundleS->SetCustody(bundle->GetBundleId());
-			NS_LOG_DEBUG("Aceita " << bundleS->GetCustody());
-			m_bundleRouter->SendBundle(link,bundleS);
+			NS_LOG_DEBUG("Aceita " << bundle->GetBundleId());
+			QueueCustodySignal (bundle->GetCustodianEndpoint(), bundle->GetBundleId(), true);
 			NS_LOG_DEBUG(m_node->GetId() << " GenerateCustodySignal Positive Enviar");
 			return true;
 		}
@@ -357,13 +363,8 @@ BundleProtocolAgent::GenerateCustodySignal (Ptr<Bundle> bundle, bool status)
 		Ptr<Link> link = this->m_bundleRouter->GetLinkManager()->FindLink(bundle->GetCustodianEndpoint());
 		if(link)
 		{
-			Ptr<Bundle> bundleS = bundle->Copy();//GenerateBundle (Create<Packet> (1), bundle->GetCustodianEndpoint(), bundleProtocol::EXPEDITED,Seconds(100), bundleProtocol::PrimaryProcessingControlFlags ());
-			bundleS->SetReportCustodyAcceptance(false);
-			bundleS->SetReplicationFactor(20);
-			bundleS->SetCustody(bundle->GetBundleId());
-			//Simulator::ScheduleNow (&BundleRouter::SendBundle, m_bundleRouter, link, bundleS);
 			NS_LOG_DEBUG(m_node->GetId() << " GenerateCustodySignal Negative Enviar");
-			m_bundleRouter->SendBundle(link,bundleS);
+			QueueCustodySignal (bundle->GetCustodianEndpoint(), bundle->GetBundleId(), false);
 		}
 		return false;
 	}
@@ -371,6 +372,123 @@ BundleProtocolAgent::GenerateCustodySignal (Ptr<Bundle> bundle, bool status)
 	return true;
 }
 
+void
+BundleProtocolAgent::QueueCustodySignal (const BundleEndpointId& custodian, const GlobalBundleIdentifier& gbid, bool succeeded)
+{
+  pair<BundleEndpointId, bool> key (custodian, succeeded);
+  PendingCustodySignals::iterator iter = m_pendingCustodySignals.find (key);
+  if (iter == m_pendingCustodySignals.end ())
+    {
+      PendingCustodySignal pending;
+      pending.m_signal = AggregateCustodySignal (succeeded, CUSTODY_NO_ADDITIONAL_INFORMATION);
+      iter = m_pendingCustodySignals.insert (make_pair (key, pending)).first;
+    }
+  iter->second.m_signal.AddBundle (gbid);
+
+  if (iter->second.m_signal.GetNBundles () >= m_custodySignalMaxBundles || !m_custodySignalDelay.IsStrictlyPositive ())
+    {
+      Simulator::Cancel (iter->second.m_flushEvent);
+      FlushCustodySignal (custodian, succeeded);
+    }
+  else if (!iter->second.m_flushEvent.IsRunning ())
+    {
+      iter->second.m_flushEvent = Simulator::Schedule (m_custodySignalDelay, &BundleProtocolAgent::FlushCustodySignal, this, custodian, succeeded);
+    }
+}
+
+void
+BundleProtocolAgent::FlushCustodySignal (BundleEndpointId custodian, bool succeeded)
+{
+  PendingCustodySignals::iterator iter = m_pendingCustodySignals.find (make_pair (custodian, succeeded));
+  if (iter == m_pendingCustodySignals.end ())
+    {
+      return;
+    }
+  AggregateCustodySignal signal = iter->second.m_signal;
+  m_pendingCustodySignals.erase (iter);
+
+  // The routers queue the bundle on the contact of the link
+  Ptr<Link> link = m_bundleRouter->GetLinkManager ()->FindLink (custodian);
+  if (link == 0 || link->GetContact () == 0)
+    {
+      NS_LOG_DEBUG ("(" << m_node->GetId () << ") " << "Custody signal for " << signal.GetNBundles () << " bundles to " << custodian << " lost, no contact");
+      return;
+    }
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") " << "Custody signal for " << signal.GetNBundles () << " bundles to " << custodian << " succeeded " << succeeded);
+  m_bundleRouter->SendBundle (link, GenerateCustodySignalBundle (custodian, signal));
+}
+
+Ptr<Bundle>
+BundleProtocolAgent::GenerateCustodySignalBundle (const BundleEndpointId& custodian, const AggregateCustodySignal& signal)
+{
+  Ptr<Packet> adu = Create<Packet> ();
+  adu->AddHeader (AdministrativeRecordHeader (signal));
+
+  PrimaryBundleHeader primaryHeader = PrimaryBundleHeader ();
+  primaryHeader.SetDestinationEndpoint (custodian);
+  primaryHeader.SetSourceEndpoint (m_eid);
+  primaryHeader.SetCustodianEndpoint (m_eid);
+  primaryHeader.SetReplicationFactor (1);
+  primaryHeader.SetCreationTimestamp (CreationTimestamp ());
+  primaryHeader.SetLifetime (Seconds (60));
+  primaryHeader.SetAdministrativeRecord (true);
+
+  CanonicalBundleHeader canonicalHeader = CanonicalBundleHeader (CUSTODY_SIGNAL_BLOCK);
+  canonicalHeader.SetMustBeReplicated (false);
+  canonicalHeader.SetStatusReport (false);
+  canonicalHeader.SetDeleteBundle (false);
+  canonicalHeader.SetLastBlock (true);
+  canonicalHeader.SetDiscardBlock (true);
+  canonicalHeader.SetForwarded (false);
+  canonicalHeader.SetContainsEid (false);
+  canonicalHeader.SetBlockLength (adu->GetSize ());
+
+  Ptr<Bundle> bundle = Create<Bundle> ();
+  bundle->SetPayload (adu);
+  bundle->SetPrimaryHeader (primaryHeader);
+  bundle->AddCanonicalHeader (canonicalHeader);
+  return bundle;
+}
+
+void
+BundleProtocolAgent::CustodySignalBundleReception (Ptr<Bundle> bundle)
+{
+  Ptr<Packet> payload = bundle->GetPayload ();
+  if (payload->GetSize () == 0)
+    {
+      return;
+    }
+  AdministrativeRecordHeader adminRecord;
+  payload->PeekHeader (adminRecord);
+  if (adminRecord.GetRecordType () != AGGREGATE_CUSTODY_SIGNAL)
+    {
+      return;
+    }
+
+  AggregateCustodySignal signal = adminRecord.GetAggregateCustodySignal ();
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") " << "Custody signal for " << signal.GetNBundles () << " bundles from " << bundle->GetSourceEndpoint ());
+  GlobalBundleIdentifiers gbids = signal.GetBundles ();
+  for (GlobalBundleIdentifiers::const_iterator iter = gbids.begin (); iter != gbids.end (); ++iter)
+    {
+      CustodyResponseReception (*iter, signal.GetCustodyTransferSucceeded ());
+    }
+}
+
+void
+BundleProtocolAgent::CustodyResponseReception (const GlobalBundleIdentifier& gbid, bool succeeded)
+{
+  if (succeeded) /*Custódia aceita, pode apagar o bundle*/
+    {
+      NS_LOG_DEBUG ("(" << m_node->GetId () << ") " << "-> Custodia Aceita " << gbid);
+      m_bundleRouter->DeleteBundle (gbid, false);
+    }
+  else
+    {
+      NS_LOG_DEBUG ("(" << m_node->GetId () << ") " << "-> Custodia Não Aceita ");
+      m_bundleRouter->EraseCustodyHistoricalPending (gbid);
+    }
+}
+
 void 
 BundleProtocolAgent::CancelTransmission (GlobalBundleIdentifier gbid, BundleEndpointId eid)
 {
@@ -456,6 +574,12 @@ BundleProtocolAgent::BundleSentFailed (const Mac48Address& address, GlobalBundle
   m_bundleRouter->BundleTransmissionFailed (address, gbid);
 }
 
+void
+BundleProtocolAgent::BundlePartiallySent (const Mac48Address& address, GlobalBundleIdentifier gbid, uint32_t payloadBytes)
+{
+  m_bundleRouter->BundlePartiallySent (address, gbid, payloadBytes);
+}
+
 
 // 5.4.1 Forwarding Contradicted
 void
@@ -603,7 +727,19 @@ BundleProtocolAgent::CanProcessBlock (const BlockType& block)
 void
 BundleProtocolAgent::LocalBundleDelivery (Ptr<Bundle> bundle)
 {
-  // Step 1: No bundle fragmentation implemented making this step, unnecessary
+  // Step 1: Fragments are held until the whole ADU can be reassembled
+  if (bundle->IsFragment ())
+    {
+      m_reassembler.RemoveExpired ();
+      Ptr<Bundle> whole = m_reassembler.AddFragment (bundle);
+      // The fragment has reached its destination, so the router can stop spreading it
+      m_bundleRouter->BundleDelivered (bundle, false);
+      if (whole == 0)
+        {
+          return;
+        }
+      bundle = whole;
+    }
 
   // Step 2: Registration always in active state
   ForwardUp (bundle);
@@ -761,6 +897,12 @@ BundleProtocolAgent::CreateRegistration (void)
   return registration;
 }
 
+void
+BundleProtocolAgent::BufferChanged (uint32_t freeBytes)
+{
+  m_registrationManager->NotifySend (freeBytes);
+}
+
 RegistrationEndpoint*
 BundleProtocolAgent::Allocate ()
 {
@@ -3,6 +3,8 @@
 #ifndef BUNDLE_PROTOCOL_AGENT_H
 #define BUNDLE_PROTOCOL_AGENT_H
 
+#include <map>
+
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/node.h"
@@ -11,6 +13,7 @@
 #include "ns3/nstime.h"
 #include "ns3/callback.h"
 #include "ns3/traced-callback.h"
+#include "ns3/event-id.h"
 
 #include "bp-registration.h"
 #include "bp-registration-endpoint.h"
@@ -21,6 +24,8 @@
 #include "bp-convergence-layer-agent.h"
 #include "bp-bundle-router.h"
 #include "bp-link.h"
+#include "bp-fragmentation.h"
+#include "bp-aggregate-custody-signal.h"
 
 using namespace std;
 
@@ -115,6 +120,18 @@ public:
   RegistrationEndpoint* Allocate ();
   RegistrationEndpoint* Allocate (const BundleEndpointId& eid);
   void DeAllocate (RegistrationEndpoint *regEndpoint);
+
+  /**
+   * \brief Adds the bundle to the pending custody signal to the custodian.
+   *
+   * The signals to the same custodian with the same status are sent together,
+   * when CustodySignalMaxBundles bundles are pending or CustodySignalDelay
+   * after the first one.
+   * \param custodian The custodian the signal is sent to.
+   * \param gbid The bundle the signal is for.
+   * \param succeeded If the custody was accepted.
+   */
+  void QueueCustodySignal (const BundleEndpointId& custodian, const GlobalBundleIdentifier& gbid, bool succeeded);
  private:  
 
   // Called whenever an bundle is received
@@ -135,6 +152,12 @@ public:
  // Creates an custody signal
   void GenerateCustodySignal (Ptr<Bundle> bundle, const CustodySignalReason& reason, bool status);
   bool GenerateCustodySignal (Ptr<Bundle> bundle, bool status);
+  void FlushCustodySignal (BundleEndpointId custodian, bool succeeded);
+  Ptr<Bundle> GenerateCustodySignalBundle (const BundleEndpointId& custodian, const AggregateCustodySignal& signal);
+  // Called from BundleReceivedFromConvergenceLayer when a bundle carrying custody signals is received
+  void CustodySignalBundleReception (Ptr<Bundle> bundle);
+  // Does the necessary things when the custody of a bundle we sent was accepted or refused
+  void CustodyResponseReception (const GlobalBundleIdentifier& gbid, bool succeeded);
 
   // Called when a bundle transmission should be canceled
    /**
@@ -242,6 +265,14 @@ public:
    * \return Returns if the a valid uri otherwise false.
    */
   void BundleSentFailed (const Mac48Address& address, GlobalBundleIdentifier gbid);
+  // Called by cla when a failed transfer got part of the payload through
+  /**
+   * \brief Called by the convergence layer agent when the peer kept part of a failed bundle transfer as a fragment.
+   * \param mac The mac address of the destination node.
+   * \param gbid The global bundle identifier of the sent bundle.
+   * \param payloadBytes The number of payload bytes received by the peer.
+   */
+  void BundlePartiallySent (const Mac48Address& address, GlobalBundleIdentifier gbid, uint32_t payloadBytes);
 
   // Gives a bundle to the convergence layer to send
   /**
@@ -251,6 +282,8 @@ public:
    * \return Returns if the a valid uri otherwise false.
    */
   void SendBundle (Ptr<Link> link, Ptr<Bundle> bundle);
+  // Called from the bundle router when a bundle is stored or removed, the registrations learn the free bytes
+  void BufferChanged (uint32_t freeBytes);
 
   Ptr<Node> m_node;
   Ptr<ConvergenceLayerAgent> m_cla;
@@ -258,6 +291,17 @@ public:
   int m_num_nodes;
   BundleEndpointId m_eid;
   RegistrationManager *m_registrationManager;
+  FragmentReassembler m_reassembler;
+
+  struct PendingCustodySignal
+  {
+    AggregateCustodySignal m_signal;
+    EventId m_flushEvent;
+  };
+  typedef map<pair<BundleEndpointId, bool>, PendingCustodySignal> PendingCustodySignals;
+  PendingCustodySignals m_pendingCustodySignals;
+  Time m_custodySignalDelay;
+  uint32_t m_custodySignalMaxBundles;
 
   TracedCallback<Ptr<const Bundle> > m_createLogger;
   TracedCallback<Ptr<const Bundle> > m_relayLogger;
@@ -1,10 +1,15 @@
 /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <sstream>
 
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/mobility-model.h"
 
 #include "bp-neighbourhood-detection-agent.h"
 #include "bp-bundle-router.h"
@@ -14,6 +19,8 @@
 
 #include "bp-link.h"
 #include "bp-contact.h"
+#include "bp-fragmentation.h"
+#include "bp-node-activity.h"
 
 
 int ma[400][400];
@@ -37,27 +44,72 @@ BundleRouter::GetTypeId (void)
                    UintegerValue (5000000),//5120 bytes
                    MakeUintegerAccessor (&BundleRouter::m_maxBytes),
                    MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("EvictionPolicy",
+                   "Which bundle to drop first when the buffer is full, RouterDefault keeps the order of each router",
+                   EnumValue (EVICT_ROUTER_DEFAULT),
+                   MakeEnumAccessor (&BundleRouter::m_evictionPolicy),
+                   MakeEnumChecker (EVICT_ROUTER_DEFAULT, "RouterDefault",
+                                    EVICT_DROP_OLDEST, "DropOldest",
+                                    EVICT_DROP_YOUNGEST, "DropYoungest",
+                                    EVICT_DROP_LARGEST, "DropLargest",
+                                    EVICT_SHORTEST_LIFETIME, "ShortestRemainingLifetime",
+                                    EVICT_MOST_FORWARDED, "MostForwarded",
+                                    EVICT_LOWEST_UTILITY_PER_BIT, "LowestUtilityPerBit"))
+    .AddAttribute ("ContactWindowAware",
+                   "Sets if bundles that can not be sent before the link is predicted to break shall be skipped. The hellos then carry the position and velocity of the node.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&BundleRouter::m_contactWindowAware),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ProactiveFragmentation",
+                   "Sets if a bundle that does not fit the contact window shall be split, and a fragment sized to the contact sent instead. Needs ContactWindowAware.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&BundleRouter::m_proactiveFragmentation),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MinFragmentSize",
+                   "The smallest payload, in bytes, of a proactively created fragment.",
+                   UintegerValue (512),
+                   MakeUintegerAccessor (&BundleRouter::m_minFragmentSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Send", "A bundle is handed to the convergence layer, the endpoint it is sent to and if it is router specific",
+                     MakeTraceSourceAccessor (&BundleRouter::m_sendLogger))
     .AddTraceSource ("Delete", "A data bundle have been deleted",
                      MakeTraceSourceAccessor (&BundleRouter::m_dataDeleteLogger))
     .AddTraceSource ("BundlesLeft", "Returns the bundles left in the message queue, when the router is closed",
                      MakeTraceSourceAccessor (&BundleRouter::m_bundlesLeftLogger))
     .AddTraceSource ("CancelledBundle", "A bundle has been cancelled",
                      MakeTraceSourceAccessor (&BundleRouter::m_cancelLogger))
+    .AddTraceSource ("Evicted", "A bundle has been dropped to make room for another, and the eviction policy used",
+                     MakeTraceSourceAccessor (&BundleRouter::m_evictionLogger))
+    .AddTraceSource ("ContactWindowSkip", "A bundle was not sent since it would not finish before the link breaks, and the estimated contact window",
+                     MakeTraceSourceAccessor (&BundleRouter::m_contactWindowSkipLogger))
+    .AddTraceSource ("ReactiveFragment", "A partially sent bundle was replaced by the fragment the peer did not receive, and the payload bytes the peer received",
+                     MakeTraceSourceAccessor (&BundleRouter::m_reactiveFragmentLogger))
+    .AddTraceSource ("ProactiveFragment", "A bundle was split to fit the contact window, and the payload bytes of the fragment sent",
+                     MakeTraceSourceAccessor (&BundleRouter::m_proactiveFragmentLogger))
      ;
   return tid;
 }
 
 
 BundleRouter::BundleRouter ()
-  : m_nBytes (0),
+  : m_evictionPolicy (EVICT_ROUTER_DEFAULT),
+    m_evictionIndex (),
+    m_contactWindowAware (false),
+    m_proactiveFragmentation (false),
+    m_minFragmentSize (512),
+    m_nBytes (0),
     m_nBundles (0),
     m_isSending (false),
+    m_custodyList (),
+    m_custodyListPending (),
+    m_bundlesDelivers (),
     m_bundleList (),
     m_routerSpecificList (),
     m_forwardLog (),
     m_linkManager (),
     m_node (),
     m_nda (),
+    m_nodeActivity (),
     m_eid ()
 
 {
@@ -88,11 +140,18 @@ BundleRouter::DoDispose ()
   m_bundleList.clear ();
   m_routerSpecificList.clear ();
   m_forwardLog.ClearLog ();
+  m_evictionIndex.Clear ();
+  m_spatialIndex.Clear ();
+  m_custodyList.Clear ();
+  m_custodyListPending.Clear ();
+  m_bundlesDelivers.Clear ();
   m_linkManager = 0;  
   m_node = 0;
   m_nda = 0;
+  m_nodeActivity = 0;
   m_sendCb = MakeNullCallback<void,Ptr<Link>,Ptr<Bundle> > ();
   m_cancelCb = MakeNullCallback<void, GlobalBundleIdentifier, BundleEndpointId> ();
+  m_bufferChangedCb = MakeNullCallback<void, uint32_t> ();
   Object::DoDispose ();
 }
 
@@ -108,6 +167,12 @@ BundleRouter::SetCancelTransmisisonCallback (Callback<void, GlobalBundleIdentifi
   m_cancelCb = cancelCb;
 }
 
+void
+BundleRouter::SetBufferChangedCallback (Callback<void, uint32_t> bufferChangedCb)
+{
+  m_bufferChangedCb = bufferChangedCb;
+}
+
 void
 BundleRouter::SetLinkManager (Ptr<LinkManager> contactManager)
 {
@@ -155,6 +220,12 @@ BundleRouter::SetNeighbourhoodDetectionAgent (Ptr<NeighbourhoodDetectionAgent> n
   m_nda = nda;
 }
 
+void
+BundleRouter::SetNodeActivity (Ptr<NodeActivity> activity)
+{
+  m_nodeActivity = activity;
+}
+
 Ptr<NeighbourhoodDetectionAgent>
 BundleRouter::GetNeighbourhoodDetectionAgent () const
 {
@@ -165,33 +236,28 @@ void
 BundleRouter::Init ()
 {
   NS_LOG_DEBUG("(" << m_node->GetId() << ")");
-  Callback<void, Ptr<Packet>, Address > tmp = MakeCallback (&LinkManager::DiscoveredLink, m_linkManager);
+  Callback<void, Ptr<DecodedHello>, Address > tmp = MakeCallback (&LinkManager::DiscoveredLink, m_linkManager);
   m_nda->SetDiscoveredLinkCallback (tmp);
   curTime = 2000;
   m_nda->SetSendHelloCallback(MakeCallback(&BundleRouter::DoSendHello, this));
-  m_nda->SetHandleHelloCallback(MakeCallback(&BundleRouter::DoHandleHello, this));
+  m_nda->SetHandleHelloCallback(MakeCallback(&BundleRouter::HandleHello, this));
 
   m_linkManager->SetLinkAvailableCallback (MakeCallback (&BundleRouter::LinkDiscovered, this));
   m_linkManager->SetClosedLinkCallback (MakeCallback (&BundleRouter::LinkClosed, this));
   m_linkManager->SetCreateLinkCallback (MakeCallback (&BundleRouter::CreateLink, this));
+  SyncEvictionIndex ();
   //DoInit ();
+  if (m_nodeActivity == 0)
+    {
+      m_nodeActivity = NodeActivity::Get (_mobs);
+    }
       	if( !(m_node->GetId() >= 0 && m_node->GetId() <= 2))
 	{
       	//Calculo do tempo final dos nós
-		char num[3];
-		sprintf(num,"%d",m_node->GetId());
-		string cmd = "cat ";
-		cmd+=_mobs; 
-		cmd+=" | grep \\(";
-		cmd+= num;
-		cmd+= "\\) | awk '{print $3; }' | tail -n 1 > curtime";
-		cmd+= num;
-		system(cmd.c_str());
-		string file = "curtime";
-		file+=num;
-		FILE *fp = fopen(file.c_str(),"r");
-		fscanf(fp,"%lf",&curTime);
-		fclose(fp);
+		if (!m_nodeActivity->GetEndTime (m_node->GetId (), curTime))
+		{
+			NS_LOG_WARN("(" << m_node->GetId() << ") No end time in " << _mobs);
+		}
 		//PRESTA ATENÇÃO
 
         }
@@ -202,21 +268,11 @@ BundleRouter::Init ()
       	/*Calculo do Tempo Inicial dos nós* Se não é um nó destino*/
       	if(!(m_node->GetId() >= 0 && m_node->GetId() <= 2))
       	{
-			char num[3];
-			sprintf(num,"%d",m_node->GetId());
-			string cmd = "cat ";
-			cmd+=_mobs;
-			cmd += "| grep at";
-			cmd+=" | grep \\(";
-			cmd+= num;
-			cmd+= "\\) | awk '{print $3; }' | head -n 1 > curtime";
-			cmd+= num;
-			system(cmd.c_str());
-			string file = "curtime";
-			file+=num;
-			FILE *fp = fopen(file.c_str(),"r");
-			fscanf(fp,"%lf",&initTime);
-			fclose(fp);
+			initTime = 0;
+			if (!m_nodeActivity->GetStartTime (m_node->GetId (), initTime))
+			{
+				NS_LOG_WARN("(" << m_node->GetId() << ") No start time in " << _mobs);
+			}
 			Simulator::Schedule(Seconds(1.0),&BundleRouter::CheckInit, this);
       	}
       	else{
@@ -290,12 +346,14 @@ BundleRouter::InsertBundle (Ptr<Bundle> bundle)
 
 			NS_LOG_DEBUG("(" << m_node->GetId() << ")");
 	  RemoveExpiredBundles (true);
-	  m_forwardLog.RemoveExpiredEntries ();
+	  RemoveExpiredForwardLogEntries ();
 	  if (MakeRoomForBundle (bundle))
 		{
 		  m_nBytes += bundle->GetSize ();
 		  m_nBundles++;
 		  DoInsert (bundle);
+		  m_evictionIndex.Insert (bundle, m_forwardLog.GetEntries (bundle->GetBundleId ()).size ());
+		  NotifyBufferChanged ();
 		  return true;
 		}
 
@@ -308,15 +366,271 @@ BundleRouter::DeleteBundle (const GlobalBundleIdentifier& gbid, bool drop)
 {
   Ptr<Bundle> bundle = GetBundle (gbid);
   //  cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") " << "BundleRouter::DeleteBundle " << "(" << bundle->GetPayload ()->GetSize () << " : " << bundle->GetCreationTimestampSequence ()  << ")" << " drop = " << boolalpha << drop << endl;
-  if (DoDelete (gbid,drop))
+  if (RemoveBundle (gbid, drop))
     {
       NS_LOG_DEBUG("(" << m_node->GetId() << ")" <<" Apagou Bundle");
       m_dataDeleteLogger (bundle, drop);
-      m_nBytes -= bundle->GetSize ();
-      --m_nBundles;
     }
 }
 
+bool
+BundleRouter::RemoveBundle (const GlobalBundleIdentifier& gbid, bool drop)
+{
+  Ptr<Bundle> bundle = GetBundle (gbid);
+  if (!DoDelete (gbid, drop))
+    {
+      return false;
+    }
+  m_evictionIndex.Remove (gbid);
+  m_nBytes -= bundle->GetSize ();
+  --m_nBundles;
+  NotifyBufferChanged ();
+  return true;
+}
+
+bool
+BundleRouter::ReplaceBundle (Ptr<Bundle> bundle, const BundleList& fragments)
+{
+  GlobalBundleIdentifier gbid = bundle->GetBundleId ();
+  if (!RemoveBundle (gbid, false))
+    {
+      return false;
+    }
+
+  // The peers that took the whole bundle are not offered its fragments
+  ForwardLogEntries entries = m_forwardLog.GetEntries (gbid);
+  for (BundleList::const_iterator fragment = fragments.begin (); fragment != fragments.end (); ++fragment)
+    {
+      for (ForwardLogEntries::iterator entry = entries.begin (); entry != entries.end (); ++entry)
+        {
+          m_forwardLog.AddEntry ((*fragment)->GetBundleId (), entry->GetBundleEndpoint (), entry->GetTimeToLive ());
+        }
+    }
+
+  bool inserted = true;
+  for (BundleList::const_iterator fragment = fragments.begin (); fragment != fragments.end () && inserted; ++fragment)
+    {
+      inserted = InsertBundle (*fragment) && GetBundle ((*fragment)->GetBundleId ()) == *fragment;
+    }
+  if (inserted)
+    {
+      return true;
+    }
+
+  // Roll back, the bundle is kept whole
+  for (BundleList::const_iterator fragment = fragments.begin (); fragment != fragments.end (); ++fragment)
+    {
+      if (GetBundle ((*fragment)->GetBundleId ()) == *fragment)
+        {
+          RemoveBundle ((*fragment)->GetBundleId (), false);
+        }
+      RemoveForwardLogEntries ((*fragment)->GetBundleId ());
+    }
+  InsertBundle (bundle);
+  return false;
+}
+
+bool
+BundleRouter::EvictBundlesFor (Ptr<Bundle> bundle)
+{
+  if (bundle->GetSize () >= m_maxBytes)
+    {
+      return false;
+    }
+
+  EvictionPolicy policy = GetEvictionPolicy ();
+  if (m_evictionIndex.GetPolicy () != policy)
+    {
+      SyncEvictionIndex ();
+    }
+
+  while (bundle->GetSize () >= GetFreeBytes () && !m_evictionIndex.IsEmpty ())
+    {
+      Ptr<Bundle> victim = m_evictionIndex.GetVictim ();
+      GlobalBundleIdentifier gbid = victim->GetBundleId ();
+      NS_LOG_DEBUG("(" << m_node->GetId() << ") evicting " << gbid << " (" << GetEvictionPolicyName (policy) << ")");
+      // Removed here as well, the bundle may already be gone from m_bundleList
+      m_evictionIndex.Remove (gbid);
+      m_evictionLogger (victim, policy);
+      DeleteBundle (gbid, true);
+    }
+
+  return bundle->GetSize () < GetFreeBytes ();
+}
+
+void
+BundleRouter::SyncEvictionIndex ()
+{
+  deque<uint32_t> forwarded;
+  for (BundleList::iterator iter = m_bundleList.begin (); iter != m_bundleList.end (); ++iter)
+    {
+      forwarded.push_back (m_forwardLog.GetEntries ((*iter)->GetBundleId ()).size ());
+    }
+  m_evictionIndex.SetPolicy (GetEvictionPolicy (), m_bundleList, forwarded);
+}
+
+EvictionPolicy
+BundleRouter::GetEvictionPolicy () const
+{
+  if (m_evictionPolicy == EVICT_ROUTER_DEFAULT)
+    {
+      return DoGetDefaultEvictionPolicy ();
+    }
+  return m_evictionPolicy;
+}
+
+EvictionPolicy
+BundleRouter::DoGetDefaultEvictionPolicy () const
+{
+  return EVICT_DROP_OLDEST;
+}
+
+void
+BundleRouter::AddForwardLogEntry (Ptr<Bundle> bundle, Ptr<Link> link)
+{
+  m_forwardLog.AddEntry (bundle, link);
+  m_evictionIndex.Forwarded (bundle->GetBundleId (), m_forwardLog.GetEntries (bundle->GetBundleId ()).size ());
+}
+
+void
+BundleRouter::RemoveForwardLogEntries (const GlobalBundleIdentifier& gbid)
+{
+  m_forwardLog.RemoveEntriesFor (gbid);
+  m_evictionIndex.Forwarded (gbid, 0);
+}
+
+void
+BundleRouter::RemoveExpiredForwardLogEntries ()
+{
+  m_forwardLog.RemoveExpiredEntries ();
+  if (m_evictionIndex.GetPolicy () != EVICT_MOST_FORWARDED)
+    {
+      return;
+    }
+  // Expired entries lower the counts, unchanged ranks are left in place
+  for (BundleList::iterator iter = m_bundleList.begin (); iter != m_bundleList.end (); ++iter)
+    {
+      GlobalBundleIdentifier gbid = (*iter)->GetBundleId ();
+      m_evictionIndex.Forwarded (gbid, m_forwardLog.GetEntries (gbid).size ());
+    }
+}
+
+bool
+BundleRouter::FitsContactWindow (Ptr<Link> link, Ptr<Bundle> bundle)
+{
+  if (!m_contactWindowAware || !link->HasPeerMobility ())
+    {
+      return true;
+    }
+
+  Time window = GetContactWindow (link);
+  uint32_t capacity = GetContactCapacity (window);
+  if (bundle->GetSize () <= capacity)
+    {
+      return true;
+    }
+
+  if (CanFragmentForContact (bundle, capacity))
+    {
+      // SendBundle will send a fragment sized to the contact instead
+      return true;
+    }
+
+  NS_LOG_DEBUG("(" << m_node->GetId() << ") " << bundle->GetBundleId () << " is " << bundle->GetSize () << " bytes, the contact window to (" << link->GetRemoteEndpointId ().GetId () << ") is " << window.GetSeconds () << "s or " << capacity << " bytes");
+  m_contactWindowSkipLogger (bundle, window);
+  return false;
+}
+
+Time
+BundleRouter::GetContactWindow (Ptr<Link> link) const
+{
+  Ptr<MobilityModel> mobility = m_node->GetObject<MobilityModel> ();
+  Ptr<ConvergenceLayerAgent> cla = m_node->GetObject<BundleProtocolAgent> ()->GetConvergenceLayerAgent ();
+
+  // The link manager keeps the peer mobility of the link up to date with every hello
+  return link->GetContactWindow (mobility->GetPosition (), mobility->GetVelocity (), cla->GetTransmissionRange ());
+}
+
+uint32_t
+BundleRouter::GetContactCapacity (Time window) const
+{
+  Ptr<ConvergenceLayerAgent> cla = m_node->GetObject<BundleProtocolAgent> ()->GetConvergenceLayerAgent ();
+
+  // Same estimate of the segmentation overhead as the convergence layer, 40 bytes per segment
+  double overHeadPerFragment = 40;
+  double segmentSize = cla->GetNetDevice ()->GetMtu () - overHeadPerFragment;
+  double bytes = window.GetSeconds () * cla->GetMeasuredTransmissionSpeed ().GetBitRate () / 8.0;
+  double capacity = floor (bytes * segmentSize / (segmentSize + overHeadPerFragment));
+
+  if (capacity >= numeric_limits<uint32_t>::max ())
+    {
+      return numeric_limits<uint32_t>::max ();
+    }
+  return (uint32_t) capacity;
+}
+
+bool
+BundleRouter::CanFragmentForContact (Ptr<Bundle> bundle, uint32_t capacity)
+{
+  if (!m_proactiveFragmentation || !CanFragment (bundle))
+    {
+      return false;
+    }
+  // Both parts must be at least MinFragmentSize
+  uint32_t headerSize = bundle->GetSize () - bundle->GetPayload ()->GetSize ();
+  return capacity >= headerSize + m_minFragmentSize && bundle->GetPayload ()->GetSize () >= 2 * m_minFragmentSize;
+}
+
+Ptr<Bundle>
+BundleRouter::FragmentForContact (Ptr<Link> link, Ptr<Bundle> bundle)
+{
+  // Only bundles in the buffer are split, e.g not the copies made by the bpa
+  if (!m_contactWindowAware || !link->HasPeerMobility () || GetBundle (bundle->GetBundleId ()) != bundle)
+    {
+      return bundle;
+    }
+
+  uint32_t capacity = GetContactCapacity (GetContactWindow (link));
+  if (bundle->GetSize () <= capacity || !CanFragmentForContact (bundle, capacity))
+    {
+      return bundle;
+    }
+
+  uint32_t payloadSize = bundle->GetPayload ()->GetSize ();
+  uint32_t headerSize = bundle->GetSize () - payloadSize;
+  uint32_t length = min (capacity - headerSize, payloadSize - m_minFragmentSize);
+
+  Ptr<Bundle> head = FragmentBundle (bundle, 0, length);
+  if (head->GetSize () > capacity && length - m_minFragmentSize > head->GetSize () - capacity)
+    {
+      // The fragment fields make the primary header a few bytes larger
+      length -= head->GetSize () - capacity;
+      head = FragmentBundle (bundle, 0, length);
+    }
+  Ptr<Bundle> tail = FragmentBundle (bundle, length, payloadSize - length);
+
+  // Both pieces carry a primary header, they must fit in the room the bundle
+  // leaves without evicting anything, not even one another
+  if (head->GetSize () + tail->GetSize () >= GetFreeBytes () + bundle->GetSize ())
+    {
+      NS_LOG_DEBUG ("(" << m_node->GetId () << ") no room to split " << bundle->GetBundleId ());
+      return bundle;
+    }
+
+  // Each fragment is routed on its own from here on, if one cannot be stored the whole bundle is sent instead
+  BundleList fragments;
+  fragments.push_back (head);
+  fragments.push_back (tail);
+  if (!ReplaceBundle (bundle, fragments))
+    {
+      return bundle;
+    }
+
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") " << bundle->GetBundleId () << " split at " << length << " to fit the contact to (" << link->GetRemoteEndpointId ().GetId () << ")");
+  m_proactiveFragmentLogger (bundle, length);
+  return head;
+}
+
 bool
 BundleRouter::DoDelete (const GlobalBundleIdentifier& gbid, bool drop)
 {
@@ -474,7 +788,7 @@ BundleRouter::CancelTransmission (Ptr<Bundle> bundle, Ptr<Link> link)
 void
 BundleRouter::TransmissionCancelled (const Address& address, const GlobalBundleIdentifier& gbid)
 {
-  debug << Simulator::Now ().GetSeconds () << " BundleRouter::TransmissionCancelled" << endl; // bundle " << bundle->GetPayload ()->GetSize () << " : " << bundle->GetCreationTimestampSequence ()  << ")" << endl;
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") BundleRouter::TransmissionCancelled " << gbid);
   m_isSending = false;
   DoTransmissionCancelled (address, gbid);
 }
@@ -489,19 +803,47 @@ BundleRouter::CalculateReplicationFactor (const BundlePriority& priority) const
 void
 BundleRouter::BundleSent (const Address& address, const GlobalBundleIdentifier& gbid, bool finalDelivery)
 {
-  debug << Simulator::Now ().GetSeconds () << " BundleRouter::BundleSent" << endl;
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") BundleRouter::BundleSent " << gbid);
   m_isSending = false;
+  if (GetBundle (gbid) == 0)
+    {
+      // Bundles that were never stored, e.g the custody signals, are only known
+      // to the contact, and the routers only dequeue the bundles they store
+      Ptr<Link> link = m_linkManager->FindLink (Mac48Address::ConvertFrom (address));
+      if (link != 0 && link->GetContact () != 0)
+        {
+          link->GetContact ()->DequeueBundle (gbid);
+        }
+    }
   DoBundleSent (address, gbid, finalDelivery);
 }
 
 void
 BundleRouter::BundleTransmissionFailed (const Address& address, const GlobalBundleIdentifier& gbid)
 {
-  debug << Simulator::Now ().GetSeconds () << " BundleRouter::BundleTransmissionFailed" << endl; //for bundle " << bundle->GetPayload ()->GetSize () << " : " << bundle->GetCreationTimestampSequence ()  << ") to node (" << link->GetRemoteEndpointId ().GetId () << ")" << endl;
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") BundleRouter::BundleTransmissionFailed " << gbid);
   m_isSending = false;
   DoBundleTransmissionFailed (address, gbid);
 }
 
+void
+BundleRouter::BundlePartiallySent (const Address& address, const GlobalBundleIdentifier& gbid, uint32_t payloadBytes)
+{
+  Ptr<Bundle> bundle = GetBundle (gbid);
+  if (bundle == 0 || IsRouterSpecific (bundle) || payloadBytes >= bundle->GetPayload ()->GetSize ())
+    {
+      return;
+    }
+
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") " << gbid << " partially sent, " << payloadBytes << " payload bytes received by the peer");
+  Ptr<Bundle> remainder = FragmentBundle (bundle, payloadBytes, bundle->GetPayload ()->GetSize () - payloadBytes);
+  m_reactiveFragmentLogger (bundle, payloadBytes);
+
+  BundleList fragments;
+  fragments.push_back (remainder);
+  ReplaceBundle (bundle, fragments);
+}
+
 void
 BundleRouter::HandleCustodyAcceptance (Ptr<Bundle> bundle)
 {
@@ -554,26 +896,22 @@ BundleRouter::BundleDelivered (Ptr<Bundle> bundle, bool fromAck)
 void
 BundleRouter::SendBundle (Ptr<Link> link, Ptr<Bundle> bundle)
 {
-        NS_LOG_DEBUG("(" << m_node->GetId() << ")");
-  stringstream ss;
-  stringstream payload;
-  payload << bundle->GetPayload ()->GetSize ();
-  ss << "(" << m_node->GetId () << ") " << "BundleRouter::SendBundle " << "\t(" << m_node->GetId () << ")" << " >>>>>>>>>>>>>" << "(" << bundle->GetPayload ()->GetSize () << " : " << bundle->GetCreationTimestampSequence ()  << ")";
-  for (uint32_t i = 0; i < (13 - payload.str ().size ()); ++i)
-    {
-      ss << ">";
-    }
-  ss << " (" << link->GetRemoteEndpointId ().GetSsp () << ")";
-  if (!IsRouterSpecific (bundle))
+  bool routerSpecific = IsRouterSpecific (bundle);
+  // Only formatted when the log component is enabled, sinks of Send format what they need
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") BundleRouter::SendBundle (" << bundle->GetPayload ()->GetSize () << " : " << bundle->GetCreationTimestampSequence () << ") to (" << link->GetRemoteEndpointId ().GetSsp () << ")" << (routerSpecific ? " router specific" : ""));
+
+  if (m_proactiveFragmentation && !routerSpecific)
     {
-      NS_LOG_DEBUG (ss.str ());
-      //cout << Simulator::Now ().GetSeconds () << " " << ss.str () << endl;
-      //debug <<  Simulator::Now ().GetSeconds () << " " << ss.str () << endl;
+      bundle = FragmentForContact (link, bundle);
     }
- 
-  debug <<  Simulator::Now ().GetSeconds () << " " << ss.str () << endl;
   m_isSending = true;
   Ptr<Bundle> send = DoSendBundle (link, bundle);
+  if (send == 0)
+    {
+      return;
+    }
+  // The bundle handed to the convergence layer, a fragment when the bundle was split for the contact
+  m_sendLogger (send, link->GetRemoteEndpointId (), routerSpecific);
   Simulator::ScheduleNow (&BundleRouter::NotifySend, this, link, send);
 }
 
@@ -586,6 +924,31 @@ BundleRouter::NotifySend (Ptr<Link> link, Ptr<Bundle> bundle)
   }
 }
 
+void
+BundleRouter::NotifyBufferChanged ()
+{
+  if (!m_bufferChangedCb.IsNull ())
+    {
+      m_bufferChangedCb (GetFreeBytes ());
+    }
+}
+
+void
+BundleRouter::HandleHello (Ptr<DecodedHello> hello, Address fromAddress)
+{
+  if (hello->HasMobility ())
+    {
+      if (m_spatialIndex.GetNNodes () == 0)
+        {
+          // Cells about the size of the range keeps a range query to a few cells
+          Ptr<ConvergenceLayerAgent> cla = m_node->GetObject<BundleProtocolAgent> ()->GetConvergenceLayerAgent ();
+          m_spatialIndex.Configure (max (1.0, (double) cla->GetTransmissionRange ()), Seconds (10));
+        }
+      m_spatialIndex.Update (hello->GetBundleEndpointId ().GetId (), hello->GetPosition (), hello->GetVelocity ());
+    }
+  DoHandleHello (hello, fromAddress);
+}
+
 bool
 BundleRouter::IsSending () const
 {
@@ -615,11 +978,17 @@ BundleRouter::RemoveExpiredBundles (bool IsExpire)
 
 bool
 BundleRouter::TimeExpired (Ptr<Bundle> bundle) const
+{
+  return Simulator::Now () > GetExpirationTime (bundle);
+}
+
+Time
+BundleRouter::GetExpirationTime (Ptr<Bundle> bundle) const
 {
   PrimaryBundleHeader header = bundle->GetPrimaryHeader ();
   Time lifetime = header.GetLifetime ();
   Time creationTime = header.GetCreationTimestamp ().GetTime ();
-  return Simulator::Now () > lifetime + creationTime; 
+  return lifetime + creationTime;
 }
 
 uint32_t
@@ -647,50 +1016,54 @@ BundleRouter::CreateLink (BundleEndpointId eid, Address address)
   return DoCreateLink (eid, address);
 }
 
-LinkBundleList
-BundleRouter::GetAllDeliverableBundles ()
+bool
+BundleRouter::VisitDeliverableBundles (LinkBundleVisitor& visitor)
 {
   Links links = m_linkManager->GetConnectedLinks ();
-  LinkBundleList result;
   for (Links::iterator iter = links.begin (); iter != links.end (); ++iter)
     {
-      LinkBundleList linkBundleList = GetAllBundlesForLink (*iter);
-      result.insert (result.end (), linkBundleList.begin (), linkBundleList.end ());
+      if (!VisitBundlesForLink (*iter, visitor))
+        {
+          return false;
+        }
     }
-  return result;
+  return true;
 }
 
-LinkBundleList
-BundleRouter:: GetAllBundlesForLink (Ptr<Link> link)
+bool
+BundleRouter::VisitBundlesForLink (Ptr<Link> link, LinkBundleVisitor& visitor)
 {
-  LinkBundleList linkBundleList;
   for (BundleList::iterator iter = m_bundleList.begin (); iter != m_bundleList.end (); ++iter)
     {
       if ((*iter)->HasRetentionConstraint (RC_FORWARDING_PENDING))
         {
           if (link->GetRemoteEndpointId () == (*iter)->GetDestinationEndpoint ())
             {
-              linkBundleList.push_back (LinkBundle (link, *iter));
+              if (!visitor.Visit (link, *iter))
+                {
+                  return false;
+                }
             }
         }
     }
-  return linkBundleList;
+  return true;
 }
 
-LinkBundleList
-BundleRouter:: GetAllBundlesToAllLinks ()
+bool
+BundleRouter::VisitBundlesToAllLinks (LinkBundleVisitor& visitor)
 {
   Links links = m_linkManager->GetConnectedLinks ();
-  LinkBundleList linkBundleList;
-
   for (Links::iterator iter = links.begin (); iter != links.end (); ++iter)
     {
       for (BundleList::iterator it = m_bundleList.begin (); it != m_bundleList.end (); ++it)
         {
-          linkBundleList.push_back (LinkBundle (*iter, *it));
+          if (!visitor.Visit (*iter, *it))
+            {
+              return false;
+            }
         }
     }
-  return linkBundleList;
+  return true;
 }
 
 
@@ -840,62 +1213,35 @@ void BundleRouter::SetBundleExpired(std::string protocol)
 
 bool BundleRouter::isBundleCustody(GlobalBundleIdentifier gbid)
 {
-	vector<GlobalBundleIdentifier>::iterator it;
-	for ( it=m_custodyList.begin() ; it < m_custodyList.end(); it++ )
-	{
-		if (*it == gbid)
-			return true;
-	}
-	return false;
+	return m_custodyList.Contains(gbid);
 }
-void BundleRouter::InsertCustodyHistoricalPending(GlobalBundleIdentifier gbid)
+void BundleRouter::InsertCustodyHistoricalPending(Ptr<Bundle> bundle)
 {
-	m_custodyListPending.push_back(gbid);
+	m_custodyListPending.Insert(bundle->GetBundleId(), GetExpirationTime(bundle));
 }
 
 bool BundleRouter::isBundleCustodyPending(GlobalBundleIdentifier gbid)
 {
-	vector<GlobalBundleIdentifier>::iterator it;
-	for ( it=m_custodyListPending.begin() ; it < m_custodyListPending.end(); it++ )
-	{
-		if (*it == gbid)
-			return true;
-	}
-	return false;
+	return m_custodyListPending.Contains(gbid);
 }
-void BundleRouter::InsertCustodyHistorical(GlobalBundleIdentifier gbid)
+void BundleRouter::InsertCustodyHistorical(Ptr<Bundle> bundle)
 {
-	m_custodyList.push_back(gbid);
+	m_custodyList.Insert(bundle->GetBundleId(), GetExpirationTime(bundle));
 }
 
 bool BundleRouter::isBundleDelivery(GlobalBundleIdentifier gbid)
 {
-	vector<GlobalBundleIdentifier>::iterator it;
-	for ( it=m_bundlesDelivers.begin() ; it < m_bundlesDelivers.end(); it++ )
-	{
-		if (*it == gbid)
-			return true;
-	}
-	return false;
+	return m_bundlesDelivers.Contains(gbid);
 }
-void BundleRouter::InsertBundleDelivery(GlobalBundleIdentifier gbid)
+void BundleRouter::InsertBundleDelivery(Ptr<Bundle> bundle)
 {
-	m_bundlesDelivers.push_back(gbid);
+	m_bundlesDelivers.Insert(bundle->GetBundleId(), GetExpirationTime(bundle));
 }
 
 void BundleRouter::EraseCustodyHistoricalPending(GlobalBundleIdentifier gbid)
 {
-
-	vector<GlobalBundleIdentifier>::iterator it;
-		for ( it=m_custodyListPending.begin() ; it < m_custodyListPending.end(); it++ )
-		{
-			if (*it == gbid)
-			{
-				NS_LOG_DEBUG("Remove Custodia Pendente");
-				m_custodyListPending.erase(it);
-				return;
-			}
-		}
+	NS_LOG_DEBUG("Remove Custodia Pendente");
+	m_custodyListPending.Erase(gbid);
 }
 
 
@@ -21,6 +21,10 @@
 #include "bp-global-bundle-identifier.h"
 #include "bp-custody-signal.h"
 #include "bp-forwarding-log.h"
+#include "bp-eviction-policy.h"
+#include "bp-spatial-index.h"
+#include "bp-bundle-history.h"
+#include "bp-node-activity.h"
 
 
 using namespace std;
@@ -35,8 +39,6 @@ class Contact;
 
 typedef deque<Ptr<Bundle> > BundleList;
 
-typedef vector<GlobalBundleIdentifier> CustodyHistorical;
-typedef vector<GlobalBundleIdentifier> BundlesDelivers;
 
 struct CountCopy{
       double cc[2000];
@@ -70,12 +72,45 @@ struct LinkBundle {
                 return m_bundle;
         }
 
-        bool IsNull() {
+        bool IsNull() const {
                 return (m_link == 0) || (m_bundle == 0);
         }
 };
 
-typedef deque<LinkBundle> LinkBundleList;
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief Receives the (link, bundle) candidates of a router one at a time, as
+ * they are generated, see BundleRouter::VisitDeliverableBundles.
+ */
+class LinkBundleVisitor {
+public:
+        virtual ~LinkBundleVisitor() {
+        }
+
+        /**
+         * \return false to stop the generation, e.g. once a sendable candidate is found.
+         */
+        virtual bool Visit(Ptr<Link> link, Ptr<Bundle> bundle) = 0;
+};
+
+/**
+ * \brief Keeps the first candidate and stops the generation.
+ */
+class FirstLinkBundle: public LinkBundleVisitor {
+public:
+        bool Visit(Ptr<Link> link, Ptr<Bundle> bundle) {
+                m_linkBundle = LinkBundle(link, bundle);
+                return false;
+        }
+
+        LinkBundle GetLinkBundle() const {
+                return m_linkBundle;
+        }
+
+private:
+        LinkBundle m_linkBundle;
+};
 
 /**
  * \ingroup bundleRouter
@@ -96,6 +131,11 @@ public:
         void SetBundleSendCallback(Callback<void, Ptr<Link> , Ptr<Bundle> > sendCb);
         void SetCancelTransmisisonCallback(Callback<void, GlobalBundleIdentifier,
                         BundleEndpointId> cancelCb);
+        /**
+         * \brief Sets the callback told the free bytes of the buffer whenever a bundle is stored or removed.
+         * \param bufferChangedCb The callback.
+         */
+        void SetBufferChangedCallback(Callback<void, uint32_t> bufferChangedCb);
 
         void Init();
 
@@ -108,6 +148,13 @@ public:
         void SetNode(Ptr<Node> node);
         Ptr<Node> GetNode() const;
 
+        /**
+         * \brief The start and end times of the nodes, shared by all routers.
+         *
+         * If not set, Init reads them from the mobility trace in _mobs.
+         */
+        void SetNodeActivity(Ptr<NodeActivity> activity);
+
         void SetBundleEndpointId(const BundleEndpointId& eid);
         BundleEndpointId GetBundleEndpointId() const;
 
@@ -138,6 +185,18 @@ public:
                         bool finalDelivery);
         void BundleTransmissionFailed(const Address&,
                         const GlobalBundleIdentifier& gbid);
+        /**
+         * \brief Replaces a bundle with the part of its payload the peer did not receive.
+         *
+         * The peer keeps what it received of a failed transfer as a fragment, so only
+         * the remaining payload is retained and sent from here on (RFC 5050, 5.11).
+         *
+         * \param address The address of the peer.
+         * \param gbid The bundle that was partially sent.
+         * \param payloadBytes The number of payload bytes the peer received.
+         */
+        void BundlePartiallySent(const Address& address,
+                        const GlobalBundleIdentifier& gbid, uint32_t payloadBytes);
         void BundleReceived(Ptr<Bundle> bundle);
         void BundleDelivered(Ptr<Bundle> bundle, bool fromAck);
         bool IsSending() const;
@@ -170,16 +229,17 @@ public:
         virtual void RemoveExpiredBundles(bool IsExpire);
         /* sergiosvieira */
         virtual void DoSendHello(Ptr<Socket> socket, BundleEndpointId eid) {};
-        virtual void DoHandleHello(Ptr<Socket> socket) {};
+        virtual void DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress) {};
         /* sergiosvieira */
 
         /*Joao*/
         bool isBundleCustody(GlobalBundleIdentifier gbid);
-        void InsertCustodyHistorical(GlobalBundleIdentifier gbid);
+        /* Os históricos lembram o bundle até ele expirar, criação + tempo de vida */
+        void InsertCustodyHistorical(Ptr<Bundle> bundle);
         bool isBundleDelivery(GlobalBundleIdentifier gbid);
-        void InsertBundleDelivery(GlobalBundleIdentifier gbid);
+        void InsertBundleDelivery(Ptr<Bundle> bundle);
         bool isBundleCustodyPending(GlobalBundleIdentifier gbid);
-        void InsertCustodyHistoricalPending(GlobalBundleIdentifier gbid);
+        void InsertCustodyHistoricalPending(Ptr<Bundle> bundle);
         void EraseCustodyHistoricalPending(GlobalBundleIdentifier gbid);
         void AddToList(int id, int bid);
         bool HasBundleRe(int id, int bid);
@@ -187,9 +247,13 @@ public:
         virtual void SendBundle(Ptr<Link> link, Ptr<Bundle> bundle);/*Originalmente protected*/
 private:
         void NotifySend(Ptr<Link> link, Ptr<Bundle> bundle);
+        void NotifyBufferChanged();
+        /**
+         * \brief Feeds the spatial index with the mobility in a hello before the router handles it.
+         */
+        void HandleHello(Ptr<DecodedHello> hello, Address fromAddress);
 
 protected:
-        ofstream debug; // FIXME Remove this
         virtual void DoDispose();
         /*Joao*/
         uint32_t m_count_received_replicate_bundles;
@@ -256,10 +320,83 @@ protected:
         virtual void DoHandleCustodyTransferFailure(const CustodySignal& signal,
                         bool timeout);
         virtual bool TimeExpired(Ptr<Bundle> bundle) const;
-
-        virtual LinkBundleList GetAllDeliverableBundles();
-        virtual LinkBundleList GetAllBundlesForLink(Ptr<Link> link);
-        virtual LinkBundleList GetAllBundlesToAllLinks();
+        /* Criação + tempo de vida do bundle */
+        Time GetExpirationTime(Ptr<Bundle> bundle) const;
+
+        /**
+         * \brief Drops bundles, chosen by the EvictionPolicy attribute, until there is room for bundle.
+         * \param bundle The bundle to make room for.
+         * \return Returns true if the bundle fits in the buffer, otherwise false.
+         */
+        bool EvictBundlesFor(Ptr<Bundle> bundle);
+        /* Takes a bundle out of the buffer without the DataDelete trace */
+        bool RemoveBundle(const GlobalBundleIdentifier& gbid, bool drop);
+        /**
+         * \brief Puts the fragments of a buffered bundle in its place.
+         *
+         * The forward log entries of the bundle are copied to each fragment,
+         * and no DataDelete trace fires for the bundle. If a fragment cannot
+         * be stored the fragments are removed and the bundle is put back.
+         *
+         * \return Returns true if the bundle was replaced.
+         */
+        bool ReplaceBundle(Ptr<Bundle> bundle, const BundleList& fragments);
+        /**
+         * \return The EvictionPolicy attribute, or the router's own order if it is RouterDefault.
+         */
+        EvictionPolicy GetEvictionPolicy() const;
+        virtual EvictionPolicy DoGetDefaultEvictionPolicy() const;
+        /* The forward log is changed through these so MostForwarded ranks stay current */
+        void AddForwardLogEntry(Ptr<Bundle> bundle, Ptr<Link> link);
+        void RemoveForwardLogEntries(const GlobalBundleIdentifier& gbid);
+        void RemoveExpiredForwardLogEntries();
+        void SyncEvictionIndex();
+
+        /**
+         * \brief Checks if the bundle can be sent before the link is predicted to break.
+         *
+         * The contact window is estimated from the position and velocity in the
+         * peer's last hello, and the transfer time from the data rate measured by
+         * the convergence layer.
+         *
+         * \param link The link the bundle would be sent over.
+         * \param bundle The bundle to send.
+         * \return Returns true if ContactWindowAware is off, nothing is known about the
+         * peer's mobility or the bundle is estimated to fit in the contact window.
+         */
+        bool FitsContactWindow(Ptr<Link> link, Ptr<Bundle> bundle);
+        Time GetContactWindow(Ptr<Link> link) const;
+        /**
+         * \brief The number of bundle bytes that can be sent within a contact window,
+         * at the measured data rate and minus the segmentation overhead.
+         */
+        uint32_t GetContactCapacity(Time window) const;
+        bool CanFragmentForContact(Ptr<Bundle> bundle, uint32_t capacity);
+        /**
+         * \brief Splits a buffered bundle that does not fit the contact window.
+         *
+         * The bundle is replaced in the buffer by a fragment sized to the estimated
+         * capacity of the contact and a fragment with the rest of the payload.
+         *
+         * \param link The link the bundle is about to be sent over.
+         * \param bundle The bundle to send.
+         * \return The fragment to send now, or bundle if it was not split.
+         */
+        Ptr<Bundle> FragmentForContact(Ptr<Link> link, Ptr<Bundle> bundle);
+
+        /**
+         * \brief Hands the candidates to visitor, no list of them is built.
+         *
+         * VisitDeliverableBundles visits the bundles for each connected link,
+         * VisitBundlesForLink the bundles that can go over link and
+         * VisitBundlesToAllLinks every bundle over every connected link.
+         *
+         * \return false if visitor stopped the generation, true if every
+         * candidate was visited.
+         */
+        virtual bool VisitDeliverableBundles(LinkBundleVisitor& visitor);
+        virtual bool VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor);
+        virtual bool VisitBundlesToAllLinks(LinkBundleVisitor& visitor);
 
         struct MatchingGbid: public unary_function<Ptr<Bundle> , bool> {
                 GlobalBundleIdentifier m_gbid;
@@ -275,13 +412,19 @@ protected:
 
 protected:
         uint32_t m_maxBytes;
+        EvictionPolicy m_evictionPolicy;
+        EvictionIndex m_evictionIndex;
+        SpatialIndex m_spatialIndex; // Last known mobility of other nodes, from their hellos
+        bool m_contactWindowAware;
+        bool m_proactiveFragmentation;
+        uint32_t m_minFragmentSize;
         uint32_t m_nBytes;
         uint32_t m_nBundles;
         bool m_isSending;
         /*Joao*/
-        CustodyHistorical m_custodyList;
-        CustodyHistorical m_custodyListPending;
-        BundlesDelivers  m_bundlesDelivers;
+        BundleHistory m_custodyList;
+        BundleHistory m_custodyListPending;
+        BundleHistory m_bundlesDelivers;
         /*Joao*/
         BundleList m_bundleList;
         BundleList m_routerSpecificList;
@@ -289,13 +432,20 @@ protected:
         Ptr<LinkManager> m_linkManager;
         Ptr<Node> m_node;
         Ptr<NeighbourhoodDetectionAgent> m_nda;
+        Ptr<NodeActivity> m_nodeActivity;
         BundleEndpointId m_eid;
 
         Callback<void, Ptr<Link> , Ptr<Bundle> > m_sendCb;
         Callback<void, GlobalBundleIdentifier, BundleEndpointId> m_cancelCb;
+        Callback<void, uint32_t> m_bufferChangedCb;
+        TracedCallback<Ptr<const Bundle> , const BundleEndpointId&, bool> m_sendLogger;
         TracedCallback<Ptr<const Bundle> , bool> m_dataDeleteLogger;
         TracedCallback<Ptr<const Bundle> > m_cancelLogger;
         TracedCallback<uint32_t, BundleList> m_bundlesLeftLogger;
+        TracedCallback<Ptr<const Bundle> , uint8_t> m_evictionLogger;
+        TracedCallback<Ptr<const Bundle> , Time> m_contactWindowSkipLogger;
+        TracedCallback<Ptr<const Bundle> , uint32_t> m_reactiveFragmentLogger;
+        TracedCallback<Ptr<const Bundle> , uint32_t> m_proactiveFragmentLogger;
 };
 
 }
@@ -68,7 +68,7 @@ Bundle::Bundle (Ptr<Packet> bundle)
         break;
     }
   m_payload = tmp;
-  m_gbid = GlobalBundleIdentifier (bundle);
+  UpdateBundleId ();
   //m_bundle_global_id = bundle->GetGlobalId();
 }
 
@@ -112,7 +112,21 @@ Bundle::SetPrimaryHeader (const PrimaryBundleHeader& header)
 {
   NS_LOG_DEBUG("Bundle::SetPrimaryHeader");
   m_primaryHeader = header;
-  m_gbid = GlobalBundleIdentifier (m_primaryHeader.GetSourceEndpoint (), m_primaryHeader.GetCreationTimestamp ());
+  UpdateBundleId ();
+}
+
+void
+Bundle::UpdateBundleId ()
+{
+  if (m_primaryHeader.IsFragment () && m_payload != 0)
+    {
+      m_gbid = GlobalBundleIdentifier (m_primaryHeader.GetSourceEndpoint (), m_primaryHeader.GetCreationTimestamp (),
+                                       m_primaryHeader.GetFragmentOffset (), m_payload->GetSize ());
+    }
+  else
+    {
+      m_gbid = GlobalBundleIdentifier (m_primaryHeader.GetSourceEndpoint (), m_primaryHeader.GetCreationTimestamp ());
+    }
 }
   
 PrimaryBundleHeader
@@ -204,6 +218,7 @@ Bundle::SetPayload (Ptr<Packet> payload)
 {
   NS_LOG_DEBUG("Bundle::SetPayload");
   m_payload = payload;
+  UpdateBundleId ();
 }
 
 Ptr<Packet>
@@ -385,6 +400,7 @@ void
 Bundle::SetFragment (bool val)
 {
   m_primaryHeader.SetFragment (val);
+  UpdateBundleId ();
 }
 
 bool
@@ -674,6 +690,7 @@ void
 Bundle::SetFragmentOffset (int64_t offset)
 {
   m_primaryHeader.SetFragmentOffset (offset);
+  UpdateBundleId ();
 }
 
 uint64_t
@@ -706,15 +723,6 @@ uint64_t Bundle::GetGlobalId()const
   return m_primaryHeader.GetGlobalId();
 }
 
-GlobalBundleIdentifier Bundle::GetCustody()
-{
-	return m_primaryHeader.GetCustody();
-}
-void Bundle::SetCustody(GlobalBundleIdentifier gbid)
-{
-	m_primaryHeader.SetCustody(gbid);
-}
-
 /*Joao*/
 
 
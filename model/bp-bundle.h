@@ -186,14 +186,14 @@ class Bundle : public Object
 
   uint64_t GetGlobalId()const;
   void GenerateID();
-  GlobalBundleIdentifier GetCustody();
-  void SetCustody(GlobalBundleIdentifier gbid);
 
   /*Joao*/
   bool HaveBeenReceivedFrom(const int& id);
   void AddReceivedFrom (const int& id);
   /*Joao*/
  private:
+  // Recomputes m_gbid, a fragment is also identified by its offset and length
+  void UpdateBundleId ();
 
   	PrimaryBundleHeader m_primaryHeader;
 	BlockList m_canonicalHeaders;
@@ -4,6 +4,7 @@
 #include "ns3/simulator.h"
 #include "ns3/object.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/packet-socket-factory.h"
 #include "ns3/packet-socket-address.h"
 #include "ns3/trace-source-accessor.h"
@@ -13,6 +14,7 @@
 #include "bp-convergence-layer-header.h"
 #include "bp-bundle-router.h"
 #include "bp-neighbourhood-detection-agent.h"
+#include "bp-fragmentation.h"
 
 #include <cmath>
 
@@ -95,6 +97,16 @@ ConvergenceLayerAgent::GetTypeId (void)
                    TimeValue (Seconds (0.1)),
                    MakeTimeAccessor (&ConvergenceLayerAgent::m_ackWaitTime),
                    MakeTimeChecker ())
+    .AddAttribute ("ReactiveFragmentation",
+                   "Keeps the received part of a bundle as a fragment when the link is lost in the middle of a transfer.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ConvergenceLayerAgent::m_reactiveFragmentation),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PiggybackNeighbourInfo",
+                   "Marks sent segments and acks as neighbour liveness, the receiver then refreshes its link to us and our hellos may be left out while data flows.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&ConvergenceLayerAgent::m_piggybackNeighbourInfo),
+                   MakeBooleanChecker ())
     .AddTraceSource ("AbortedDataBundle", "A data bundle tranfer has been \"aborted\".",
                      MakeTraceSourceAccessor (&ConvergenceLayerAgent::m_abortDataLogger))
     .AddTraceSource ("RealAbortedDataBundle", "A data bundle tranfer has been \"aborted\".",
@@ -146,8 +158,12 @@ ConvergenceLayerAgent::ConvergenceLayerAgent ()
     m_current (),
     m_waitingForAck (),
     m_ackTimer (Timer::CANCEL_ON_DESTROY),
+    m_reactiveFragmentation (false),
+    m_piggybackNeighbourInfo (false),
     m_recvQueue (),
-    m_started ()
+    m_started (),
+    m_segmentStarted (),
+    m_measuredRate (0)
 {}
 
 ConvergenceLayerAgent::ConvergenceLayerAgent (Ptr<Node> node, Ptr<NetDevice> device)
@@ -161,8 +177,12 @@ ConvergenceLayerAgent::ConvergenceLayerAgent (Ptr<Node> node, Ptr<NetDevice> dev
     m_current (),
     m_waitingForAck (),
     m_ackTimer (Timer::CANCEL_ON_DESTROY),
+    m_reactiveFragmentation (false),
+    m_piggybackNeighbourInfo (false),
     m_recvQueue (),
-    m_started ()
+    m_started (),
+    m_segmentStarted (),
+    m_measuredRate (0)
 {}
 
 ConvergenceLayerAgent::~ConvergenceLayerAgent ()
@@ -214,6 +234,12 @@ ConvergenceLayerAgent::SetTransmissionCancelledCallback (Callback<void, const Ma
   m_transmissionCancelledCb = transmissionCancelledCb;
 }
                                                          
+void
+ConvergenceLayerAgent::SetBundlePartiallySentCallback (Callback<void, const Mac48Address&, GlobalBundleIdentifier, uint32_t> bundlePartiallySentCb)
+{
+  m_bundlePartiallySentCb = bundlePartiallySentCb;
+}
+
 void
 ConvergenceLayerAgent::SetNode (Ptr<Node> node)
 {
@@ -262,6 +288,17 @@ ConvergenceLayerAgent::GetTransmissionSpeed () const
   return m_dataRate;
 }
 
+DataRate
+ConvergenceLayerAgent::GetMeasuredTransmissionSpeed () const
+{
+  // Until the first data segment has been sent the configured rate is the best guess
+  if (m_measuredRate == 0)
+    {
+      return m_dataRate;
+    }
+  return DataRate ((uint64_t) m_measuredRate);
+}
+
 void
 ConvergenceLayerAgent::Init ()
 {
@@ -443,7 +480,7 @@ ConvergenceLayerAgent::SendSegments ()
           m_isSending = true;
           m_startSegmentLogger (iter->m_segments.front ());
           NS_LOG_DEBUG(iter->m_destination <<" Socket SendTo");
-          m_socket->SendTo (iter->m_segments.front ()->Copy (),0, iter->m_destination);
+          m_socket->SendTo (CopySegment (*iter),0, iter->m_destination);
         }
       else if (!m_sendQueue.empty ())
         {
@@ -466,8 +503,9 @@ ConvergenceLayerAgent::SendSegments ()
                 }
                   
               m_startSegmentLogger (iter->m_segments.front ());
+              m_segmentStarted = Simulator::Now ();
               NS_LOG_DEBUG(iter->m_destination <<" Socket SendTo2");
-              m_socket->SendTo (iter->m_segments.front ()->Copy (),0, iter->m_destination);
+              m_socket->SendTo (CopySegment (*iter),0, iter->m_destination);
             }
           else if (iter->m_cancelled)
             {
@@ -542,6 +580,13 @@ ConvergenceLayerAgent::SegmentSentOk ()
   else
     {
       ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") " << "Succeeded in sending a Data segment to " << iter->m_mac << endl;
+      double elapsed = (Simulator::Now () - m_segmentStarted).GetSeconds ();
+      if (elapsed > 0)
+        {
+          // Exponentially weighted moving average over the segments, includes the mac overhead
+          double sample = (iter->m_segments.front ()->GetSize () * 8) / elapsed;
+          m_measuredRate = m_measuredRate == 0 ? sample : 0.875 * m_measuredRate + 0.125 * sample;
+        }
       iter->m_segments.pop_front ();      
       iter->ClearRetransmissions ();
 
@@ -721,8 +766,14 @@ ConvergenceLayerAgent::BundleSentFailed (const Mac48Address& address, GlobalBund
                       m_realAbortRouterLogger (bytesSent, type);
                     }
                   
+                  uint32_t delivered = GetPayloadBytesDelivered (*iter);
                   m_sendQueue.erase (iter);
                   
+                  // The delivered bytes are cut off before the router reacts to the failure
+                  if (delivered > 0 && !m_bundlePartiallySentCb.IsNull ())
+                    {
+                      m_bundlePartiallySentCb (address, gbid, delivered);
+                    }
                   if (!m_bundleSentFailedCb.IsNull ())
                     {
                       m_bundleSentFailedCb (address, gbid);
@@ -780,8 +831,14 @@ ConvergenceLayerAgent::BundleSentFailed (const Mac48Address& address, GlobalBund
               m_realAbortRouterLogger (bytesSent, type);
             }
   
+          uint32_t delivered = GetPayloadBytesDelivered (*iter);
           m_sendQueue.erase (iter);
       
+          // The delivered bytes are cut off before the router reacts to the failure
+          if (delivered > 0 && !m_bundlePartiallySentCb.IsNull ())
+            {
+              m_bundlePartiallySentCb (address, gbid, delivered);
+            }
           if (!m_bundleSentFailedCb.IsNull ())
             {
               m_bundleSentFailedCb (address, gbid);
@@ -873,6 +930,11 @@ ConvergenceLayerAgent::ReceiveSegment (Ptr<Socket> socket)
   ConvergenceLayerHeader header;
   receivedSegment->PeekHeader (header);
 
+  if (header.HasNeighbourInfo ())
+    {
+      NeighbourHeard (peerMac);
+    }
+
   if (header.GetType () == CLA_SEGMENT)
     {
       // The received packet is an segment of a bundle
@@ -1090,6 +1152,15 @@ ConvergenceLayerAgent::RemoveOrphanedSegments (Mac48Address mac)
     {
       if (iter->first.m_source == mac)
         {
+          if (m_reactiveFragmentation)
+            {
+              Ptr<Bundle> fragment = SalvageFragment (iter->second);
+              if (fragment != 0)
+                {
+                  fragment->AddReceivedFrom (EidAddress (fragment->GetCustodianEndpoint (), mac));
+                  Simulator::ScheduleNow (&ConvergenceLayerAgent::BundleReceived, this, fragment);
+                }
+            }
           m_recvQueue.erase (iter++);
         }
       else
@@ -1097,4 +1168,98 @@ ConvergenceLayerAgent::RemoveOrphanedSegments (Mac48Address mac)
     }
 }
 
-}} // namespace bundleProtocol, ns3 
+Ptr<Bundle>
+ConvergenceLayerAgent::SalvageFragment (Segments segments)
+{
+  NS_LOG_DEBUG ( " (" << m_node->GetId () << ")" <<"ConvergenceLayerAgent::SalvageFragment");
+  segments.sort (SortBySegmentNumber ());
+
+  // Only the segments received in order can be used, this is also how the
+  // sender counts the delivered bytes in GetPayloadBytesDelivered.
+  Ptr<Packet> received = Create<Packet> ();
+  uint32_t expected = 1;
+  ConvergenceLayerHeader header;
+  for (Segments::iterator iter = segments.begin (); iter != segments.end (); ++iter)
+    {
+      (*iter)->PeekHeader (header);
+      if (header.GetSegmentNumber () != expected)
+        {
+          break;
+        }
+      Ptr<Packet> segment = (*iter)->Copy ();
+      segment->RemoveAllPacketTags ();
+      segment->RemoveHeader (header);
+      received->AddAtEnd (segment);
+      ++expected;
+    }
+
+  // The bundle headers always fit in the first segment, with less than that
+  // they can not be parsed.
+  uint32_t maxSegmentSize = m_netDevice->GetMtu () - 40;
+  if (received->GetSize () < maxSegmentSize)
+    {
+      return 0;
+    }
+
+  Ptr<Bundle> partial = Create<Bundle> (received);
+  uint32_t length = partial->GetPayload ()->GetSize ();
+  if (!CanFragment (partial) || length == 0 || length >= partial->GetCanonicalHeaders ().front ().GetBlockLength ())
+    {
+      return 0;
+    }
+
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") Salvaged " << length << " payload bytes of " << partial->GetBundleId ());
+  return FragmentBundle (partial, 0, length);
+}
+
+uint32_t
+ConvergenceLayerAgent::GetPayloadBytesDelivered (const SendQueueElement& sqe) const
+{
+  if (!m_reactiveFragmentation || sqe.m_sqeType != SQE_DATA_BUNDLE || sqe.m_segments.empty () || !CanFragment (sqe.m_bundle))
+    {
+      return 0;
+    }
+
+  // Every segment before the current one has been acked by the mac layer
+  ConvergenceLayerHeader header;
+  sqe.m_segments.front ()->PeekHeader (header);
+  uint32_t delivered = header.GetNumberOfSegments () - sqe.m_segments.size ();
+  uint32_t maxSegmentSize = m_netDevice->GetMtu () - 40;
+  uint32_t headerSize = sqe.m_bundle->GetSize () - sqe.m_bundle->GetPayload ()->GetSize ();
+
+  // Same rule as SalvageFragment, the receiver needs the whole first segment
+  if (delivered == 0 || delivered * maxSegmentSize <= headerSize)
+    {
+      return 0;
+    }
+  return delivered * maxSegmentSize - headerSize;
+}
+
+Ptr<Packet>
+ConvergenceLayerAgent::CopySegment (const SendQueueElement& sqe)
+{
+  Ptr<Packet> segment = sqe.m_segments.front ()->Copy ();
+  if (!m_piggybackNeighbourInfo)
+    {
+      return segment;
+    }
+
+  // The flag lives in the type byte, so the segment size is unchanged
+  ConvergenceLayerHeader header;
+  segment->RemoveHeader (header);
+  header.SetNeighbourInfo (true);
+  segment->AddHeader (header);
+
+  Ptr<NeighbourhoodDetectionAgent> nda = m_node->GetObject<BundleProtocolAgent> ()->GetBundleRouter ()->GetNeighbourhoodDetectionAgent ();
+  nda->NotifyPiggybacked (sqe.m_mac);
+  return segment;
+}
+
+void
+ConvergenceLayerAgent::NeighbourHeard (const Mac48Address& address)
+{
+  Ptr<BundleRouter> br = m_node->GetObject<BundleProtocolAgent> ()->GetBundleRouter ();
+  br->GetLinkManager ()->RefreshLink (address);
+}
+
+}} // namespace bundleProtocol, ns3
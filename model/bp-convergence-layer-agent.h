@@ -168,6 +168,13 @@ public:
   void SetBundleSentOkCallback (Callback<void, const Mac48Address&, GlobalBundleIdentifier, bool> bundleSentOkCb);
   void SetBundleSentFailedCallback (Callback<void, const Mac48Address&, GlobalBundleIdentifier> bundleSentFailedCb);
   void SetTransmissionCancelledCallback (Callback<void, const Mac48Address&, GlobalBundleIdentifier > transmissionCancelledCb);
+  /**
+   * \brief Sets the callback used when a failed bundle transfer got part of the payload through.
+   *
+   * Called after the sent failed callback with the number of payload bytes the peer
+   * has received, these are kept by the peer as a fragment.
+   */
+  void SetBundlePartiallySentCallback (Callback<void, const Mac48Address&, GlobalBundleIdentifier, uint32_t> bundlePartiallySentCb);
 
   void SetNode (Ptr<Node> node);
   Ptr<Node> GetNode () const;
@@ -179,6 +186,11 @@ public:
   uint32_t GetTransmissionRange () const;
   void SetTransmissionSpeed (const DataRate& dataRate);
   DataRate GetTransmissionSpeed () const;
+  /**
+   * \brief The data rate measured over the data segments sent so far.
+   * \return The measured rate, or the DataRate attribute if nothing has been sent yet.
+   */
+  DataRate GetMeasuredTransmissionSpeed () const;
 
   void Init ();
   void Stop ();
@@ -211,6 +223,14 @@ private:
   void RemoveOrphanedSegments (Mac48Address mac);
   void Retransmit ();
 
+  // Reactive fragmentation
+  Ptr<Bundle> SalvageFragment (Segments segments);
+  uint32_t GetPayloadBytesDelivered (const SendQueueElement& sqe) const;
+
+  // Neighbour info piggybacked on segments and acks
+  Ptr<Packet> CopySegment (const SendQueueElement& sqe);
+  void NeighbourHeard (const Mac48Address& address);
+
   Ptr<Node> m_node;
   Ptr<NetDevice> m_netDevice;
   Ptr<Socket> m_socket;
@@ -226,6 +246,8 @@ private:
   SendQueueElement m_waitingForAck;
   Timer m_ackTimer;
   Time m_ackWaitTime;
+  bool m_reactiveFragmentation;
+  bool m_piggybackNeighbourInfo;
 
   map<SegmentsId, Segments> m_recvQueue;
 
@@ -233,6 +255,7 @@ private:
   Callback<void, const Mac48Address&, GlobalBundleIdentifier, bool> m_bundleSentOkCb;
   Callback<void, const Mac48Address&, GlobalBundleIdentifier> m_bundleSentFailedCb;
   Callback<void, const Mac48Address&, GlobalBundleIdentifier > m_transmissionCancelledCb;
+  Callback<void, const Mac48Address&, GlobalBundleIdentifier, uint32_t> m_bundlePartiallySentCb;
 
   // Traced callbacks used to log intresseting information
   TracedCallback<Ptr<const Bundle> > m_startDataLogger;
@@ -251,6 +274,8 @@ private:
   TracedCallback<uint32_t,uint8_t> m_realRouterDeliveryLogger;
   TracedCallback<Time, bool> m_ackLogger;
   Time m_started;
+  Time m_segmentStarted;
+  double m_measuredRate; // bits per second
   
   //              From       To          The bundle     Estimated send time
   TracedCallback<uint32_t, uint32_t, Ptr<const Bundle>, Time> m_sendBundleLogger;
@@ -5,6 +5,8 @@
 namespace ns3 {
 namespace bundleProtocol {
 
+static const uint8_t NEIGHBOUR_INFO_FLAG = 0x80;
+
 NS_OBJECT_ENSURE_REGISTERED (ConvergenceLayerHeader);
 
 TypeId
@@ -30,11 +32,13 @@ ConvergenceLayerHeader::ConvergenceLayerHeader ()
     m_sequenceNumber (0),
     m_startFlag (false),
     m_endFlag (false),
-    m_response (ACK_FAILED)
+    m_response (ACK_FAILED),
+    m_neighbourInfo (false)
 {}
 
 ConvergenceLayerHeader::ConvergenceLayerHeader (ClaHeaderType type)
-  : m_type (type)
+  : m_type (type),
+    m_neighbourInfo (false)
 {}
     
 ConvergenceLayerHeader::~ConvergenceLayerHeader() 
@@ -124,6 +128,18 @@ ConvergenceLayerHeader::GetResponse () const
   return m_response;
 }
 
+void
+ConvergenceLayerHeader::SetNeighbourInfo (bool val)
+{
+  m_neighbourInfo = val;
+}
+
+bool
+ConvergenceLayerHeader::HasNeighbourInfo () const
+{
+  return m_neighbourInfo;
+}
+
 string
 ReasonToString (const AckResponse& reason)
 {
@@ -146,6 +162,10 @@ void
 ConvergenceLayerHeader::Print (std::ostream &os) const
 {
   os << "Header type: " << (uint32_t) m_type << endl;
+  if (m_neighbourInfo)
+    {
+      os << "Carries neighbour info" << endl;
+    }
   if (m_type == CLA_SEGMENT)
     {
       os << "Segment " << m_segmentNumber << " of " << m_nSegments << endl;
@@ -178,7 +198,7 @@ void
 ConvergenceLayerHeader::Serialize (Buffer::Iterator start) const
 {
   Buffer::Iterator i = start;
-  i.WriteU8 ((uint8_t) m_type);
+  i.WriteU8 ((uint8_t) m_type | (m_neighbourInfo ? NEIGHBOUR_INFO_FLAG : 0));
 
  if (m_type == CLA_SEGMENT)
     {
@@ -196,7 +216,9 @@ uint32_t
 ConvergenceLayerHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
-  m_type = (ClaHeaderType) i.ReadU8 ();
+  uint8_t type = i.ReadU8 ();
+  m_neighbourInfo = (type & NEIGHBOUR_INFO_FLAG) != 0;
+  m_type = (ClaHeaderType) (type & ~NEIGHBOUR_INFO_FLAG);
 
   if (m_type == CLA_SEGMENT)
     {
@@ -66,6 +66,16 @@ public:
   void SetResponse (AckResponse response);
   AckResponse GetResponse () const;
 
+  /**
+   * \brief Marks the segment, or ack, as carrying neighbour liveness.
+   *
+   * The extension is a flag in the type byte and adds no bytes to the header. A
+   * receiver can treat a marked segment as a hello from the sender, i.e the
+   * sender is still in range and relies on its data to keep the link alive.
+   */
+  void SetNeighbourInfo (bool val);
+  bool HasNeighbourInfo () const;
+
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
   virtual void Print (std::ostream &os) const;
@@ -83,6 +93,7 @@ private:
   bool m_endFlag; // 0
 
   AckResponse m_response; // 1
+  bool m_neighbourInfo; // 0, high bit of the type
 };
 }} // namespace bundleProtocol, ns3
 
@@ -1,5 +1,7 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
+#include "ns3/assert.h"
+
 #include "bp-administrative-record.h"
 #include "bp-custody-signal.h"
 #include "bp-sdnv.h"
@@ -278,4 +280,59 @@ CustodySignal::Deserialize (uint8_t const*buffer)
   return custodySignal;
 }
 
+void
+CustodySignal::Serialize (Buffer::Iterator& start) const
+{
+  this->AdministrativeRecord::Serialize (start);
+
+  start.WriteU8 ((m_succeeded << 7) | m_reason);
+
+  if (m_flag == RECORD_IS_FOR_A_FRAGMENT)
+    {
+      Sdnv::Encode (m_fragmentOffset, start);
+      Sdnv::Encode (m_fragmentLength, start);
+    }
+
+  Sdnv::Encode (m_creationTimestamp.GetSeconds (), start);
+  Sdnv::Encode (m_creationTimestamp.GetSequence (), start);
+  Sdnv::Encode (m_sourceEndpointLength, start);
+
+  uint8_t eid[4];
+  NS_ASSERT (m_sourceEndpoint.GetSerializedSize () == sizeof (eid));
+  m_sourceEndpoint.Serialize (eid);
+  start.Write (eid, sizeof (eid));
+}
+
+CustodySignal
+CustodySignal::Deserialize (Buffer::Iterator& start)
+{
+  AdministrativeRecord adminRecord = AdministrativeRecord::Deserialize (start);
+
+  CustodySignal custodySignal = CustodySignal ();
+  custodySignal.SetRecordType (adminRecord.GetRecordType ());
+  custodySignal.SetAdminRecordFlag (adminRecord.GetAdminRecordFlag ());
+
+  uint8_t status = start.ReadU8 ();
+  custodySignal.SetCustodyTransferSucceeded ((status & 0x80) == 0x80);
+  custodySignal.SetReasonCode ((CustodySignalReason) (status & 0x7F));
+
+  if (custodySignal.GetAdminRecordFlag () == RECORD_IS_FOR_A_FRAGMENT)
+    {
+      custodySignal.SetFragmentOffset (Sdnv::Decode (start));
+      custodySignal.SetFragmentLength (Sdnv::Decode (start));
+    }
+
+  uint64_t time = Sdnv::Decode (start);
+  uint64_t sequence = Sdnv::Decode (start);
+  custodySignal.SetCreationTimestamp (CreationTimestamp (time,sequence));
+
+  custodySignal.SetSourceBundleEndpointIdLength (Sdnv::Decode (start));
+
+  uint8_t eid[4];
+  start.Read (eid, sizeof (eid));
+  custodySignal.SetSourceBundleEndpointId (BundleEndpointId::Deserialize (eid));
+
+  return custodySignal;
+}
+
 }} // Namespace bundleProtocol, ns3
@@ -64,8 +64,11 @@ public:
   uint32_t GetSerializedSize (void) const;
   void Serialize (uint8_t *buffer) const;
   static CustodySignal Deserialize (uint8_t const*buffer);
+  void Serialize (Buffer::Iterator& start) const;
+  static CustodySignal Deserialize (Buffer::Iterator& start);
 
 private:
+  friend class AdministrativeRecordHeader;
   CustodySignal ();
   bool m_succeeded;
   CustodySignalReason m_reason;
@@ -29,6 +29,8 @@ DataGatherer::DataGatherer (string experimentName, uint32_t nNodes)
 
     m_removed (0), m_removedPerUtility (), m_removedUtility (0), m_removedSize (0), m_removedSizeWith (0), 
 
+    m_evicted (0), m_evictedPerPolicy (),
+
     m_startedData (0), m_startedDataPerUtility (), m_startedDataUtility (0), m_startedDataSize (0), m_startedDataSizeWith (0),  m_startedDataSizeReal (0),
 
     m_abortedData (0), m_abortedDataPerUtility (), m_abortedDataUtility (0), m_abortedDataSize (0), m_abortedDataSizeWith (0), m_abortedDataSizeReal (0),
@@ -112,6 +114,8 @@ DataGatherer::DataGatherer (string experimentName, uint32_t nNodes, int point, i
 
     m_removed (0), m_removedPerUtility (), m_removedUtility (0), m_removedSize (0), m_removedSizeWith (0), 
 
+    m_evicted (0), m_evictedPerPolicy (),
+
     m_startedData (0), m_startedDataPerUtility (), m_startedDataUtility (0), m_startedDataSize (0), m_startedDataSizeWith (0),  m_startedDataSizeReal (0),
 
     m_abortedData (0), m_abortedDataPerUtility (), m_abortedDataUtility (0), m_abortedDataSize (0), m_abortedDataSizeWith (0), m_abortedDataSizeReal (0),
@@ -206,6 +210,7 @@ DataGatherer::~DataGatherer ()
   m_droppedPerUtility.clear ();
   m_neverReplicatedPerUtility.clear ();
   m_removedPerUtility.clear ();
+  m_evictedPerPolicy.clear ();
   m_startedDataPerUtility.clear ();
   m_abortedDataPerUtility.clear ();
   m_openContactWindowList.clear ();
@@ -370,6 +375,13 @@ DataGatherer::Removed (Ptr<const Bundle> bundle, bool dropped)
     }
 }
 
+void
+DataGatherer::Evicted (Ptr<const Bundle> bundle, uint8_t policy)
+{
+  ++m_evicted;
+  Increase (policy, m_evictedPerPolicy);
+}
+
 void
 DataGatherer::StartedData (Ptr<const Bundle> bundle)
 {
@@ -878,6 +890,11 @@ DataGatherer::GenerateResult ()
   m_measure << "Dropped: " << m_dropped << endl;
   m_measure << "DroppedAndNeverReplicated: " << m_neverReplicated << endl;
   m_measure << "Removed: " << m_removed << endl;
+  m_measure << "Evicted: " << m_evicted << endl;
+  for (IntPerPolicy::iterator iter = m_evictedPerPolicy.begin (); iter != m_evictedPerPolicy.end (); ++iter)
+    {
+      m_measure << "Evicted (" << GetEvictionPolicyName (iter->first) << "): " << iter->second << endl;
+    }
   m_measure << "StartedData: " << m_startedData << endl;
   m_measure << "Cancelled Data: " << m_cancelledData << endl;
   m_measure << "AbortedData: " << m_abortedData << endl;
@@ -37,6 +37,7 @@ typedef pair<double,double> GnuplotData;
 
 typedef deque<Time> LatencyList;
 typedef map<uint8_t, uint32_t> IntPerUtility;
+typedef map<uint8_t, uint32_t> IntPerPolicy;
 typedef map<uint8_t, LatencyList> LatenciesPerUtility;
 
 typedef pair<Bundle,Time> blPair;
@@ -263,6 +264,7 @@ public:
   void RealRelayed (uint32_t size);
   void RedundantRelay (Ptr<const Bundle> bundle);
   void Removed (Ptr<const Bundle> bundle, bool dropped);
+  void Evicted (Ptr<const Bundle> bundle, uint8_t policy);
   void StartedData (Ptr<const Bundle> bundle);
   void RealStartedData (uint32_t realStarted);
   void AbortedData (uint32_t headerSize, uint32_t payloadSize , uint8_t  utility);
@@ -359,6 +361,9 @@ public:
   uint32_t m_removedSize;
   uint32_t m_removedSizeWith;
 
+  uint32_t m_evicted;
+  IntPerPolicy m_evictedPerPolicy;
+
   uint32_t m_startedData;
   IntPerUtility m_startedDataPerUtility;
   uint32_t m_startedDataUtility;
@@ -27,6 +27,9 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (DirectDeliveryRouter);
 
+/* Direct Link Type */
+static HelloDecoderRegistrar g_directDeliveryHelloDecoder (3, &DecodeHello<NeighHeader>);
+
 TypeId
 DirectDeliveryRouter::GetTypeId (void)
 {
@@ -169,7 +172,7 @@ DirectDeliveryRouter::DoBundleSent (const Address& address, const GlobalBundleId
           link->GetContact ()->ResetRetransmissions ();
         }
 
-      m_forwardLog.AddEntry (bundle, link);
+      AddForwardLogEntry (bundle, link);
       
       if (finalDelivery)
         {
@@ -257,26 +260,14 @@ DirectDeliveryRouter::CanMakeRoomForBundle (Ptr<Bundle> bundle)
 bool
 DirectDeliveryRouter::MakeRoomForBundle (Ptr<Bundle> bundle)
 {
-  if (bundle->GetSize () < m_maxBytes)
-    {
-      if (bundle->GetSize () < GetFreeBytes ())
-        {
-          return true;
-        }
-
-      for (BundleList::reverse_iterator iter = m_bundleList.rbegin (); iter != m_bundleList.rend ();)
-        {
-          Ptr<Bundle> currentBundle = *(iter++);
-
-          DeleteBundle (currentBundle,true);
-          if (bundle->GetSize () < GetFreeBytes ())
-            {
-              return true;
-            }
-        }
-    }
+  return EvictBundlesFor (bundle);
+}
 
-  return false;
+EvictionPolicy
+DirectDeliveryRouter::DoGetDefaultEvictionPolicy () const
+{
+  // The last bundles received were always dropped first
+  return EVICT_DROP_YOUNGEST;
 }
 
 bool
@@ -310,7 +301,7 @@ DirectDeliveryRouter::TryToStartSending ()
 {
 	NS_LOG_DEBUG("(" << m_node->GetId() << ")");
   RemoveExpiredBundles (true);
-  m_forwardLog.RemoveExpiredEntries ();
+  RemoveExpiredForwardLogEntries ();
   
   if (!IsSending () && (GetNBundles () > 0))
     {
@@ -334,14 +325,14 @@ DirectDeliveryRouter::FindNextToSend ()
   if ((m_linkManager->GetConnectedLinks ().size () > 0) && (GetNBundles () > 0))
     {
 	  NS_LOG_DEBUG("(" << m_node->GetId() << ") connected links > 0 and getnbundle > 0");
-      LinkBundleList linkBundleList = GetAllDeliverableBundles ();
+      FirstLinkBundle first;
       
-      if (!linkBundleList.empty ())
+      if (!VisitDeliverableBundles (first))
         {
-    	  NS_LOG_DEBUG("(" << m_node->GetId() << ") list not empty");
-          return linkBundleList.front ();
+    	  NS_LOG_DEBUG("(" << m_node->GetId() << ") found a bundle");
+          return first.GetLinkBundle ();
         } else {
-        	NS_LOG_DEBUG("(" << m_node->GetId() << ") list empty");
+        	NS_LOG_DEBUG("(" << m_node->GetId() << ") no bundle found");
         }
     }
   NS_LOG_DEBUG("(" << m_node->GetId() << ") connected links < 0 and getnbundle < 0");
@@ -355,24 +346,8 @@ DirectDeliveryRouter::GetNextRouterSpecific ()
   return LinkBundle (0,0);
 }
 
-LinkBundleList
-DirectDeliveryRouter::GetAllDeliverableBundles ()
-{
-  Links links = m_linkManager->GetConnectedLinks ();
-  NS_LOG_DEBUG("(" << m_node->GetId() << ") links = " << links.size());
-  LinkBundleList result;
-  for (Links::iterator iter = links.begin (); iter != links.end (); ++iter)
-    {
-      Ptr<Link> link = *iter;
-      LinkBundleList linkBundleList = GetAllBundlesForLink (link);
-      result.insert (result.end (), linkBundleList.begin (), linkBundleList.end ());
-    }
-  return result;
-}
-
-LinkBundleList
-DirectDeliveryRouter::GetAllBundlesForLink(Ptr<Link> link) {
-	LinkBundleList linkBundleList;
+bool
+DirectDeliveryRouter::VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor) {
 	if (link->GetState() == LINK_CONNECTED) {
 		NS_LOG_DEBUG("(" << m_node->GetId() << ") LINK CONNECTED");
 		for (BundleList::iterator iter = m_bundleList.begin(); iter
@@ -387,16 +362,19 @@ DirectDeliveryRouter::GetAllBundlesForLink(Ptr<Link> link) {
 					&& !bundle->HaveBeenReceivedFrom(link)
 					&& (link->GetRemoteEndpointId()
 							== bundle->GetDestinationEndpoint())
-					&& !m_forwardLog.HasEntry(bundle, link)) {
+					&& !m_forwardLog.HasEntry(bundle, link)
+					&& FitsContactWindow(link, bundle)) {
 				NS_LOG_DEBUG("(" << m_node->GetId() << ") HAS RETENTION");
-				linkBundleList.push_back(LinkBundle(link, *iter));
+				if (!visitor.Visit(link, bundle)) {
+					return false;
+				}
 			} else {
 				NS_LOG_DEBUG("(" << m_node->GetId() << ") NOT HAS RETENTION");
 			}
 		}
 
 	}
-	return linkBundleList;
+	return true;
 }
 
 uint8_t
@@ -471,6 +449,10 @@ DirectDeliveryRouter::DoCreateLink (const BundleEndpointId& eid, const Address&
 void DirectDeliveryRouter::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid) {
 	NeighHeader header;
 	header.SetBundleEndpointId(m_eid);
+	if (m_contactWindowAware) {
+		Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
+		header.SetMobility(mm->GetPosition(), mm->GetVelocity());
+	}
 
 	/* Direct Link Type */
 	TypeTag type(3);
@@ -484,23 +466,11 @@ void DirectDeliveryRouter::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid)
 	socket->Send(hello);
 }
 
-void DirectDeliveryRouter::DoHandleHello(Ptr<Socket> socket) {
+void DirectDeliveryRouter::DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress) {
 	Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
 	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - " << mm->GetPosition ());
 
-	Ptr<Packet> receivedHello;
-	Address fromAddress;
-	receivedHello = socket->RecvFrom(fromAddress);
-
-	NeighHeader header;
-	receivedHello->PeekHeader(header);
-
-	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << header.GetBundleEndpointId());
-
-
-	Simulator::ScheduleNow(&NeighbourhoodDetectionAgent::NotifyDiscoveredLink,
-			m_nda, receivedHello, fromAddress);
-
+	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << hello->GetBundleEndpointId());
 }
 ;
 
@@ -60,6 +60,7 @@ private:
   bool DoCanDeleteBundle (const GlobalBundleIdentifier& gbid);
   void DoInsert (Ptr<Bundle> bundle);
   bool MakeRoomForBundle (Ptr<Bundle> bundle);
+  EvictionPolicy DoGetDefaultEvictionPolicy () const;
   bool DoDelete (const GlobalBundleIdentifier& gbid, bool drop);
   bool CanMakeRoomForBundle (Ptr<Bundle> bundle);
   void DoCancelTransmission (Ptr<Bundle> bundle, Ptr<Link> link);
@@ -72,11 +73,10 @@ private:
 
   /* sergiosvieira */
   void DoSendHello(Ptr<Socket> socket, BundleEndpointId eid) ;
-  void DoHandleHello(Ptr<Socket> socket);
+  void DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress);
   /* sergiosvieira */
 
-  LinkBundleList GetAllDeliverableBundles ();
-  LinkBundleList GetAllBundlesForLink (Ptr<Link> link);
+  bool VisitBundlesForLink (Ptr<Link> link, LinkBundleVisitor& visitor);
   LinkBundle GetNextRouterSpecific ();
 
   // Orwar specific
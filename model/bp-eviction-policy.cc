@@ -0,0 +1,170 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+
+#include "bp-eviction-policy.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+NS_LOG_COMPONENT_DEFINE ("EvictionIndex");
+
+string
+GetEvictionPolicyName (uint8_t policy)
+{
+  switch (policy)
+    {
+    case EVICT_DROP_OLDEST:
+      return "DropOldest";
+    case EVICT_DROP_YOUNGEST:
+      return "DropYoungest";
+    case EVICT_DROP_LARGEST:
+      return "DropLargest";
+    case EVICT_SHORTEST_LIFETIME:
+      return "ShortestRemainingLifetime";
+    case EVICT_MOST_FORWARDED:
+      return "MostForwarded";
+    case EVICT_LOWEST_UTILITY_PER_BIT:
+      return "LowestUtilityPerBit";
+    case EVICT_ROUTER_DEFAULT:
+      return "RouterDefault";
+    default:
+      return "Unknown";
+    }
+}
+
+EvictionIndex::EvictionIndex ()
+  : m_policy (EVICT_DROP_OLDEST),
+    m_seq (0),
+    m_ranked (),
+    m_lookup ()
+{}
+
+EvictionIndex::~EvictionIndex ()
+{
+  Clear ();
+}
+
+void
+EvictionIndex::SetPolicy (EvictionPolicy policy, const deque<Ptr<Bundle> >& bundles, const deque<uint32_t>& forwarded)
+{
+  NS_LOG_DEBUG ("EvictionIndex::SetPolicy " << GetEvictionPolicyName (policy));
+  m_policy = policy;
+  Clear ();
+  for (uint32_t i = 0; i < bundles.size (); ++i)
+    {
+      Insert (bundles[i], i < forwarded.size () ? forwarded[i] : 0);
+    }
+}
+
+EvictionPolicy
+EvictionIndex::GetPolicy () const
+{
+  return m_policy;
+}
+
+double
+EvictionIndex::Rank (Ptr<Bundle> bundle, uint64_t seq, uint32_t forwarded) const
+{
+  switch (m_policy)
+    {
+    case EVICT_DROP_YOUNGEST:
+      return - (double) seq;
+    case EVICT_DROP_LARGEST:
+      return - (double) bundle->GetSize ();
+    case EVICT_SHORTEST_LIFETIME:
+      return (bundle->GetCreationTimestamp ().GetTime () + bundle->GetLifetime ()).GetSeconds ();
+    case EVICT_MOST_FORWARDED:
+      return - (double) forwarded;
+    case EVICT_LOWEST_UTILITY_PER_BIT:
+      return bundle->GetPriority () / (double) bundle->GetSize ();
+    case EVICT_DROP_OLDEST:
+    default:
+      // Only the insertion order matters
+      return 0;
+    }
+}
+
+void
+EvictionIndex::Insert (Ptr<Bundle> bundle, uint32_t forwarded)
+{
+  GlobalBundleIdentifier gbid = bundle->GetBundleId ();
+  Remove (gbid);
+
+  IndexKey key (Rank (bundle, m_seq, forwarded), m_seq);
+  ++m_seq;
+  m_ranked.insert (make_pair (key, bundle));
+  m_lookup.insert (make_pair (gbid, key));
+}
+
+void
+EvictionIndex::Remove (const GlobalBundleIdentifier& gbid)
+{
+  KeyLookup::iterator iter = m_lookup.find (gbid);
+  if (iter != m_lookup.end ())
+    {
+      m_ranked.erase (iter->second);
+      m_lookup.erase (iter);
+    }
+}
+
+void
+EvictionIndex::Forwarded (const GlobalBundleIdentifier& gbid, uint32_t forwarded)
+{
+  if (m_policy != EVICT_MOST_FORWARDED)
+    {
+      return;
+    }
+
+  KeyLookup::iterator iter = m_lookup.find (gbid);
+  if (iter == m_lookup.end ())
+    {
+      return;
+    }
+
+  RankedBundles::iterator ranked = m_ranked.find (iter->second);
+  Ptr<Bundle> bundle = ranked->second;
+  // Keep the original sequence number so ties are still resolved oldest first
+  IndexKey key (Rank (bundle, iter->second.m_seq, forwarded), iter->second.m_seq);
+  if (key.m_rank == iter->second.m_rank)
+    {
+      return;
+    }
+  m_ranked.erase (ranked);
+  m_ranked.insert (make_pair (key, bundle));
+  iter->second = key;
+}
+
+Ptr<Bundle>
+EvictionIndex::GetVictim () const
+{
+  if (m_ranked.empty ())
+    {
+      return 0;
+    }
+  return m_ranked.begin ()->second;
+}
+
+uint32_t
+EvictionIndex::GetNBundles () const
+{
+  return m_lookup.size ();
+}
+
+bool
+EvictionIndex::IsEmpty () const
+{
+  return m_ranked.empty ();
+}
+
+void
+EvictionIndex::Clear ()
+{
+  m_ranked.clear ();
+  m_lookup.clear ();
+}
+
+}} // namespace bundleProtocol, ns3
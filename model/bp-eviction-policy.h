@@ -0,0 +1,119 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_EVICTION_POLICY_H
+#define BP_EVICTION_POLICY_H
+
+#include <map>
+#include <deque>
+#include <string>
+#include <stdint.h>
+
+#include "ns3/ptr.h"
+
+#include "bp-bundle.h"
+#include "bp-global-bundle-identifier.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief The rule used to choose which bundle to drop when the buffer is full.
+ */
+enum EvictionPolicy
+{
+  EVICT_DROP_OLDEST = 0,         /**< First received is dropped first (the old behaviour) */
+  EVICT_DROP_YOUNGEST,           /**< Last received is dropped first */
+  EVICT_DROP_LARGEST,            /**< The largest bundle is dropped first */
+  EVICT_SHORTEST_LIFETIME,       /**< The bundle closest to expire is dropped first */
+  EVICT_MOST_FORWARDED,          /**< The bundle with most entries in the forward log is dropped first */
+  EVICT_LOWEST_UTILITY_PER_BIT,  /**< The bundle with the lowest priority per byte is dropped first */
+  EVICT_N_POLICIES,
+  EVICT_ROUTER_DEFAULT = 255     /**< The order each router used before the policies, see BundleRouter::DoGetDefaultEvictionPolicy */
+};
+
+string GetEvictionPolicyName (uint8_t policy);
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief A secondary index over the bundles in a router's buffer, ordered
+ * according to an EvictionPolicy.
+ *
+ * Insert, Remove, Forwarded and GetVictim are all O(log n), so making room
+ * for a new bundle no longer requires a scan of the whole buffer.
+ */
+class EvictionIndex
+{
+ public:
+  EvictionIndex ();
+  ~EvictionIndex ();
+
+  /**
+   * \brief Changes the policy, the index is rebuilt from the given bundles.
+   * \param policy The new policy.
+   * \param bundles The bundles currently stored by the router, oldest first.
+   * \param forwarded The number of times each bundle has been forwarded, same order as bundles.
+   */
+  void SetPolicy (EvictionPolicy policy, const deque<Ptr<Bundle> >& bundles, const deque<uint32_t>& forwarded);
+  EvictionPolicy GetPolicy () const;
+
+  void Insert (Ptr<Bundle> bundle, uint32_t forwarded);
+  void Remove (const GlobalBundleIdentifier& gbid);
+  /**
+   * \brief Updates the rank of a bundle whose number of forwards has changed.
+   * \param gbid The bundle.
+   * \param forwarded The new number of times the bundle has been forwarded.
+   */
+  void Forwarded (const GlobalBundleIdentifier& gbid, uint32_t forwarded);
+
+  /**
+   * \return The bundle that should be dropped next, or 0 if the index is empty.
+   */
+  Ptr<Bundle> GetVictim () const;
+  uint32_t GetNBundles () const;
+  bool IsEmpty () const;
+  void Clear ();
+
+ private:
+  struct IndexKey
+  {
+    IndexKey ()
+      : m_rank (0), m_seq (0)
+    {}
+    IndexKey (double rank, uint64_t seq)
+      : m_rank (rank), m_seq (seq)
+    {}
+
+    // Ties are broken by the insertion order, oldest first
+    bool operator< (const IndexKey& other) const
+    {
+      if (m_rank == other.m_rank)
+        {
+          return m_seq < other.m_seq;
+        }
+      return m_rank < other.m_rank;
+    }
+
+    double m_rank;
+    uint64_t m_seq;
+  };
+
+  typedef map<IndexKey, Ptr<Bundle> > RankedBundles;
+  typedef map<GlobalBundleIdentifier, IndexKey> KeyLookup;
+
+  // The bundle with the lowest rank is the first to be evicted
+  double Rank (Ptr<Bundle> bundle, uint64_t seq, uint32_t forwarded) const;
+
+  EvictionPolicy m_policy;
+  uint64_t m_seq;
+  RankedBundles m_ranked;
+  KeyLookup m_lookup;
+};
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_EVICTION_POLICY_H */
@@ -0,0 +1,186 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include "bp-fragmentation.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+NS_LOG_COMPONENT_DEFINE ("BundleFragmentation");
+
+bool
+CanFragment (Ptr<Bundle> bundle)
+{
+  if (bundle->IsDoNotFragment () || bundle->IsAdministrativeRecord ())
+    {
+      return false;
+    }
+  return bundle->GetCanonicalHeaders ().front ().GetBlockType () == PAYLOAD_BLOCK;
+}
+
+Ptr<Bundle>
+FragmentBundle (Ptr<Bundle> bundle, uint32_t offset, uint32_t length)
+{
+  NS_ASSERT (offset + length <= bundle->GetPayload ()->GetSize ());
+  NS_LOG_DEBUG ("FragmentBundle " << bundle->GetBundleId () << " [" << offset << ", " << offset + length << ")");
+
+  PrimaryBundleHeader primaryHeader = bundle->GetPrimaryHeader ();
+  BlockList blocks = bundle->GetCanonicalHeaders ();
+
+  if (!primaryHeader.IsFragment ())
+    {
+      primaryHeader.SetFragment (true);
+      primaryHeader.SetFragmentOffset (0);
+      primaryHeader.SetTotalApplicationLength (blocks.front ().GetBlockLength ());
+    }
+  primaryHeader.SetFragmentOffset (primaryHeader.GetFragmentOffset () + offset);
+  blocks.front ().SetBlockLength (length);
+
+  Ptr<Bundle> fragment = bundle->Copy ();
+  // The copy constructor leaves out the nodes the bundle has been received from
+  fragment->reclist = bundle->reclist;
+  fragment->SetCanonicalHeaders (blocks);
+  fragment->SetPayload (bundle->GetPayload ()->CreateFragment (offset, length));
+  fragment->SetPrimaryHeader (primaryHeader);
+  return fragment;
+}
+
+FragmentReassembler::FragmentReassembler ()
+  : m_pending (),
+    m_reassembled ()
+{}
+
+FragmentReassembler::~FragmentReassembler ()
+{
+  Clear ();
+}
+
+Ptr<Bundle>
+FragmentReassembler::AddFragment (Ptr<Bundle> fragment)
+{
+  GlobalBundleIdentifier gbid = fragment->GetBundleId ();
+  GlobalBundleIdentifier wholeId = gbid.GetWholeBundleId ();
+
+  if (m_reassembled.find (wholeId) != m_reassembled.end ())
+    {
+      NS_LOG_DEBUG ("FragmentReassembler::AddFragment " << wholeId << " already reassembled, ignoring " << gbid);
+      return 0;
+    }
+
+  Fragments& fragments = m_pending[wholeId];
+  fragments.insert (make_pair (gbid, fragment));
+
+  Ptr<Bundle> bundle = Reassemble (fragments);
+  if (bundle != 0)
+    {
+      NS_LOG_DEBUG ("FragmentReassembler::AddFragment reassembled " << wholeId << " from " << fragments.size () << " fragments");
+      m_pending.erase (wholeId);
+      m_reassembled.insert (make_pair (wholeId, fragment->GetCreationTimestamp ().GetTime () + fragment->GetLifetime ()));
+    }
+  return bundle;
+}
+
+Ptr<Bundle>
+FragmentReassembler::Reassemble (const Fragments& fragments) const
+{
+  Ptr<Bundle> first = fragments.begin ()->second;
+  uint64_t total = first->GetTotalApplicationLength ();
+
+  // Check that there are no holes before copying any payload
+  uint64_t covered = 0;
+  for (Fragments::const_iterator iter = fragments.begin (); iter != fragments.end (); ++iter)
+    {
+      uint64_t offset = iter->first.GetFragmentOffset ();
+      if (offset > covered)
+        {
+          return 0;
+        }
+      covered = max (covered, offset + iter->first.GetFragmentLength ());
+    }
+  if (covered < total)
+    {
+      return 0;
+    }
+
+  Ptr<Packet> payload = Create<Packet> ();
+  covered = 0;
+  for (Fragments::const_iterator iter = fragments.begin (); iter != fragments.end () && covered < total; ++iter)
+    {
+      uint64_t offset = iter->first.GetFragmentOffset ();
+      uint64_t end = offset + iter->first.GetFragmentLength ();
+      if (end > covered)
+        {
+          payload->AddAtEnd (iter->second->GetPayload ()->CreateFragment (covered - offset, end - covered));
+          covered = end;
+        }
+    }
+
+  PrimaryBundleHeader primaryHeader = first->GetPrimaryHeader ();
+  primaryHeader.SetFragment (false);
+  primaryHeader.SetFragmentOffset (0);
+  primaryHeader.SetTotalApplicationLength (0);
+  BlockList blocks = first->GetCanonicalHeaders ();
+  blocks.front ().SetBlockLength (total);
+
+  Ptr<Bundle> bundle = first->Copy ();
+  bundle->SetCanonicalHeaders (blocks);
+  bundle->SetPayload (payload);
+  bundle->SetPrimaryHeader (primaryHeader);
+  return bundle;
+}
+
+void
+FragmentReassembler::RemoveExpired ()
+{
+  PendingBundles::iterator iter = m_pending.begin ();
+  while (iter != m_pending.end ())
+    {
+      Ptr<Bundle> first = iter->second.begin ()->second;
+      if (Simulator::Now () > first->GetCreationTimestamp ().GetTime () + first->GetLifetime ())
+        {
+          m_pending.erase (iter++);
+        }
+      else
+        {
+          ++iter;
+        }
+    }
+
+  ReassembledBundles::iterator reassembled = m_reassembled.begin ();
+  while (reassembled != m_reassembled.end ())
+    {
+      if (Simulator::Now () > reassembled->second)
+        {
+          m_reassembled.erase (reassembled++);
+        }
+      else
+        {
+          ++reassembled;
+        }
+    }
+}
+
+uint32_t
+FragmentReassembler::GetNPending () const
+{
+  return m_pending.size ();
+}
+
+uint32_t
+FragmentReassembler::GetNReassembled () const
+{
+  return m_reassembled.size ();
+}
+
+void
+FragmentReassembler::Clear ()
+{
+  m_pending.clear ();
+  m_reassembled.clear ();
+}
+
+}} // namespace bundleProtocol, ns3
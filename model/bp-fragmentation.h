@@ -0,0 +1,93 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_FRAGMENTATION_H
+#define BP_FRAGMENTATION_H
+
+#include <map>
+#include <stdint.h>
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+
+#include "bp-bundle.h"
+#include "bp-global-bundle-identifier.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+/**
+ * \ingroup bundle
+ *
+ * \brief Checks if a bundle may be split into fragments.
+ * \return Returns true for data bundles that are not administrative records
+ * and do not have the do not fragment flag set.
+ */
+bool CanFragment (Ptr<Bundle> bundle);
+
+/**
+ * \ingroup bundle
+ *
+ * \brief Creates a fragment holding the payload bytes [offset, offset + length) of a bundle.
+ *
+ * If bundle already is a fragment the offset of the new fragment is relative to
+ * the original ADU. The bundle may have a payload shorter than its payload block
+ * says, i.e a partially received bundle, the total length is then taken from the
+ * payload block header.
+ *
+ * \param bundle The bundle, or fragment, to take the payload from.
+ * \param offset The first payload byte of the fragment.
+ * \param length The number of payload bytes in the fragment.
+ * \return The new fragment.
+ */
+Ptr<Bundle> FragmentBundle (Ptr<Bundle> bundle, uint32_t offset, uint32_t length);
+
+/**
+ * \ingroup bundle
+ *
+ * \brief Collects the fragments of bundles until the whole ADU has been received.
+ *
+ * Fragments may overlap, e.g when the same bundle has been reactively fragmented
+ * on different contacts, overlapping bytes are only used once.
+ */
+class FragmentReassembler
+{
+ public:
+  FragmentReassembler ();
+  ~FragmentReassembler ();
+
+  /**
+   * \brief Stores a fragment until all of the payload of its bundle is held.
+   *
+   * Fragments of a bundle that already has been reassembled are ignored until
+   * the bundle expires, so a late duplicate can not deliver the ADU twice.
+   *
+   * \param fragment The received fragment.
+   * \return The reassembled bundle when fragment completed it, otherwise 0.
+   */
+  Ptr<Bundle> AddFragment (Ptr<Bundle> fragment);
+  /**
+   * \brief Drops the fragments, and the reassembled markers, of bundles whose lifetime has expired.
+   */
+  void RemoveExpired ();
+  uint32_t GetNPending () const;
+  uint32_t GetNReassembled () const;
+  void Clear ();
+
+ private:
+  // Ordered on the fragment offset since the source and timestamp are the same
+  typedef map<GlobalBundleIdentifier, Ptr<Bundle> > Fragments;
+  typedef map<GlobalBundleIdentifier, Fragments> PendingBundles;
+  // The expiration time of each bundle that has been reassembled
+  typedef map<GlobalBundleIdentifier, Time> ReassembledBundles;
+
+  Ptr<Bundle> Reassemble (const Fragments& fragments) const;
+
+  PendingBundles m_pending;
+  ReassembledBundles m_reassembled;
+};
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_FRAGMENTATION_H */
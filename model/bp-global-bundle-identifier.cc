@@ -12,31 +12,61 @@ namespace bundleProtocol {
 
 GlobalBundleIdentifier::GlobalBundleIdentifier ()
   : m_eid (BundleEndpointId::GetAnyBundleEndpointId ()),
-    m_creationTimestamp ()
+    m_creationTimestamp (),
+    m_fragmentOffset (0),
+    m_fragmentLength (0)
 {}
 
 GlobalBundleIdentifier::GlobalBundleIdentifier (Ptr<Packet> bundle)
   : m_eid (BundleEndpointId::GetAnyBundleEndpointId ()),
-    m_creationTimestamp ()
+    m_creationTimestamp (),
+    m_fragmentOffset (0),
+    m_fragmentLength (0)
 {
   PrimaryBundleHeader primaryHeader;
   bundle->PeekHeader (primaryHeader);
   m_eid = primaryHeader.GetSourceEndpoint ();
   m_creationTimestamp = primaryHeader.GetCreationTimestamp ();
+
+  if (primaryHeader.IsFragment ())
+    {
+      // The length of a fragment is the length of its payload, i.e what is
+      // left after the primary and the canonical headers.
+      Ptr<Packet> tmp = bundle->Copy ();
+      tmp->RemoveHeader (primaryHeader);
+      CanonicalBundleHeader canonicalHeader;
+      do
+        {
+          tmp->RemoveHeader (canonicalHeader);
+        }
+      while (!canonicalHeader.IsLastBlock ());
+
+      m_fragmentOffset = primaryHeader.GetFragmentOffset ();
+      m_fragmentLength = tmp->GetSize ();
+    }
 }
 
 GlobalBundleIdentifier::GlobalBundleIdentifier (Ptr<Bundle> bundle)
   : m_eid (bundle->GetBundleId ().m_eid),
-    m_creationTimestamp (bundle->GetCreationTimestamp ())
+    m_creationTimestamp (bundle->GetCreationTimestamp ()),
+    m_fragmentOffset (bundle->GetBundleId ().m_fragmentOffset),
+    m_fragmentLength (bundle->GetBundleId ().m_fragmentLength)
 {
 }
 
 GlobalBundleIdentifier::GlobalBundleIdentifier (const GlobalBundleIdentifier& gbid)
-  : m_eid (gbid.m_eid), m_creationTimestamp (gbid.m_creationTimestamp)
+  : m_eid (gbid.m_eid), m_creationTimestamp (gbid.m_creationTimestamp),
+    m_fragmentOffset (gbid.m_fragmentOffset), m_fragmentLength (gbid.m_fragmentLength)
 {}
 
 GlobalBundleIdentifier::GlobalBundleIdentifier (const BundleEndpointId& sourceEid, const CreationTimestamp& creationTimestamp)
-  : m_eid (sourceEid), m_creationTimestamp (creationTimestamp)
+  : m_eid (sourceEid), m_creationTimestamp (creationTimestamp),
+    m_fragmentOffset (0), m_fragmentLength (0)
+{}
+
+GlobalBundleIdentifier::GlobalBundleIdentifier (const BundleEndpointId& sourceEid, const CreationTimestamp& creationTimestamp, uint64_t fragmentOffset, uint64_t fragmentLength)
+  : m_eid (sourceEid), m_creationTimestamp (creationTimestamp),
+    m_fragmentOffset (fragmentOffset), m_fragmentLength (fragmentLength)
 {}
 
 GlobalBundleIdentifier::~GlobalBundleIdentifier ()
@@ -66,12 +96,41 @@ GlobalBundleIdentifier::GetCreationTimestamp () const
   return m_creationTimestamp;
 }
 
+bool
+GlobalBundleIdentifier::IsFragment () const
+{
+  return m_fragmentLength != 0;
+}
+
+uint64_t
+GlobalBundleIdentifier::GetFragmentOffset () const
+{
+  return m_fragmentOffset;
+}
+
+uint64_t
+GlobalBundleIdentifier::GetFragmentLength () const
+{
+  return m_fragmentLength;
+}
+
+GlobalBundleIdentifier
+GlobalBundleIdentifier::GetWholeBundleId () const
+{
+  return GlobalBundleIdentifier (m_eid, m_creationTimestamp);
+}
+
 uint32_t
 GlobalBundleIdentifier::GetSerializedSize () const
 {
   uint32_t size = 0;
   size += m_eid.GetSerializedSize ();
   size += m_creationTimestamp.GetSerializedSize ();
+  size += Sdnv::EncodingLength (m_fragmentLength);
+  if (m_fragmentLength != 0)
+    {
+      size += Sdnv::EncodingLength (m_fragmentOffset);
+    }
   return size;
 }
   
@@ -82,6 +141,14 @@ GlobalBundleIdentifier::Serialize (uint8_t *buffer) const
   m_eid.Serialize (buffer);
   i += m_eid.GetSerializedSize ();
   m_creationTimestamp.Serialize(buffer+i);
+  i += m_creationTimestamp.GetSerializedSize ();
+  // A whole bundle only costs one byte extra, the zero fragment length
+  Sdnv::Encode (m_fragmentLength, buffer+i);
+  i += Sdnv::EncodingLength (m_fragmentLength);
+  if (m_fragmentLength != 0)
+    {
+      Sdnv::Encode (m_fragmentOffset, buffer+i);
+    }
 }
 
 GlobalBundleIdentifier
@@ -93,6 +160,13 @@ GlobalBundleIdentifier::Deserialize (uint8_t const*buffer)
   gbid.SetSourceEndpoint (eid);
   i += eid.GetSerializedSize ();
   gbid.SetCreationTimestamp (CreationTimestamp::Deserialize (buffer+i));
+  i += gbid.m_creationTimestamp.GetSerializedSize ();
+  gbid.m_fragmentLength = Sdnv::Decode (buffer+i);
+  i += Sdnv::EncodingLength (gbid.m_fragmentLength);
+  if (gbid.m_fragmentLength != 0)
+    {
+      gbid.m_fragmentOffset = Sdnv::Decode (buffer+i);
+    }
   
   return gbid;
 }
@@ -101,7 +175,8 @@ GlobalBundleIdentifier::Deserialize (uint8_t const*buffer)
 bool
 GlobalBundleIdentifier::operator == (const GlobalBundleIdentifier& other) const
 {
-  return (m_eid == other.m_eid) && (m_creationTimestamp == other.m_creationTimestamp);
+  return (m_eid == other.m_eid) && (m_creationTimestamp == other.m_creationTimestamp) &&
+    (m_fragmentOffset == other.m_fragmentOffset) && (m_fragmentLength == other.m_fragmentLength);
 }
 
 bool
@@ -113,13 +188,21 @@ GlobalBundleIdentifier::operator != (const GlobalBundleIdentifier& other) const
 bool
 GlobalBundleIdentifier::operator < (const GlobalBundleIdentifier& other) const
 {
-  if (m_eid == other.m_eid)
+  if (m_eid != other.m_eid)
+    {
+      return m_eid < other.m_eid;
+    }
+  else if (m_creationTimestamp != other.m_creationTimestamp)
     {
       return m_creationTimestamp < other.m_creationTimestamp;
     }
+  else if (m_fragmentOffset != other.m_fragmentOffset)
+    {
+      return m_fragmentOffset < other.m_fragmentOffset;
+    }
   else
     {
-      return m_eid < other.m_eid;
+      return m_fragmentLength < other.m_fragmentLength;
     }
 }
 
@@ -128,7 +211,24 @@ operator<< (ostream& os, const GlobalBundleIdentifier& gbid)
 {
   os << "Source Endpoint = " << gbid.m_eid << endl;
   os << gbid.m_creationTimestamp.GetSeconds () << "|" << gbid.m_creationTimestamp.GetSequence ();
+  if (gbid.IsFragment ())
+    {
+      os << "|" << gbid.m_fragmentOffset << "+" << gbid.m_fragmentLength;
+    }
   return os;
 }
 
+size_t
+GlobalBundleIdentifierHash::operator() (const GlobalBundleIdentifier& gbid) const
+{
+  // Same fields as operator ==, the sequence number tells apart most bundles of a source
+  CreationTimestamp timestamp = gbid.GetCreationTimestamp ();
+  size_t hash = gbid.GetSourceEid ().GetId ();
+  hash = hash * 31 + (size_t) timestamp.GetSeconds ();
+  hash = hash * 31 + (size_t) timestamp.GetSequence ();
+  hash = hash * 31 + (size_t) gbid.GetFragmentOffset ();
+  hash = hash * 31 + (size_t) gbid.GetFragmentLength ();
+  return hash;
+}
+
 }} // namespace bundleProtocol, ns3
@@ -19,7 +19,9 @@ class Bundle;
  *
  * \brief Uniquely identifies a bundle.
  *
- *
+ * A fragment is identified by the source, the creation timestamp, the
+ * fragment offset and the length of its payload. For a whole bundle the
+ * fragment length is 0.
  */
 class GlobalBundleIdentifier
 {
@@ -28,6 +30,7 @@ class GlobalBundleIdentifier
   GlobalBundleIdentifier (Ptr<Packet> bundle);
   GlobalBundleIdentifier (Ptr<Bundle> bundle);
   GlobalBundleIdentifier (const BundleEndpointId& sourceEid, const CreationTimestamp& creationTimestamp);
+  GlobalBundleIdentifier (const BundleEndpointId& sourceEid, const CreationTimestamp& creationTimestamp, uint64_t fragmentOffset, uint64_t fragmentLength);
   GlobalBundleIdentifier (const GlobalBundleIdentifier& gbid);
   ~GlobalBundleIdentifier ();
   
@@ -36,6 +39,15 @@ class GlobalBundleIdentifier
   BundleEndpointId GetSourceEid () const;
   CreationTimestamp GetCreationTimestamp () const;
 
+  bool IsFragment () const;
+  uint64_t GetFragmentOffset () const;
+  uint64_t GetFragmentLength () const;
+  /**
+   * \return The identifier of the bundle this is a fragment of, or a copy of
+   * this identifier if it is not a fragment.
+   */
+  GlobalBundleIdentifier GetWholeBundleId () const;
+
   uint32_t GetSerializedSize () const;
   
   void Serialize (uint8_t *buffer) const;
@@ -48,12 +60,23 @@ class GlobalBundleIdentifier
  private:
   BundleEndpointId m_eid;
   CreationTimestamp m_creationTimestamp;
+  uint64_t m_fragmentOffset;
+  uint64_t m_fragmentLength;
   
   friend ostream& operator<< (ostream& os, const GlobalBundleIdentifier& gbid);
 
 };
 ostream& operator<< (ostream& os, const GlobalBundleIdentifier& gbid);
 
+/**
+ * \brief Hash of a GlobalBundleIdentifier, to keep them in the tr1 unordered containers.
+ */
+class GlobalBundleIdentifierHash
+{
+ public:
+  size_t operator() (const GlobalBundleIdentifier& gbid) const;
+};
+
 }} // namespace bundleProtocol, ns3
 
 #endif /* BP_GLOBAL_BUNDLE_IDENTIFIER_H */
@@ -417,8 +417,6 @@ PrimaryBundleHeader::GetSerializedSize (void) const
   size += Sdnv::EncodingLength (m_lifetime);
   /*Joao*/
   size += Sdnv::EncodingLength (m_bundle_global_id);
-  size += Sdnv::EncodingLength(m_custody.GetSerializedSize());
-  size += m_custody.GetSerializedSize();
   /*Joao*/
   size += Sdnv::EncodingLength (m_dictionary.GetSerializedSize ());
   size += m_dictionary.GetSerializedSize (); // Size of the dictionary
@@ -442,10 +440,6 @@ PrimaryBundleHeader::Serialize (Buffer::Iterator start) const
   Sdnv::Encode (m_lifetime, i);
   /*Joao*/
   Sdnv::Encode (m_bundle_global_id, i);
-  Sdnv::Encode (m_custody.GetSerializedSize (), i);
-  uint8_t bufferc[m_custody.GetSerializedSize ()];
-  m_custody.Serialize (bufferc);
-  i.Write (bufferc, m_custody.GetSerializedSize ());
   /*Joao*/
   Sdnv::Encode (m_dictionary.GetSerializedSize (), i);
   uint8_t buffer[m_dictionary.GetSerializedSize ()];
@@ -470,10 +464,6 @@ PrimaryBundleHeader::Deserialize (Buffer::Iterator start)
   m_lifetime = Sdnv::Decode (i);
   /*joao*/
   m_bundle_global_id = Sdnv::Decode (i);
-  uint64_t custodyLength = Sdnv::Decode (i);
-  uint8_t bufferc[custodyLength];
-  i.Read (bufferc, custodyLength);
-  m_custody = GlobalBundleIdentifier::Deserialize (bufferc);
   /*joao*/
   uint64_t dictionaryLength = Sdnv::Decode (i);
   uint8_t buffer[dictionaryLength];
@@ -762,15 +752,6 @@ uint64_t PrimaryBundleHeader::GetGlobalId()const
   return m_bundle_global_id;
 }
 
-void PrimaryBundleHeader::SetCustody(GlobalBundleIdentifier gbid)
-{
-	m_custody = gbid;
-}
-GlobalBundleIdentifier PrimaryBundleHeader::GetCustody()
-{
-	return m_custody;
-}
-
 
 /*Joao*/
 
@@ -313,8 +313,6 @@ public:
   /*Joao*/
   void SetGlobalId(const uint64_t &id);
   uint64_t GetGlobalId()const;
-  void SetCustody(GlobalBundleIdentifier gbid);
-  GlobalBundleIdentifier GetCustody();
 
   /*Joao*/
   /* sergiosvieira */
@@ -334,7 +332,6 @@ private:
   uint64_t m_lifetime;
   /*Joao*/
   uint64_t m_bundle_global_id;
-  GlobalBundleIdentifier m_custody;
   /*Joao*/
   Dictionary m_dictionary;
   uint64_t m_fragmentOffset;
@@ -465,6 +462,7 @@ enum BlockType {
   PAYLOAD_BLOCK = 1,
   KNOWN_DELIVERED_MESSAGES_BLOCK = 192,
   CONTACT_WINDOW_INFORMATION_BLOCK = 193,
+  CUSTODY_SIGNAL_BLOCK = 194,
 };
 
 /**
@@ -0,0 +1,109 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/log.h"
+
+#include "bp-hello-decoder.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+NS_LOG_COMPONENT_DEFINE ("HelloDecoder");
+
+DecodedHello::DecodedHello ()
+  : m_eid (),
+    m_hasMobility (false),
+    m_position (),
+    m_velocity (),
+    m_packet ()
+{}
+
+DecodedHello::~DecodedHello ()
+{}
+
+void
+DecodedHello::SetBundleEndpointId (const BundleEndpointId& eid)
+{
+  m_eid = eid;
+}
+
+BundleEndpointId
+DecodedHello::GetBundleEndpointId () const
+{
+  return m_eid;
+}
+
+void
+DecodedHello::SetMobility (const Vector& position, const Vector& velocity)
+{
+  m_hasMobility = true;
+  m_position = position;
+  m_velocity = velocity;
+}
+
+bool
+DecodedHello::HasMobility () const
+{
+  return m_hasMobility;
+}
+
+Vector
+DecodedHello::GetPosition () const
+{
+  return m_position;
+}
+
+Vector
+DecodedHello::GetVelocity () const
+{
+  return m_velocity;
+}
+
+void
+DecodedHello::SetPacket (Ptr<Packet> packet)
+{
+  m_packet = packet;
+}
+
+Ptr<Packet>
+DecodedHello::GetPacket () const
+{
+  return m_packet;
+}
+
+map<uint32_t, HelloDecoder>&
+HelloDecoderRegistry::GetDecoders ()
+{
+  // Function local, so that registrars in other translation units can use it during static initialization
+  static map<uint32_t, HelloDecoder> decoders;
+  return decoders;
+}
+
+void
+HelloDecoderRegistry::Register (uint32_t type, HelloDecoder decoder)
+{
+  GetDecoders ()[type] = decoder;
+}
+
+Ptr<DecodedHello>
+HelloDecoderRegistry::Decode (Ptr<Packet> hello)
+{
+  TypeTag type;
+  if (!hello->PeekPacketTag (type))
+    {
+      NS_LOG_DEBUG ("Hello without TypeTag");
+      return 0;
+    }
+
+  map<uint32_t, HelloDecoder>::const_iterator iter = GetDecoders ().find (type.GetType ());
+  if (iter == GetDecoders ().end ())
+    {
+      NS_LOG_DEBUG ("No hello decoder registered for type " << type.GetType ());
+      return 0;
+    }
+
+  Ptr<DecodedHello> decoded = (iter->second) (hello);
+  decoded->SetPacket (hello);
+  return decoded;
+}
+
+}} // namespace bundleProtocol, ns3
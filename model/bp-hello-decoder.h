@@ -0,0 +1,133 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_HELLO_DECODER_H
+#define BP_HELLO_DECODER_H
+
+#include <map>
+#include <stdint.h>
+
+#include "ns3/ptr.h"
+#include "ns3/packet.h"
+#include "ns3/vector.h"
+#include "ns3/ref-count-base.h"
+
+#include "bp-bundle-endpoint-id.h"
+#include "bp-type-tag.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief A received hello, parsed once and shared by the link discovery and the router.
+ *
+ * Holds what the link manager needs from every hello. The router specific
+ * contents are kept in the header of a TypedHello.
+ */
+class DecodedHello : public RefCountBase
+{
+public:
+  DecodedHello ();
+  virtual ~DecodedHello ();
+
+  void SetBundleEndpointId (const BundleEndpointId& eid);
+  BundleEndpointId GetBundleEndpointId () const;
+
+  void SetMobility (const Vector& position, const Vector& velocity);
+  bool HasMobility () const;
+  Vector GetPosition () const;
+  Vector GetVelocity () const;
+
+  void SetPacket (Ptr<Packet> packet);
+  Ptr<Packet> GetPacket () const;
+
+private:
+  BundleEndpointId m_eid;
+  bool m_hasMobility;
+  Vector m_position;
+  Vector m_velocity;
+  Ptr<Packet> m_packet;
+};
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief A decoded hello that also keeps the router specific header.
+ *
+ * The router gets its header back with DynamicCast<TypedHello<Header> >.
+ */
+template <typename H>
+class TypedHello : public DecodedHello
+{
+public:
+  TypedHello (const H& header)
+    : m_header (header)
+  {}
+
+  const H& GetHeader () const
+  {
+    return m_header;
+  }
+
+private:
+  H m_header;
+};
+
+typedef Ptr<DecodedHello> (*HelloDecoder) (Ptr<Packet> hello);
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief Maps the TypeTag of a hello to the function that decodes it.
+ *
+ * Each router registers a decoder for its hello type once, with a static
+ * HelloDecoderRegistrar in its translation unit.
+ */
+class HelloDecoderRegistry
+{
+public:
+  static void Register (uint32_t type, HelloDecoder decoder);
+  /**
+   * \param hello The received hello, with its TypeTag.
+   * \return The decoded hello, or 0 if no decoder is registered for its type.
+   */
+  static Ptr<DecodedHello> Decode (Ptr<Packet> hello);
+
+private:
+  static map<uint32_t, HelloDecoder>& GetDecoders ();
+};
+
+class HelloDecoderRegistrar
+{
+public:
+  HelloDecoderRegistrar (uint32_t type, HelloDecoder decoder)
+  {
+    HelloDecoderRegistry::Register (type, decoder);
+  }
+};
+
+/**
+ * \brief Decoder for hello headers with GetBundleEndpointId and optional mobility
+ * (NeighHeader and ProphetHelloHeader).
+ */
+template <typename H>
+Ptr<DecodedHello>
+DecodeHello (Ptr<Packet> packet)
+{
+  H header;
+  packet->PeekHeader (header);
+  Ptr<TypedHello<H> > hello = Create<TypedHello<H> > (header);
+  hello->SetBundleEndpointId (header.GetBundleEndpointId ());
+  if (header.HasMobility ())
+    {
+      hello->SetMobility (header.GetPosition (), header.GetVelocity ());
+    }
+  return hello;
+}
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_HELLO_DECODER_H */
@@ -31,19 +31,16 @@ LinkManager::LinkManager (){
 LinkManager::~LinkManager ()
 {}
 
-void
-LinkManager::Doh () const
-{}
-
 void 
 LinkManager::DoDispose ()
 {
-  for (LinkMap::iterator iter = m_links.begin (); iter != m_links.end (); ++iter)
+  for (LinkSet::iterator iter = m_links.begin (); iter != m_links.end (); ++iter)
     {
-      iter->first->m_contact = 0;
-      iter->second.SetFunction (&LinkManager::Doh, this);
+      (*iter)->m_contact = 0;
     }
   m_links.clear ();
+  m_expiring.clear ();
+  Simulator::Cancel (m_sweepEvent);
 
   m_createLinkCb = MakeNullCallback<Ptr<Link>, BundleEndpointId, Address> ();
   m_linkAvailableCb = MakeNullCallback<void,Ptr<Link> > ();
@@ -69,7 +66,13 @@ LinkManager::SetCreateLinkCallback (Callback<Ptr<Link>, BundleEndpointId, Addres
   m_createLinkCb = sayWhatCb;
 }
 
-void LinkManager::DiscoveredLink(Ptr<Packet> hello, Address fromAddress) {
+void LinkManager::UpdatePeerMobility(Ptr<Link> link, Ptr<DecodedHello> hello) const {
+	if (hello->HasMobility()) {
+		link->SetPeerMobility(hello->GetPosition(), hello->GetVelocity());
+	}
+}
+
+void LinkManager::DiscoveredLink(Ptr<DecodedHello> hello, Address fromAddress) {
 	NS_LOG_DEBUG(fromAddress);
 
 	BundleEndpointId eid;
@@ -78,60 +81,12 @@ void LinkManager::DiscoveredLink(Ptr<Packet> hello, Address fromAddress) {
 			packetAddress.GetPhysicalAddress());
 
 
-	TypeTag type;
-	hello->PeekPacketTag(type);
-	/* Verifico o tipo de pacote que recebi */
-	if (type.GetType() == 1) {
-		/* Prophet Protocol */
-		ProphetHelloHeader header;
-		hello->PeekHeader(header);
-		eid = header.GetBundleEndpointId();
-	} else if (type.GetType() == 2) {
-		/* used in Trend of Delivery Protocol */
-		NeighHello header;
-		hello->PeekHeader(header);
-		eid = header.GetBundleEndpointId();
-	} else if (type.GetType() == 3) {
-		/* DirectLink */
-		NeighHeader header;
-		NS_LOG_DEBUG("PeekHeader");
-		hello->PeekHeader(header);
-		eid = header.GetBundleEndpointId();
-	} else if (type.GetType() == 4) {
-		/* Epidemic */
-		NeighHeader header;
-		NS_LOG_DEBUG("PeekHeader");
-		hello->PeekHeader(header);
-		eid = header.GetBundleEndpointId();
-	} else if (type.GetType() == 5){
-		/*SprayAndWait*/
-		NeighHeader header;
-		NS_LOG_DEBUG("PeekHeader");
-		hello->PeekHeader(header);
-		eid = header.GetBundleEndpointId();
-	} else if (type.GetType() == 6){
-		/*AntMofo*/
-		AntMofoHelloHeader header;
-		NS_LOG_DEBUG("PeekHeader");
-		hello->PeekHeader(header);
-		eid = header.GetBundleEndpointId();
-	} else if (type.GetType() == 7){
-		ProphetTodHelloHeader header;
-		NS_LOG_DEBUG("PeekHeader");
-		hello->PeekHeader(header);
-		eid = header.GetBundleEndpointId();
-	}
-
-
-	/*
-	ProphetHelloHeader header;
-	hello->PeekHeader(header);
-	eid = header.GetBundleEndpointId();
-	*/
+	eid = hello->GetBundleEndpointId();
 
 	if (HasLink(eid)) {
 		Ptr<Link> oldLink = FindLink(eid);
 		oldLink->UpdateLastHeardFrom();
+		UpdatePeerMobility(oldLink, hello);
 		if (oldLink->GetState() == LINK_UNAVAILABLE) {
 			oldLink->ChangeState(LINK_AVAILABLE);
 			SetupTimer(oldLink);
@@ -141,14 +96,24 @@ void LinkManager::DiscoveredLink(Ptr<Packet> hello, Address fromAddress) {
 		Ptr<Link> link = m_createLinkCb(eid, peerMac);
 		link->ChangeState(LINK_AVAILABLE);
 		link->UpdateLastHeardFrom();
-		LinkTimer lt = make_pair<Ptr<Link> , Timer> (link, Timer(
-				Timer::REMOVE_ON_DESTROY));
-		m_links.insert(lt);
+		UpdatePeerMobility(link, hello);
+		m_links.insert(link);
 		SetupTimer(link);
 		NotifyLinkIsAvailable(link);
 	}
 }
 
+void
+LinkManager::RefreshLink (const Mac48Address& address)
+{
+  Ptr<Link> link = FindLink (address);
+  if (link != 0 && link->GetState () != LINK_UNAVAILABLE)
+    {
+      NS_LOG_DEBUG ("RefreshLink " << address);
+      link->UpdateLastHeardFrom ();
+    }
+}
+
 void
 LinkManager::AddLink (Ptr<Link> link)
 {
@@ -162,8 +127,7 @@ LinkManager::AddLink (Ptr<Link> link)
   else
     {
       link->UpdateLastHeardFrom ();
-      LinkTimer lt = make_pair<Ptr<Link>,Timer> (link, Timer (Timer::REMOVE_ON_DESTROY));
-      m_links.insert (lt);
+      m_links.insert (link);
       //m_linkSet.push_back (link);
       SetupTimer (link);
     }
@@ -178,6 +142,7 @@ LinkManager::RemoveLink (Ptr<Link> link)
     m_linkSet.erase (iter, m_linkSet.end ());
   */
   m_links.erase (link);
+  m_expiring.erase (link);
 }
   
 bool
@@ -199,8 +164,7 @@ bool
 LinkManager::HasLink (Ptr<Link> link)
 {
   //return HasLink (link->GetRemoteEndpointId ());
-  LinkMap::const_iterator iter = m_links.find (link);
-  return iter != m_links.end ();
+  return m_links.find (link) != m_links.end ();
 }
 
 Ptr<Link>
@@ -237,10 +201,10 @@ Ptr<Link>
 LinkManager::FindLink (Ptr<Link> link)
 {
   //return FindLink (link->GetRemoteEndpointId ());
-  LinkMap::const_iterator iter = m_links.find (link);
+  LinkSet::const_iterator iter = m_links.find (link);
   if (iter != m_links.end ())
     {
-      return iter->first;
+      return *iter;
     }
   else
     {
@@ -268,9 +232,7 @@ LinkManager::CloseLink (Ptr<Link> link)
   Ptr<Link> oldLink = FindLink (link);
   if (oldLink != 0)
     {
-      LinkMap::iterator iter = m_links.find (oldLink);
-      iter->second.Cancel ();
-      iter->second.Remove ();
+      m_expiring.erase (oldLink);
 
       NotifyClosedLink (link);
       oldLink->Close ();
@@ -298,14 +260,7 @@ Links LinkManager::GetReadyLinks() {
 Links
 LinkManager::GetAllLinks ()
 {
-  Links linkSet;
-  linkSet.reserve (m_links.size ());
-  
-  for (LinkMap::const_iterator iter = m_links.begin (); iter != m_links.end (); ++iter)
-    {
-      linkSet.push_back (iter->first);
-    }
-  return linkSet;
+  return Links (m_links.begin (), m_links.end ());
 }
 
 Links
@@ -341,30 +296,50 @@ LinkManager::GetUnavailableLinks ()
 void
 LinkManager::CheckIfExpired (Ptr<Link> link)
 { 
-  LinkMap::iterator iter = m_links.find (link);
-  
   if (((Simulator::Now () - link->GetLastHeardFrom ()) >= m_ttl))
     {
       CloseLink (link);
     }
-  else
+}
+
+void
+LinkManager::SetupTimer (Ptr<Link> link)
+{
+  m_expiring.insert (link);
+  // A link that has just been heard from expires last, a pending sweep is early enough
+  if (!m_sweepEvent.IsRunning ())
     {
-      Time delay = m_ttl - (Simulator::Now () - link->GetLastHeardFrom ());
-      iter->second.Schedule (delay);
+      m_sweepEvent = Simulator::Schedule (link->GetLastHeardFrom () + m_ttl - Simulator::Now (),
+                                          &LinkManager::SweepExpired, this);
     }
 }
 
 void
-LinkManager::SetupTimer (Ptr<Link> link)
+LinkManager::SweepExpired ()
 {
-  LinkMap::iterator iter = m_links.find (link);
-  //link->m_expirationTimer.SetFunction (&LinkManager::CheckIfExpired, this);
-  //link->m_expirationTimer.SetArguments (link);
-  //link->m_expirationTimer.Schedule (m_ttl);
-  iter->second.SetFunction (&LinkManager::CheckIfExpired, this);
-  iter->second.SetArguments (link);
-  iter->second.Schedule (m_ttl);
-};
+  // Copied, as closing a link removes it from m_expiring
+  Links expiring (m_expiring.begin (), m_expiring.end ());
+  for (Links::iterator iter = expiring.begin (); iter != expiring.end (); ++iter)
+    {
+      if ((Simulator::Now () - (*iter)->GetLastHeardFrom ()) >= m_ttl)
+        {
+          m_expiring.erase (*iter);
+          CheckIfExpired (*iter);
+        }
+    }
+
+  if (m_expiring.empty ())
+    {
+      return;
+    }
+
+  Time next = (*m_expiring.begin ())->GetLastHeardFrom ();
+  for (set<Ptr<Link> >::const_iterator iter = m_expiring.begin (); iter != m_expiring.end (); ++iter)
+    {
+      next = Min (next, (*iter)->GetLastHeardFrom ());
+    }
+  m_sweepEvent = Simulator::Schedule (next + m_ttl - Simulator::Now (), &LinkManager::SweepExpired, this);
+}
 
 void
 LinkManager::NotifyLinkIsAvailable (Ptr<Link> link)
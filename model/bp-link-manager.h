@@ -3,7 +3,7 @@
 #ifndef BP_LINK_MANAGER_H
 #define BP_LINK_MANAGER_H
 
-#include <map>
+#include <set>
 
 #include "ns3/object.h"
 #include "ns3/callback.h"
@@ -12,6 +12,7 @@
 #include "ns3/simulator.h"
 #include "ns3/nstime.h"
 #include "ns3/timer.h"
+#include "ns3/event-id.h"
 
 #include "ns3/address.h"
 #include "ns3/mac48-address.h"
@@ -21,22 +22,14 @@
 #include "bp-contact.h"
 #include "bp-bundle-endpoint-id.h"
 #include "bp-neighbourhood-detection-agent.h"
-
-/* sergiosvieira */
-#include "bp-type-tag.h"
-#include "bp-rt-prophet-hello.h"
-#include "bp-rt-trend-of-delivery-neigh-hello.h"
-#include "bp-rt-antmofo-hello.h"
-#include "bp-rt-prophetTod-hello.h"
-/* sergiosvieira */
+#include "bp-hello-decoder.h"
 
 namespace ns3 {
 namespace bundleProtocol {
 
 class BundleRouter;
 
-typedef pair<Ptr<Link>, Timer> LinkTimer;
-typedef map<Ptr<Link>,Timer> LinkMap;
+typedef set<Ptr<Link> > LinkSet;
 
 /**
  * \ingroup bundleRouter
@@ -57,7 +50,15 @@ public:
   virtual void SetClosedLinkCallback (Callback<void, Ptr<Link> > closedLinkCb);
   virtual void SetCreateLinkCallback (Callback<Ptr<Link>, BundleEndpointId, Address> sayWhatCb);
 
-  virtual void DiscoveredLink (Ptr<Packet> hello, Address fromAddress);
+  virtual void DiscoveredLink (Ptr<DecodedHello> hello, Address fromAddress);
+  /**
+   * \brief Keeps a link alive on traffic other than hellos, e.g segments carrying neighbour info.
+   *
+   * Only refreshes links that are still known, a link that has expired has to be
+   * rediscovered by a hello.
+   * \param address The mac address the traffic was received from.
+   */
+  virtual void RefreshLink (const Mac48Address& address);
   virtual void AddLink (Ptr<Link> link);
 
   virtual void RemoveLink (Ptr<Link> link);
@@ -80,14 +81,28 @@ public:
   virtual Links GetUnavailableLinks ();
 
 protected:
-  virtual void Doh () const;
+  /**
+   * \brief Feeds the contact window estimation of the link with the position and velocity in the hello, if any.
+   * \param link The link the hello was received on.
+   * \param hello The received hello.
+   */
+  void UpdatePeerMobility (Ptr<Link> link, Ptr<DecodedHello> hello) const;
   virtual void DoDispose ();
   virtual void CheckIfExpired (Ptr<Link> link);
   virtual void NotifyLinkIsAvailable (Ptr<Link> link);
   virtual void NotifyClosedLink (Ptr<Link> link);
+  /**
+   * \brief Makes the link expire m_ttl after it was last heard from.
+   *
+   * The links are not given a timer each, a single sweep closes the links that
+   * have not been heard from for m_ttl, so the hellos only update the last heard time.
+   */
   void SetupTimer (Ptr<Link> link);
+  void SweepExpired ();
   
-  LinkMap m_links;
+  LinkSet m_links;
+  set<Ptr<Link> > m_expiring;
+  EventId m_sweepEvent;
   Time m_ttl;
   Callback<Ptr<Link>, BundleEndpointId, Address> m_createLinkCb;
   Callback<void, Ptr<Link> > m_linkAvailableCb;
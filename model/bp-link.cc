@@ -1,5 +1,8 @@
 /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
 
+#include <cmath>
+#include <limits>
+
 #include "ns3/simulator.h"
 #include "ns3/mac48-address.h"
 #include "ns3/log.h"
@@ -30,7 +33,11 @@ Link::Link ()
     m_remoteAddress (),
     m_state (LINK_UNAVAILABLE), 
     m_lastHeard (Simulator::Now ()),
-    m_contact (0)
+    m_contact (0),
+    m_hasPeerMobility (false),
+    m_peerPosition (),
+    m_peerVelocity (),
+    m_peerMobilityHeard ()
 {}
   
 Link::Link (const BundleEndpointId& eid, const Address& address)
@@ -38,7 +45,11 @@ Link::Link (const BundleEndpointId& eid, const Address& address)
     m_remoteAddress (address),
     m_state (LINK_UNAVAILABLE), 
     m_lastHeard (Simulator::Now ()),
-    m_contact (0)
+    m_contact (0),
+    m_hasPeerMobility (false),
+    m_peerPosition (),
+    m_peerVelocity (),
+    m_peerMobilityHeard ()
 {}
 
 Link::Link (const EidAddress& ea)
@@ -46,7 +57,11 @@ Link::Link (const EidAddress& ea)
     m_remoteAddress (ea.GetAddress ()),
     m_state (LINK_UNAVAILABLE), 
     m_lastHeard (Simulator::Now ()),
-    m_contact (0)
+    m_contact (0),
+    m_hasPeerMobility (false),
+    m_peerPosition (),
+    m_peerVelocity (),
+    m_peerMobilityHeard ()
 {}
   
 Link::~Link ()
@@ -102,6 +117,73 @@ Link::UpdateLastHeardFrom ()
   m_lastHeard = Simulator::Now ();
 }
 
+void
+Link::SetPeerMobility (const Vector& position, const Vector& velocity)
+{
+  m_hasPeerMobility = true;
+  m_peerPosition = position;
+  m_peerVelocity = velocity;
+  m_peerMobilityHeard = Simulator::Now ();
+}
+
+bool
+Link::HasPeerMobility () const
+{
+  return m_hasPeerMobility;
+}
+
+Vector
+Link::GetPeerVelocity () const
+{
+  return m_peerVelocity;
+}
+
+Time
+Link::GetMaxContactWindow ()
+{
+  return Seconds (numeric_limits<uint32_t>::max ());
+}
+
+Time
+Link::GetContactWindow (const Vector& position, const Vector& velocity, double range) const
+{
+  if (!m_hasPeerMobility)
+    {
+      return GetMaxContactWindow ();
+    }
+
+  double elapsed = (Simulator::Now () - m_peerMobilityHeard).GetSeconds ();
+
+  // Relative position and velocity of the peer, in the plane
+  double px = m_peerPosition.x + m_peerVelocity.x * elapsed - position.x;
+  double py = m_peerPosition.y + m_peerVelocity.y * elapsed - position.y;
+  double vx = m_peerVelocity.x - velocity.x;
+  double vy = m_peerVelocity.y - velocity.y;
+
+  // Solves |p + v*t| = range for the largest t
+  double a = vx * vx + vy * vy;
+  double b = 2 * (px * vx + py * vy);
+  double c = px * px + py * py - range * range;
+
+  if (a == 0)
+    {
+      return c <= 0 ? GetMaxContactWindow () : Seconds (0);
+    }
+
+  double delta = b * b - 4 * a * c;
+  if (delta < 0)
+    {
+      return Seconds (0);
+    }
+
+  double t = (-b + sqrt (delta)) / (2 * a);
+  if (t < 0)
+    {
+      return Seconds (0);
+    }
+  return Seconds (t);
+}
+
 void
 Link::SetRemoteAddress (const Address& address)
 {
@@ -223,8 +305,6 @@ int Link::GetSize() {
 	return m_nlist.size();
 }
 
-/* sergiosvieira */
-/*
 NS_OBJECT_ENSURE_REGISTERED (OrwarLink);
 
 TypeId
@@ -302,7 +382,6 @@ OrwarLink::HaveCw ()
       return false;
     }
 }
-*/
 
 string
 LinkStateToString (LinkState state)
@@ -10,6 +10,8 @@
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
 #include "ns3/timer.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
 
 #include "bp-contact.h"
 #include "bp-convergence-layer-agent.h"
@@ -63,6 +65,29 @@ public:
 
   Time GetLastHeardFrom () const;
 
+  /**
+   * \brief Records the position and velocity the peer announced in its last hello.
+   * \param position The position of the peer.
+   * \param velocity The velocity of the peer.
+   */
+  void SetPeerMobility (const Vector& position, const Vector& velocity);
+  bool HasPeerMobility () const;
+  Vector GetPeerVelocity () const;
+  /**
+   * \brief Estimates for how long the two nodes will stay in range of each other.
+   *
+   * The position of the peer is extrapolated from its last hello, assuming it
+   * has kept the same velocity since then.
+   *
+   * \param position The position of the local node.
+   * \param velocity The velocity of the local node.
+   * \param range The transmission range.
+   * \return The remaining contact window, zero if the nodes are already out of
+   * range and Link::GetMaxContactWindow () if they do not move relative to each other.
+   */
+  Time GetContactWindow (const Vector& position, const Vector& velocity, double range) const;
+  static Time GetMaxContactWindow ();
+
   virtual void SetContact (Ptr<Contact> contact);
   virtual Ptr<Contact> GetContact () const;
   virtual LinkState GetState () const;
@@ -100,6 +125,12 @@ protected:
   LinkState m_state;
   Time m_lastHeard;
   Ptr<Contact> m_contact;
+
+  // Mobility of the peer, as announced in its hellos
+  bool m_hasPeerMobility;
+  Vector m_peerPosition;
+  Vector m_peerVelocity;
+  Time m_peerMobilityHeard;
   //Timer m_expirationTimer;
 
   /* sergiosvieira */
@@ -112,7 +143,6 @@ protected:
   friend ostream& operator<< (ostream& os, const Link& link);
 };
 
-/*
 class OrwarLink : public Link
 {
 public:
@@ -138,7 +168,6 @@ protected:
 
   TracedCallback<uint32_t, uint32_t, Time, bool> m_contactClosedLogger;
 };
-*/
 
 typedef std::vector<Ptr<Link> > Links;
 
@@ -6,13 +6,21 @@
  */
 
 #include "bp-neigh-header.h"
+#include "ieee754.h"
 
 namespace ns3 {
 namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (NeighHeader);
 
-NeighHeader::NeighHeader () : m_eid (BundleEndpointId::GetAnyBundleEndpointId ())
+// The highest bit of the eid length tells if the position and velocity follows
+#define NEIGH_HEADER_MOBILITY_FLAG 0x80000000
+
+NeighHeader::NeighHeader ()
+  : m_eid (BundleEndpointId::GetAnyBundleEndpointId ()),
+    m_hasMobility (false),
+    m_position (),
+    m_velocity ()
 {
 
 }
@@ -32,6 +40,32 @@ NeighHeader::GetBundleEndpointId () const
   return m_eid;
 }
 
+void
+NeighHeader::SetMobility (const Vector& position, const Vector& velocity)
+{
+  m_hasMobility = true;
+  m_position = position;
+  m_velocity = velocity;
+}
+
+bool
+NeighHeader::HasMobility () const
+{
+  return m_hasMobility;
+}
+
+Vector
+NeighHeader::GetPosition () const
+{
+  return m_position;
+}
+
+Vector
+NeighHeader::GetVelocity () const
+{
+  return m_velocity;
+}
+
 TypeId
 NeighHeader::GetTypeId (void)
 {
@@ -52,12 +86,16 @@ void
 NeighHeader::Print (std::ostream &os) const
 {
   os << "NeighHeader: eid = " << m_eid;
+  if (m_hasMobility)
+    {
+      os << " position = " << m_position << " velocity = " << m_velocity;
+    }
 }
 
 uint32_t
 NeighHeader::GetSerializedSize (void) const
 {
-  return m_eid.GetSerializedSize () + 4;
+  return m_eid.GetSerializedSize () + 4 + (m_hasMobility ? 32 : 0);
 }
 
 void
@@ -65,10 +103,18 @@ NeighHeader::Serialize (Buffer::Iterator start) const
 {
   int length = m_eid.GetSerializedSize ();
   Buffer::Iterator i = start;
-  i.WriteHtonU32 (length);
+  i.WriteHtonU32 (m_hasMobility ? (length | NEIGH_HEADER_MOBILITY_FLAG) : length);
   uint8_t buf [length];
   m_eid.Serialize (buf);
   i.Write (buf, length);
+
+  if (m_hasMobility)
+    {
+      i.WriteU64 (pack754_64 (m_position.x));
+      i.WriteU64 (pack754_64 (m_position.y));
+      i.WriteU64 (pack754_64 (m_velocity.x));
+      i.WriteU64 (pack754_64 (m_velocity.y));
+    }
 }
 
 uint32_t
@@ -76,9 +122,19 @@ NeighHeader::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator i = start;
   uint32_t length = i.ReadNtohU32 ();
+  m_hasMobility = (length & NEIGH_HEADER_MOBILITY_FLAG) != 0;
+  length &= ~NEIGH_HEADER_MOBILITY_FLAG;
   uint8_t buf [length];
   i.Read (buf,length);
   m_eid = BundleEndpointId::Deserialize (buf);
+
+  if (m_hasMobility)
+    {
+      m_position.x = unpack754_64 (i.ReadU64 ());
+      m_position.y = unpack754_64 (i.ReadU64 ());
+      m_velocity.x = unpack754_64 (i.ReadU64 ());
+      m_velocity.y = unpack754_64 (i.ReadU64 ());
+    }
   return GetSerializedSize ();
 }
 
@@ -32,8 +32,17 @@ public:
   void SetBundleEndpointId (BundleEndpointId eid);
   BundleEndpointId GetBundleEndpointId () const;
 
+  // Optional, only sent when the router estimates contact windows
+  void SetMobility (const Vector& position, const Vector& velocity);
+  bool HasMobility () const;
+  Vector GetPosition () const;
+  Vector GetVelocity () const;
+
 protected:
   BundleEndpointId m_eid;
+  bool m_hasMobility;
+  Vector m_position;
+  Vector m_velocity;
 
 public:
   static TypeId GetTypeId (void);
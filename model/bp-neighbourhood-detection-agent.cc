@@ -9,9 +9,14 @@
 #include "ns3/boolean.h"
 #include "ns3/uinteger.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy.h"
 #include "bp-neighbourhood-detection-agent.h"
+#include "bp-bundle-protocol-agent.h"
 #include "ns3/mobility-model.h"
 
+#include <cmath>
+
 // FIXME st�ll in jittret till ett bra v�rde
 
 
@@ -37,10 +42,38 @@ NeighbourhoodDetectionAgent::GetTypeId (void)
                    TimeValue (Time (Seconds (0.8))),
                    MakeTimeAccessor (&NeighbourhoodDetectionAgent::m_helloIntervall),
                    MakeTimeChecker ())
+    .AddAttribute ("AdaptiveHello",
+                   "Sets if the hello intervall shall follow the neighbour churn, the speed of the node relative to its neighbours and how busy the channel is.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NeighbourhoodDetectionAgent::m_adaptiveHello),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MinHelloIntervall",
+                   "The shortest intervall between hello broadcasts when AdaptiveHello is set",
+                   TimeValue (Time (Seconds (0.1))),
+                   MakeTimeAccessor (&NeighbourhoodDetectionAgent::m_minHelloIntervall),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxHelloIntervall",
+                   "The longest intervall between hello broadcasts when AdaptiveHello is set",
+                   TimeValue (Time (Seconds (3.0))),
+                   MakeTimeAccessor (&NeighbourhoodDetectionAgent::m_maxHelloIntervall),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxSuppressedHellos",
+                   "The number of hellos in a row that may be left out while the convergence layer keeps all neighbours alive with piggybacked neighbour info",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&NeighbourhoodDetectionAgent::m_maxSuppressedHellos),
+                   MakeUintegerChecker<uint32_t> ())
     .AddTraceSource ("SendHello", "A hello message has been broadcasted.",
                      MakeTraceSourceAccessor (&NeighbourhoodDetectionAgent::m_sendLogger))
     .AddTraceSource ("ReceivedHello", "A hello message has been received.",
                      MakeTraceSourceAccessor (&NeighbourhoodDetectionAgent::m_receiveLogger))
+    .AddTraceSource ("HelloIntervall", "The intervall until the next hello.",
+                     MakeTraceSourceAccessor (&NeighbourhoodDetectionAgent::m_intervallLogger))
+    .AddTraceSource ("NewNeighbour", "A hello has been received from a node that was not a neighbour.",
+                     MakeTraceSourceAccessor (&NeighbourhoodDetectionAgent::m_newNeighbourLogger))
+    .AddTraceSource ("SentHelloBytes", "The size of a hello handed to the device by the router.",
+                     MakeTraceSourceAccessor (&NeighbourhoodDetectionAgent::m_sentBytesLogger))
+    .AddTraceSource ("SuppressedHello", "A hello has been left out since the neighbours are kept alive by data segments.",
+                     MakeTraceSourceAccessor (&NeighbourhoodDetectionAgent::m_suppressLogger))
     ;
   return tid;
 }
@@ -49,6 +82,18 @@ NeighbourhoodDetectionAgent::NeighbourhoodDetectionAgent ()
   : m_node (0), 
     m_device (0),
     m_helloTimer (Timer::CANCEL_ON_DESTROY),
+    m_adaptiveHello (false),
+    m_minHelloIntervall (Seconds (0.1)),
+    m_maxHelloIntervall (Seconds (3.0)),
+    m_currentIntervall (),
+    m_lastAdapted (),
+    m_neighbours (),
+    m_neighbourEvents (0),
+    m_churnRate (0),
+    m_busyRatio (0),
+    m_piggybacked (),
+    m_suppressedHellos (0),
+    m_maxSuppressedHellos (3),
     m_started (false)
 {
   m_helloIntervall = Seconds(0.3);
@@ -63,6 +108,18 @@ NeighbourhoodDetectionAgent::NeighbourhoodDetectionAgent (Ptr<Node> node,
   m_device (device),
   m_eid (eid), 
   m_helloTimer (Timer::CANCEL_ON_DESTROY),
+  m_adaptiveHello (false),
+  m_minHelloIntervall (Seconds (0.1)),
+  m_maxHelloIntervall (Seconds (3.0)),
+  m_currentIntervall (),
+  m_lastAdapted (),
+  m_neighbours (),
+  m_neighbourEvents (0),
+  m_churnRate (0),
+  m_busyRatio (0),
+  m_piggybacked (),
+  m_suppressedHellos (0),
+  m_maxSuppressedHellos (3),
   m_started (false)
 {
   m_helloTimer.SetFunction (&NeighbourhoodDetectionAgent::HelloTimerExpire, this);
@@ -77,7 +134,7 @@ NeighbourhoodDetectionAgent::DoDispose ()
   m_node = 0;
   m_device = 0;
   m_socket = 0;
-  m_discoveredLinkCb = MakeNullCallback<void, Ptr<Packet>, Address > ();
+  m_discoveredLinkCb = MakeNullCallback<void, Ptr<DecodedHello>, Address > ();
   Object::DoDispose ();
 }
  
@@ -117,8 +174,14 @@ NeighbourhoodDetectionAgent::GetHelloIntervall () const
   return m_helloIntervall;
 }
 
+Time
+NeighbourhoodDetectionAgent::GetCurrentHelloIntervall () const
+{
+  return m_adaptiveHello ? m_currentIntervall : m_helloIntervall;
+}
+
 void
-NeighbourhoodDetectionAgent::SetDiscoveredLinkCallback (Callback<void, Ptr<Packet>, Address > discoveredLinkCb)
+NeighbourhoodDetectionAgent::SetDiscoveredLinkCallback (Callback<void, Ptr<DecodedHello>, Address > discoveredLinkCb)
 {
   m_discoveredLinkCb = discoveredLinkCb;
  
@@ -141,6 +204,8 @@ NeighbourhoodDetectionAgent::Init ()
       m_socket->Bind (sendAddr);
       m_socket->Connect (sendAddr);
       m_socket->SetRecvCallback (MakeCallback (&NeighbourhoodDetectionAgent::HandleHello, this));
+      // The routers build and send the hellos, the socket tells how large they were
+      m_socket->SetDataSentCallback (MakeCallback (&NeighbourhoodDetectionAgent::HelloSent, this));
     }
 }
 
@@ -173,11 +238,209 @@ void
 NeighbourhoodDetectionAgent::HelloTimerExpire ()
 {
   NS_LOG_DEBUG ("(" << m_node->GetId () << ")");
-  SendHello ();
+  if (m_adaptiveHello)
+    {
+      // Adapt before sending, so our own hello is not seen as channel activity
+      Time intervall = AdaptHelloIntervall ();
+      SendOrSuppressHello ();
+      m_helloTimer.Schedule (intervall - Seconds (UniformVariable ().GetValue (0, intervall.GetSeconds () / 5)));
+      return;
+    }
+  ExpireNeighbours ();
+  SendOrSuppressHello ();
   m_helloTimer.Schedule (m_helloIntervall-JITTER);
   //m_helloTimer.Schedule (Seconds(1.0));
 }
 
+void
+NeighbourhoodDetectionAgent::SendOrSuppressHello ()
+{
+  if (SuppressHello ())
+    {
+      ++m_suppressedHellos;
+      NS_LOG_DEBUG ("(" << m_node->GetId () << ") suppressed hello " << m_suppressedHellos);
+      m_suppressLogger (m_suppressedHellos);
+    }
+  else
+    {
+      m_suppressedHellos = 0;
+      SendHello ();
+    }
+}
+
+bool
+NeighbourhoodDetectionAgent::SuppressHello ()
+{
+  if (m_piggybacked.empty () || m_suppressedHellos >= m_maxSuppressedHellos)
+    {
+      return false;
+    }
+
+  // Forget neighbours that has not got any segments from us during the last intervall
+  Time since = Simulator::Now () - GetCurrentHelloIntervall ();
+  map<Mac48Address, Time>::iterator iter = m_piggybacked.begin ();
+  while (iter != m_piggybacked.end ())
+    {
+      if (iter->second < since)
+        {
+          m_piggybacked.erase (iter++);
+        }
+      else
+        {
+          ++iter;
+        }
+    }
+
+  Ptr<BundleProtocolAgent> bpa = m_node->GetObject<BundleProtocolAgent> ();
+  if (m_piggybacked.empty () || bpa == 0 || bpa->GetBundleRouter () == 0)
+    {
+      return false;
+    }
+
+  Links links = bpa->GetBundleRouter ()->GetLinkManager ()->GetAllLinks ();
+  bool covered = false;
+  for (Links::iterator it = links.begin (); it != links.end (); ++it)
+    {
+      if ((*it)->GetState () == LINK_UNAVAILABLE)
+        {
+          continue;
+        }
+      if (m_piggybacked.find (Mac48Address::ConvertFrom ((*it)->GetRemoteAddress ())) == m_piggybacked.end ())
+        {
+          return false;
+        }
+      covered = true;
+    }
+  return covered;
+}
+
+void
+NeighbourhoodDetectionAgent::NotifyPiggybacked (const Mac48Address& address)
+{
+  m_piggybacked[address] = Simulator::Now ();
+}
+
+Time
+NeighbourhoodDetectionAgent::AdaptHelloIntervall ()
+{
+  Time now = Simulator::Now ();
+  double elapsed = (now - m_lastAdapted).GetSeconds ();
+  m_lastAdapted = now;
+
+  ExpireNeighbours ();
+
+  if (elapsed > 0)
+    {
+      m_churnRate = 0.75 * m_churnRate + 0.25 * (m_neighbourEvents / elapsed);
+    }
+  m_neighbourEvents = 0;
+  m_busyRatio = 0.9 * m_busyRatio + 0.1 * SampleChannelBusy ();
+
+  // Each change in the neighbourhood should be seen within about one intervall,
+  // a neighbourhood without changes puts no bound on it
+  double intervall = m_maxHelloIntervall.GetSeconds ();
+  if (m_churnRate > 0)
+    {
+      intervall = min (intervall, 1 / m_churnRate);
+    }
+
+  // Send at least four hellos while a neighbour crosses the range
+  Ptr<BundleProtocolAgent> bpa = m_node->GetObject<BundleProtocolAgent> ();
+  if (bpa != 0 && bpa->GetConvergenceLayerAgent () != 0)
+    {
+      double speed = GetRelativeSpeed ();
+      double range = bpa->GetConvergenceLayerAgent ()->GetTransmissionRange ();
+      if (speed > 0 && range > 0)
+        {
+          intervall = min (intervall, range / (4 * speed));
+        }
+    }
+
+  // Back off when the channel is busy, a hello then costs others airtime
+  intervall /= max (0.1, 1 - m_busyRatio);
+
+  // Shortened at once, but only grown step by step, so one quiet period does not hide the next contact
+  double current = m_currentIntervall.IsZero () ? m_helloIntervall.GetSeconds () : m_currentIntervall.GetSeconds ();
+  intervall = min (intervall, 2 * current);
+
+  intervall = max (m_minHelloIntervall.GetSeconds (), min (m_maxHelloIntervall.GetSeconds (), intervall));
+  m_currentIntervall = Seconds (intervall);
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") churn = " << m_churnRate << "/s busy = " << m_busyRatio << " intervall = " << intervall << "s");
+  m_intervallLogger (m_currentIntervall);
+  return m_currentIntervall;
+}
+
+double
+NeighbourhoodDetectionAgent::GetRelativeSpeed () const
+{
+  Ptr<MobilityModel> mobility = m_node->GetObject<MobilityModel> ();
+  if (mobility == 0)
+    {
+      return 0;
+    }
+  // Nodes not heard yet may stand still
+  Vector velocity = mobility->GetVelocity ();
+  double fastest = sqrt (velocity.x * velocity.x + velocity.y * velocity.y);
+
+  Ptr<BundleProtocolAgent> bpa = m_node->GetObject<BundleProtocolAgent> ();
+  if (bpa == 0 || bpa->GetBundleRouter () == 0)
+    {
+      return fastest;
+    }
+  Links links = bpa->GetBundleRouter ()->GetLinkManager ()->GetAllLinks ();
+  for (Links::iterator it = links.begin (); it != links.end (); ++it)
+    {
+      if ((*it)->GetState () == LINK_UNAVAILABLE || !(*it)->HasPeerMobility ())
+        {
+          continue;
+        }
+      Vector peer = (*it)->GetPeerVelocity ();
+      double vx = peer.x - velocity.x;
+      double vy = peer.y - velocity.y;
+      fastest = max (fastest, sqrt (vx * vx + vy * vy));
+    }
+  return fastest;
+}
+
+void
+NeighbourhoodDetectionAgent::ExpireNeighbours ()
+{
+  // Neighbours that has been silent for a few of the longest intervalls has left
+  Time now = Simulator::Now ();
+  double timeout = 3 * (m_adaptiveHello ? m_maxHelloIntervall : m_helloIntervall).GetSeconds ();
+  map<Address, Time>::iterator iter = m_neighbours.begin ();
+  while (iter != m_neighbours.end ())
+    {
+      if ((now - iter->second).GetSeconds () > timeout)
+        {
+          m_neighbours.erase (iter++);
+          ++m_neighbourEvents;
+        }
+      else
+        {
+          ++iter;
+        }
+    }
+}
+
+void
+NeighbourhoodDetectionAgent::HelloSent (Ptr<Socket> socket, uint32_t bytes)
+{
+  m_sentBytesLogger (bytes);
+}
+
+double
+NeighbourhoodDetectionAgent::SampleChannelBusy () const
+{
+  // One sample per hello, the jitter makes the sampling times random
+  Ptr<WifiNetDevice> wifi = DynamicCast<WifiNetDevice> (m_device);
+  if (wifi == 0 || wifi->GetPhy () == 0)
+    {
+      return 0;
+    }
+  return wifi->GetPhy ()->IsStateIdle () ? 0 : 1;
+}
+
 void
 NeighbourhoodDetectionAgent::SendHello ()
 {
@@ -217,14 +480,39 @@ NeighbourhoodDetectionAgent::HandleHello (Ptr<Socket> socket)
 
   Simulator::ScheduleNow (&NeighbourhoodDetectionAgent::NotifyDiscoveredLink, this, receivedHello, fromAddress);
   */
-	if (!m_handleHelloCb.IsNull()) {
-		m_handleHelloCb (socket);
-	}
+  Address fromAddress;
+  Ptr<Packet> receivedHello = socket->RecvFrom (fromAddress);
+
+  // Parsed once here, the router and the link manager share the result
+  Ptr<DecodedHello> hello = HelloDecoderRegistry::Decode (receivedHello);
+  if (hello == 0)
+    {
+      NS_LOG_DEBUG ("(" << m_node->GetId () << ") dropped a hello that could not be decoded");
+      return;
+    }
+
+  if (!m_handleHelloCb.IsNull ())
+    {
+      m_handleHelloCb (hello, fromAddress);
+    }
+  Simulator::ScheduleNow (&NeighbourhoodDetectionAgent::NotifyDiscoveredLink, this, hello, fromAddress);
 }
 
 void
-NeighbourhoodDetectionAgent::NotifyDiscoveredLink (Ptr<Packet> hello, Address fromAddress)
+NeighbourhoodDetectionAgent::NotifyDiscoveredLink (Ptr<DecodedHello> hello, Address fromAddress)
 {
+  // Kept for fixed intervalls as well, NewNeighbour measures the detection latency
+  map<Address, Time>::iterator iter = m_neighbours.find (fromAddress);
+  if (iter == m_neighbours.end ())
+    {
+      m_neighbours.insert (make_pair (fromAddress, Simulator::Now ()));
+      ++m_neighbourEvents;
+      m_newNeighbourLogger (fromAddress);
+    }
+  else
+    {
+      iter->second = Simulator::Now ();
+    }
   if (!m_discoveredLinkCb.IsNull ())
     m_discoveredLinkCb (hello, fromAddress);    
 }
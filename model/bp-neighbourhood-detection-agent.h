@@ -20,8 +20,10 @@
 #include "bp-bundle-protocol-agent.h"
 #include "bp-convergence-layer-agent.h"
 #include "bp-neigh-header.h"
+#include "bp-hello-decoder.h"
 #include <iostream>
 #include <string>
+#include <map>
 
 
 #define HELLO_MAX_JITTER (m_helloIntervall.GetSeconds() / 5)
@@ -52,7 +54,7 @@ public:
   ~NeighbourhoodDetectionAgent ();
   virtual void DoDispose ();
   
-  virtual void SetDiscoveredLinkCallback (Callback<void, Ptr<Packet>, Address > discoveredLinkCb);
+  virtual void SetDiscoveredLinkCallback (Callback<void, Ptr<DecodedHello>, Address > discoveredLinkCb);
 
   void SetNode (Ptr<Node> node);
   void SetNetDevice (Ptr<NetDevice> device);
@@ -61,6 +63,10 @@ public:
   Ptr<NetDevice> GetDevice () const;
   BundleEndpointId GetBundleEndpointId () const;
   Time GetHelloIntervall () const;
+  /**
+   * \return The intervall used for the next hello, differs from HelloIntervall when AdaptiveHello is set.
+   */
+  Time GetCurrentHelloIntervall () const;
 
   virtual void Init ();
   virtual void Start ();
@@ -70,17 +76,56 @@ public:
   void SetSendHelloCallback (Callback<void, Ptr<Socket>, BundleEndpointId > sendHelloCb) {
 	  m_sendHelloCb = sendHelloCb;
   }
-  void SetHandleHelloCallback (Callback<void, Ptr<Socket> > handleHelloCb) {
+  void SetHandleHelloCallback (Callback<void, Ptr<DecodedHello>, Address > handleHelloCb) {
 	  m_handleHelloCb = handleHelloCb;
   }
-  virtual void NotifyDiscoveredLink (Ptr<Packet> hello, Address fromAddress);
+  virtual void NotifyDiscoveredLink (Ptr<DecodedHello> hello, Address fromAddress);
   /* sergiosvieira */
+  /**
+   * \brief Called by the convergence layer when a segment carrying neighbour info has been sent.
+   * \param address The neighbour the segment was sent to.
+   */
+  void NotifyPiggybacked (const Mac48Address& address);
   bool GetStatus(){return m_started;}      
 private:
   virtual void HelloTimerExpire ();
   virtual void SendHello ();
   virtual void HandleHello (Ptr<Socket> socket);
 
+  /**
+   * \brief Calculates the intervall until the next hello.
+   *
+   * The intervall is short when the neighbourhood changes fast (new or lost
+   * neighbours per second) or when the node moves fast, relative to its
+   * neighbours, compared to its range, and it is made longer when the channel
+   * is busy. A neighbourhood that is calm and slow lets it grow towards
+   * MaxHelloIntervall, at most doubling from one hello to the next, starting
+   * from HelloIntervall. The result is kept within MinHelloIntervall and
+   * MaxHelloIntervall.
+   */
+  Time AdaptHelloIntervall ();
+  /**
+   * \return The highest speed relative to the neighbours whose mobility is known,
+   * and at least the speed of the node towards the ones that are not.
+   */
+  double GetRelativeSpeed () const;
+  double SampleChannelBusy () const;
+  /**
+   * \brief Forgets the neighbours that have been silent for three of the longest hello intervalls.
+   */
+  void ExpireNeighbours ();
+  void HelloSent (Ptr<Socket> socket, uint32_t bytes);
+
+  void SendOrSuppressHello ();
+  /**
+   * \brief Checks if every neighbour has heard from us through data segments or acks during the last intervall.
+   *
+   * Hellos are broadcasted, so one is only left out when all links are covered.
+   * At most MaxSuppressedHellos hellos in a row are left out, so that nodes not
+   * yet in the neighbourhood still can discover us.
+   */
+  bool SuppressHello ();
+
 
   Ptr<Node> m_node;
   Ptr<NetDevice> m_device;
@@ -88,15 +133,35 @@ private:
   Time m_helloIntervall;
   Timer m_helloTimer;
 
+  // Adaptive hello
+  bool m_adaptiveHello;
+  Time m_minHelloIntervall;
+  Time m_maxHelloIntervall;
+  Time m_currentIntervall;
+  Time m_lastAdapted;
+  map<Address, Time> m_neighbours;
+  uint32_t m_neighbourEvents;
+  double m_churnRate; // new and lost neighbours per second
+  double m_busyRatio;
+
+  // Hello suppression while data flows
+  map<Mac48Address, Time> m_piggybacked;
+  uint32_t m_suppressedHellos;
+  uint32_t m_maxSuppressedHellos;
+
   bool m_started;
   Ptr<Socket> m_socket;
-  Callback<void, Ptr<Packet>, Address > m_discoveredLinkCb;
+  Callback<void, Ptr<DecodedHello>, Address > m_discoveredLinkCb;
   /* sergiosvieira */
   Callback<void, Ptr<Socket>, BundleEndpointId > m_sendHelloCb;
-  Callback<void, Ptr<Socket> > m_handleHelloCb;
+  Callback<void, Ptr<DecodedHello>, Address > m_handleHelloCb;
   /* sergiosvieira */
   TracedCallback<Ptr<const Packet> > m_sendLogger;
   TracedCallback<Ptr<const Packet> > m_receiveLogger;
+  TracedCallback<Time> m_intervallLogger;
+  TracedCallback<const Address&> m_newNeighbourLogger;
+  TracedCallback<uint32_t> m_sentBytesLogger;
+  TracedCallback<uint32_t> m_suppressLogger;
 };
 
 }} // namespace bundleProtocol, ns3
@@ -0,0 +1,213 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "ns3/log.h"
+
+#include "bp-node-activity.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+NS_LOG_COMPONENT_DEFINE ("NodeActivity");
+
+NodeActivity::Times::Times ()
+  : m_hasStart (false),
+    m_start (0),
+    m_hasEnd (false),
+    m_end (0)
+{}
+
+bool
+Ns2TraceLine::Parse (const string& line)
+{
+  string::size_type open = line.find ("$node_(");
+  if (open == string::npos)
+    {
+      return false;
+    }
+  char *close;
+  m_node = strtoul (line.c_str () + open + 7, &close, 10);
+  if (*close != ')')
+    {
+      return false;
+    }
+
+  m_hasTime = false;
+  m_time = 0;
+  istringstream prefix (line);
+  string ns, at, field;
+  prefix >> ns >> at >> field;
+  if (ns == "$ns_" && at == "at")
+    {
+      const char *start = field.c_str ();
+      char *end;
+      m_time = strtod (start, &end);
+      m_hasTime = end != start;
+    }
+
+  // The command after the node, without the closing quote
+  string rest = string (close + 1);
+  replace (rest.begin (), rest.end (), '"', ' ');
+  istringstream iss (rest);
+  string command;
+  iss >> command;
+
+  m_command = NS2_OTHER;
+  m_x = 0;
+  m_y = 0;
+  m_speed = 0;
+  if (command == "setdest")
+    {
+      iss >> m_x >> m_y >> m_speed;
+      if (!iss.fail ())
+        {
+          m_command = NS2_SETDEST;
+        }
+    }
+  else if (command == "set")
+    {
+      string coordinate;
+      iss >> coordinate >> m_x;
+      if (iss.fail ())
+        {
+          m_x = 0;
+        }
+      else if (coordinate == "X_")
+        {
+          m_command = NS2_SET_X;
+        }
+      else if (coordinate == "Y_")
+        {
+          m_command = NS2_SET_Y;
+        }
+      else if (coordinate == "Z_")
+        {
+          m_command = NS2_SET_Z;
+        }
+    }
+  return true;
+}
+
+NodeActivity::NodeActivity ()
+  : m_times ()
+{}
+
+NodeActivity::~NodeActivity ()
+{}
+
+map<string, Ptr<NodeActivity> >&
+NodeActivity::GetTables ()
+{
+  // Shared by every router of the simulation, so each trace is only read once
+  static map<string, Ptr<NodeActivity> > tables;
+  return tables;
+}
+
+Ptr<NodeActivity>
+NodeActivity::Get (const string& filename)
+{
+  map<string, Ptr<NodeActivity> >::iterator iter = GetTables ().find (filename);
+  if (iter != GetTables ().end ())
+    {
+      return iter->second;
+    }
+
+  Ptr<NodeActivity> table = Create<NodeActivity> ();
+  table->Load (filename);
+  GetTables ()[filename] = table;
+  return table;
+}
+
+void
+NodeActivity::Add (const string& filename, Ptr<NodeActivity> table)
+{
+  GetTables ()[filename] = table;
+}
+
+void
+NodeActivity::SetStartTime (uint32_t node, double time)
+{
+  Times& times = m_times[node];
+  times.m_hasStart = true;
+  times.m_start = time;
+}
+
+void
+NodeActivity::SetEndTime (uint32_t node, double time)
+{
+  Times& times = m_times[node];
+  times.m_hasEnd = true;
+  times.m_end = time;
+}
+
+void
+NodeActivity::Load (const string& filename)
+{
+  ifstream file (filename.c_str ());
+  if (!file.is_open ())
+    {
+      NS_LOG_WARN ("Can not open the mobility trace " << filename);
+      return;
+    }
+
+  string line;
+  Ns2TraceLine parsed;
+  while (getline (file, line))
+    {
+      if (parsed.Parse (line))
+        {
+          Update (parsed);
+        }
+    }
+
+  NS_LOG_DEBUG ("Read the activity of " << m_times.size () << " nodes from " << filename);
+}
+
+void
+NodeActivity::Update (const Ns2TraceLine& line)
+{
+  Times& times = m_times[line.m_node];
+  times.m_hasEnd = line.m_hasTime;
+  times.m_end = line.m_hasTime ? line.m_time : 0;
+  if (line.m_hasTime && !times.m_hasStart)
+    {
+      times.m_hasStart = true;
+      times.m_start = line.m_time;
+    }
+}
+
+bool
+NodeActivity::GetStartTime (uint32_t node, double& time) const
+{
+  map<uint32_t, Times>::const_iterator iter = m_times.find (node);
+  if (iter == m_times.end () || !iter->second.m_hasStart)
+    {
+      return false;
+    }
+  time = iter->second.m_start;
+  return true;
+}
+
+bool
+NodeActivity::GetEndTime (uint32_t node, double& time) const
+{
+  map<uint32_t, Times>::const_iterator iter = m_times.find (node);
+  if (iter == m_times.end () || !iter->second.m_hasEnd)
+    {
+      return false;
+    }
+  time = iter->second.m_end;
+  return true;
+}
+
+uint32_t
+NodeActivity::GetNNodes () const
+{
+  return m_times.size ();
+}
+
+}} // namespace bundleProtocol, ns3
@@ -0,0 +1,116 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_NODE_ACTIVITY_H
+#define BP_NODE_ACTIVITY_H
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+#include "ns3/ptr.h"
+#include "ns3/ref-count-base.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief One line of an ns-2 mobility trace about a node.
+ *
+ *   $node_(0) set X_ 150.0
+ *   $ns_ at 2.0 "$node_(0) setdest 150.0 100.0 5.0"
+ *
+ * Shared by NodeActivity and Ns2MobilityCacheHelper, so both read a trace
+ * the same way.
+ */
+struct Ns2TraceLine
+{
+  enum Command
+  {
+    NS2_OTHER = 0,
+    NS2_SETDEST,
+    NS2_SET_X,
+    NS2_SET_Y,
+    NS2_SET_Z
+  };
+
+  /**
+   * \return False if the line is not about a $node_(N).
+   */
+  bool Parse (const string& line);
+
+  uint32_t m_node;
+  bool m_hasTime; // Only the lines that start with "$ns_ at <time>"
+  double m_time;
+  Command m_command; // NS2_OTHER also for a command whose arguments can not be read
+  double m_x; // Destination, or the new coordinate for the NS2_SET_*
+  double m_y;
+  double m_speed;
+};
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief When each node of an ns-2 mobility trace starts and stops moving.
+ *
+ * The start time is the time of the first timed line of a node and the end
+ * time the time of its last line, if that line is timed. The trace is read
+ * once and the table is shared, read only, by all the routers that use the
+ * same trace.
+ */
+class NodeActivity : public RefCountBase
+{
+public:
+  NodeActivity ();
+  virtual ~NodeActivity ();
+
+  /**
+   * \param filename The ns-2 mobility trace.
+   * \return The table of the trace, read on the first call for each file.
+   */
+  static Ptr<NodeActivity> Get (const string& filename);
+  /**
+   * \brief Makes Get return this table for the trace, when it was built without reading the trace.
+   */
+  static void Add (const string& filename, Ptr<NodeActivity> table);
+
+  void SetStartTime (uint32_t node, double time);
+  void SetEndTime (uint32_t node, double time);
+  /**
+   * \brief Takes the line into account, as when it is read from the trace.
+   */
+  void Update (const Ns2TraceLine& line);
+
+  /**
+   * \return False if the node has no "at" line in the trace.
+   */
+  bool GetStartTime (uint32_t node, double& time) const;
+  /**
+   * \return False if the node is not in the trace or its last line has no time.
+   */
+  bool GetEndTime (uint32_t node, double& time) const;
+  uint32_t GetNNodes () const;
+
+private:
+  struct Times
+  {
+    Times ();
+
+    bool m_hasStart;
+    double m_start;
+    bool m_hasEnd;
+    double m_end;
+  };
+
+  static map<string, Ptr<NodeActivity> >& GetTables ();
+  void Load (const string& filename);
+
+  map<uint32_t, Times> m_times;
+};
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_NODE_ACTIVITY_H */
@@ -40,6 +40,10 @@ OrwarLinkManager::~OrwarLinkManager() {
 }
 
 void OrwarLinkManager::DoDispose() {
+	for (ContactTimers::iterator iter = m_contactTimers.begin(); iter != m_contactTimers.end(); ++iter) {
+		iter->second.Cancel();
+	}
+	m_contactTimers.clear();
 	LinkManager::DoDispose();
 }
 
@@ -52,23 +56,31 @@ Time OrwarLinkManager::GetCwMaxHoldTime() const {
 }
 
 void OrwarLinkManager::CloseLink(Ptr<Link> link) {
+	ContactTimers::iterator iter = m_contactTimers.find(link);
+	if (iter != m_contactTimers.end()) {
+		iter->second.Cancel();
+		iter->second.Remove();
+	}
 	LinkManager::CloseLink(link);
 }
 
-void OrwarLinkManager::DiscoveredLink(Ptr<Packet> hello, Address fromAddress) {
+void OrwarLinkManager::RemoveLink(Ptr<Link> link) {
+	m_contactTimers.erase(link);
+	LinkManager::RemoveLink(link);
+}
+
+void OrwarLinkManager::DiscoveredLink(Ptr<DecodedHello> hello, Address fromAddress) {
 	PacketSocketAddress packetAddress = PacketSocketAddress::ConvertFrom(
 			fromAddress);
 	Mac48Address peerMac = Mac48Address::ConvertFrom(
 			packetAddress.GetPhysicalAddress());
 
-	HelloHeader header;
-	hello->PeekHeader(header);
-
-	BundleEndpointId eid = header.GetBundleEndpointId();
+	BundleEndpointId eid = hello->GetBundleEndpointId();
 
 	if (HasLink(eid)) {
 		Ptr<Link> oldLink = FindLink(eid);
 		oldLink->UpdateLastHeardFrom();
+		UpdatePeerMobility(oldLink, hello);
 		if (oldLink->GetState() == LINK_UNAVAILABLE) {
 			oldLink->ChangeState(LINK_AVAILABLE);
 			ContactSetup(oldLink, true);
@@ -78,9 +90,9 @@ void OrwarLinkManager::DiscoveredLink(Ptr<Packet> hello, Address fromAddress) {
 		Ptr<Link> link = m_createLinkCb(eid, peerMac);
 		link->ChangeState(LINK_AVAILABLE);
 		link->UpdateLastHeardFrom();
-		LinkTimer lt = make_pair<Ptr<Link> , Timer> (link, Timer(
-				Timer::REMOVE_ON_DESTROY));
-		m_links.insert(lt);
+		UpdatePeerMobility(link, hello);
+		m_links.insert(link);
+		m_contactTimers.insert(make_pair(link, Timer(Timer::REMOVE_ON_DESTROY)));
 		//m_linkSet.push_back (link);
 		ContactSetup(link, true);
 		NotifyLinkIsAvailable(link);
@@ -95,9 +107,8 @@ void OrwarLinkManager::AddLink(Ptr<Link> link) {
 		ContactSetup(oldLink, false);
 	} else {
 		link->UpdateLastHeardFrom();
-		LinkTimer lt = make_pair<Ptr<Link> , Timer> (link, Timer(
-				Timer::REMOVE_ON_DESTROY));
-		m_links.insert(lt);
+		m_links.insert(link);
+		m_contactTimers.insert(make_pair(link, Timer(Timer::REMOVE_ON_DESTROY)));
 		//m_linkSet.push_back (link);
 		ContactSetup(link, false);
 	}
@@ -143,7 +154,7 @@ Links OrwarLinkManager::GetConnectedLinks() {
 void OrwarLinkManager::CheckIfExpired(Ptr<Link> l) {
 	Ptr<OrwarLink> link = dynamic_cast<OrwarLink *> (PeekPointer(l));
 
-	LinkMap::iterator iter = m_links.find(link);
+	ContactTimers::iterator iter = m_contactTimers.find(link);
 
 	if (link->GetState() == LINK_AVAILABLE) {
 		CloseLink(link);
@@ -168,7 +179,7 @@ void OrwarLinkManager::CheckIfExpired(Ptr<Link> l) {
 
 void OrwarLinkManager::ContactSetup(Ptr<Link> l, bool sender) {
 	Ptr<OrwarLink> link = dynamic_cast<OrwarLink *> (PeekPointer(l));
-	LinkMap::iterator iter = m_links.find(link);
+	ContactTimers::iterator iter = m_contactTimers.find(link);
 	//link->m_expirationTimer.SetFunction (&OrwarLinkManager::CheckIfExpired, this);
 	//link->m_expirationTimer.SetArguments (l);
 	iter->second.SetFunction(&OrwarLinkManager::CheckIfExpired, this);
@@ -186,7 +197,7 @@ void OrwarLinkManager::FinishedSetup(Ptr<Link> l) {
 	Ptr<OrwarContact> oc = dynamic_cast<OrwarContact *> (PeekPointer(
 			l->GetContact()));
 
-	LinkMap::iterator iter = m_links.find(link);
+	ContactTimers::iterator iter = m_contactTimers.find(link);
 
 	//link->m_expirationTimer.Cancel ();
 	//link->m_expirationTimer.Remove ();
@@ -203,12 +214,7 @@ void OrwarLinkManager::FinishedSetup(Ptr<Link> l) {
 }
 
 void OrwarLinkManager::RecalculateContactWindows() {
-	Links linkSet;
-	linkSet.reserve(m_links.size());
-
-	for (LinkMap::iterator iter = m_links.begin(); iter != m_links.end(); ++iter) {
-		linkSet.push_back(iter->first);
-	}
+	Links linkSet(m_links.begin(), m_links.end());
 
 	Links links;
 	remove_copy_if(linkSet.begin(), linkSet.end(), back_inserter(links),
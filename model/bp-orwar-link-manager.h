@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <deque>
+#include <map>
 
 #include "ns3/object.h"
 #include "ns3/callback.h"
@@ -19,7 +20,6 @@
 #include "bp-contact.h"
 #include "bp-orwar-contact.h"
 #include "bp-bundle-endpoint-id.h"
-#include "bp-hello-header.h"
 
 namespace ns3 {
 namespace bundleProtocol {
@@ -41,12 +41,13 @@ public:
   OrwarLinkManager ();
   virtual ~OrwarLinkManager ();
 
-  void DiscoveredLink (Ptr<Packet> hello, Address fromAddress);
+  void DiscoveredLink (Ptr<DecodedHello> hello, Address fromAddress);
 
   Time GetSetupHoldTime () const;
   Time GetCwMaxHoldTime () const;
   void AddLink (Ptr<Link> link);
   void CloseLink (Ptr<Link> link);
+  void RemoveLink (Ptr<Link> link);
 
   virtual Ptr<Link> FindLink (const BundleEndpointId& eid);
   virtual Ptr<Link> FindLink (const Mac48Address& address);
@@ -63,8 +64,12 @@ protected:
   virtual void DoDispose ();
   virtual void CheckIfExpired (Ptr<Link> link);
 
+  /* The contact setup and contact window of each link expire with its own timer */
+  typedef map<Ptr<Link>, Timer> ContactTimers;
+
   Time m_setupHold;
   Time m_cwMaxHold;
+  ContactTimers m_contactTimers;
 
 struct KeepReady : public unary_function <Ptr<Link>, bool>
 {
@@ -73,7 +78,7 @@ struct KeepReady : public unary_function <Ptr<Link>, bool>
     if (link->GetState () == LINK_CONNECTED)
       {
         Ptr<OrwarContact> oc = dynamic_cast<OrwarContact *> (PeekPointer (link->GetContact ()));
-        if (oc->GetState () == READY)
+        if (oc != 0 && oc->GetState () == READY)
           {
             return false;
           }
@@ -94,7 +99,7 @@ struct KeepHasCw : public unary_function <Ptr<Link>, bool>
   bool operator() (Ptr<Link> l)
   {
     Ptr<OrwarLink> link = dynamic_cast<OrwarLink *> (PeekPointer (l));
-    return !link->HaveCw ();
+    return link == 0 || !link->HaveCw ();
   }
 };
 
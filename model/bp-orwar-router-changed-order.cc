@@ -29,6 +29,9 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (OrwarRouterChangedOrder);
 
+/* Orwar Type */
+static HelloDecoderRegistrar g_orwarHelloDecoder (8, &DecodeHello<NeighHeader>);
+
 TypeId
 OrwarRouterChangedOrder::GetTypeId (void)
 {
@@ -284,7 +287,7 @@ OrwarRouterChangedOrder::DoBundleSent (const Address& address, const GlobalBundl
         }
       else 
         {
-          m_forwardLog.AddEntry (bundle, link);
+          AddForwardLogEntry (bundle, link);
           if (finalDelivery)
             {
               BundleDelivered (bundle, true);
@@ -388,26 +391,14 @@ OrwarRouterChangedOrder::CanMakeRoomForBundle (Ptr<Bundle> bundle)
 bool
 OrwarRouterChangedOrder::MakeRoomForBundle (Ptr<Bundle> bundle)
 {
-  if (bundle->GetSize () < m_maxBytes)
-    {
-      if (bundle->GetSize () < GetFreeBytes ())
-        {
-          return true;
-        }
-
-      for (BundleList::reverse_iterator iter = m_bundleList.rbegin (); iter != m_bundleList.rend ();)
-        {
-          Ptr<Bundle> currentBundle = *(iter++);
-
-          DeleteBundle (currentBundle,true);
-          if (bundle->GetSize () < GetFreeBytes ())
-            {
-              return true;
-            }
-        }
-    }
+  return EvictBundlesFor (bundle);
+}
 
-  return false;
+EvictionPolicy
+OrwarRouterChangedOrder::DoGetDefaultEvictionPolicy () const
+{
+  // The bundle with the lowest utility per bit was always dropped first
+  return EVICT_LOWEST_UTILITY_PER_BIT;
 }
 
 bool
@@ -486,7 +477,7 @@ OrwarRouterChangedOrder::TryToStartSending ()
   //NS_LOG_DEBUG ("(" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::TryToStartSending");
   ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::TryToStartSending" << endl;
   RemoveExpiredBundles (true);
-  m_forwardLog.RemoveExpiredEntries ();
+  RemoveExpiredForwardLogEntries ();
   
   if (!IsSending () && ((GetNBundles () > 0) || (m_routerSpecificList.size () > 0)))
     {
@@ -500,7 +491,6 @@ OrwarRouterChangedOrder::TryToStartSending ()
     }
   else 
     {
-      Ptr<OrwarLinkManager> olm (dynamic_cast<OrwarLinkManager *> (PeekPointer (m_linkManager)));
       ///cout << Simulator::Now ().GetSeconds () << " Could not start sending: " << endl;
       ///cout << Simulator::Now ().GetSeconds () << " !IsSending = " << !IsSending () << endl;
       ///cout << Simulator::Now ().GetSeconds () << " GetNBundles () = " << GetNBundles () << endl;
@@ -536,22 +526,22 @@ OrwarRouterChangedOrder::FindNextToSend ()
   //Ptr<OrwarLinkManager> olm ((OrwarLinkManager *) (PeekPointer (m_linkManager)));
   if ((olm->GetReadyLinks ().size () > 0) && (GetNBundles () > 0))
     {
-      LinkBundleList linkBundleList = GetAllDeliverableBundles ();
+      BestUtilityPerBit best;
+      VisitDeliverableBundles (best);
       
-      if (linkBundleList.empty ())
+      if (best.GetLinkBundle ().IsNull ())
         {
           ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "Want to forward a bundle" << endl;
-          linkBundleList = GetAllBundlesToAllLinks ();
+          VisitBundlesToAllLinks (best);
         }
       else
         {
           ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") " << "Want to delivery a bundle" << endl;
         }
       
-      if (!linkBundleList.empty ())
+      if (!best.GetLinkBundle ().IsNull ())
         {
-          sort (linkBundleList.begin (), linkBundleList.end (), UtilityPerBitCompare2 ());
-          return linkBundleList.front ();
+          return best.GetLinkBundle ();
         }
     }
   //cout << "GetNBundles () = " << GetNBundles () << endl;
@@ -582,6 +572,10 @@ OrwarRouterChangedOrder::GetNextRouterSpecific ()
       if (header.GetBlockType () == KNOWN_DELIVERED_MESSAGES_BLOCK)
         {
           Ptr<OrwarContact> oc = dynamic_cast<OrwarContact *> (PeekPointer (link->GetContact ()));
+          if (oc == 0)
+            {
+              continue;
+            }
           double txTime = oc->GetDataRate ().CalculateTxTime (EstimateNeededBytes (rsBundle));
           
           if (txTime <= oc->GetContactWindowDuration ().GetSeconds ())
@@ -598,36 +592,35 @@ OrwarRouterChangedOrder::GetNextRouterSpecific ()
   return LinkBundle (0,0);
 }
 
-LinkBundleList
-OrwarRouterChangedOrder::GetAllDeliverableBundles ()
+bool
+OrwarRouterChangedOrder::VisitDeliverableBundles (LinkBundleVisitor& visitor)
 {
-  //NS_LOG_DEBUG ("(" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::GetAllDeliverableBundles");
-  ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::GetAllDeliverableBundles" << endl;
+  //NS_LOG_DEBUG ("(" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::VisitDeliverableBundles");
+  ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::VisitDeliverableBundles" << endl;
 
   //Ptr<OrwarLinkManager> olm (dynamic_cast<OrwarLinkManager *> (PeekPointer (m_linkManager)));
   Ptr<LinkManager> olm (dynamic_cast<LinkManager *> (PeekPointer (m_linkManager)));
 
   Links links = olm->GetReadyLinks ();
-  LinkBundleList result;
   for (Links::iterator iter = links.begin (); iter != links.end (); ++iter)
     {
-      Ptr<Link> link = *iter;
-      LinkBundleList linkBundleList = GetAllBundlesForLink (link);
-      result.insert (result.end (), linkBundleList.begin (), linkBundleList.end ());
+      if (!VisitBundlesForLink (*iter, visitor))
+        {
+          return false;
+        }
     }
-  return result;
+  return true;
 }
 
-LinkBundleList
-OrwarRouterChangedOrder::GetAllBundlesForLink (Ptr<Link> link)
+bool
+OrwarRouterChangedOrder::VisitBundlesForLink (Ptr<Link> link, LinkBundleVisitor& visitor)
 {
-  //NS_LOG_DEBUG ("(" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder:: GetAllBundlesForLink");
-  ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::GetAllBundlesForLink (" << link->GetRemoteEndpointId ().GetId () << ")" << endl;
-  LinkBundleList linkBundleList;
+  //NS_LOG_DEBUG ("(" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::VisitBundlesForLink");
+  ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::VisitBundlesForLink (" << link->GetRemoteEndpointId ().GetId () << ")" << endl;
   if (link->GetState () == LINK_CONNECTED)
     {
       Ptr<OrwarContact> oc = dynamic_cast<OrwarContact *> (PeekPointer (link->GetContact ()));
-      if (oc->GetState () == READY)
+      if (oc != 0 && oc->GetState () == READY)
         {
           ///cout << m_bundleList.size () << endl;
           ///cout << GetNBundles () << endl;
@@ -653,29 +646,36 @@ OrwarRouterChangedOrder::GetAllBundlesForLink (Ptr<Link> link)
                   (link->GetRemoteEndpointId () == bundle->GetDestinationEndpoint ()) &&
                   !m_forwardLog.HasEntry (bundle, link))
                 {
-                  linkBundleList.push_back (LinkBundle (link, *iter));
+                  if (!visitor.Visit (link, bundle))
+                    {
+                      return false;
+                    }
                 }
             }
         }
     }
-  return linkBundleList;
+  return true;
 }
 
-LinkBundleList
-OrwarRouterChangedOrder::GetAllBundlesToAllLinks ()
+bool
+OrwarRouterChangedOrder::VisitBundlesToAllLinks (LinkBundleVisitor& visitor)
 {
-  //NS_LOG_DEBUG ("(" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder:: GetAllBundlesToAllLinks");
-  ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::GetAllBundlesToAllLinks" << endl;
+  //NS_LOG_DEBUG ("(" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::VisitBundlesToAllLinks");
+  ///cout << Simulator::Now ().GetSeconds () << " (" << m_node->GetId () << ") "  << "OrwarRouterChangedOrder::VisitBundlesToAllLinks" << endl;
   //Ptr<OrwarLinkManager> olm (dynamic_cast<OrwarLinkManager *> (PeekPointer (m_linkManager)));
   Ptr<LinkManager> olm (dynamic_cast<LinkManager *> (PeekPointer (m_linkManager)));
   Links links = olm->GetReadyLinks ();
-  LinkBundleList linkBundleList;
 
   for (Links::iterator iter = links.begin (); iter != links.end (); ++iter)
     {
       Ptr<Link> link = *iter;
       Ptr<OrwarContact> oc = dynamic_cast<OrwarContact *> (PeekPointer (link->GetContact ()));
       //Ptr<Contact> oc = dynamic_cast<Contact *> (PeekPointer (link->GetContact ()));
+      // Only links that have finished the contact setup have a contact window
+      if (link->GetState () != LINK_CONNECTED || oc == 0 || oc->GetState () != READY)
+        {
+          continue;
+        }
       for (BundleList::iterator it = m_bundleList.begin (); it != m_bundleList.end (); ++it)
         {
           Ptr<Bundle> bundle = *it;
@@ -698,11 +698,14 @@ OrwarRouterChangedOrder::GetAllBundlesToAllLinks ()
                bundle->GetReplicationFactor () > 1 &&
               !m_forwardLog.HasEntry (bundle, link))
             {
-              linkBundleList.push_back (LinkBundle (link, bundle));
+              if (!visitor.Visit (link, bundle))
+                {
+                  return false;
+                }
             }
         }
     }
-  return linkBundleList;
+  return true;
 }
 
 bool
@@ -1070,7 +1073,7 @@ OrwarRouterChangedOrder::RemoveDeliveredBundles (const KnownDeliveredMessages& k
       if (kdm.Has (bundle))
         {
           bl.push_back (bundle);
-          m_forwardLog.RemoveEntriesFor (bundle->GetBundleId ());
+          RemoveForwardLogEntries (bundle->GetBundleId ());
         }
     }
   
@@ -1255,4 +1258,33 @@ OrwarRouterChangedOrder::DoCreateLink (const BundleEndpointId& eid, const Addres
   return link;
 }
 
+void
+OrwarRouterChangedOrder::DoSendHello (Ptr<Socket> socket, BundleEndpointId eid)
+{
+  NeighHeader header;
+  header.SetBundleEndpointId (m_eid);
+  if (m_contactWindowAware)
+    {
+      Ptr<MobilityModel> mobility = m_node->GetObject<MobilityModel> ();
+      header.SetMobility (mobility->GetPosition (), mobility->GetVelocity ());
+    }
+
+  /* Orwar Type */
+  TypeTag type (8);
+
+  Ptr<Packet> hello = Create<Packet> ();
+  hello->AddPacketTag (type);
+  hello->AddHeader (header);
+
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << m_eid);
+
+  socket->Send (hello);
+}
+
+void
+OrwarRouterChangedOrder::DoHandleHello (Ptr<DecodedHello> hello, Address fromAddress)
+{
+  NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << hello->GetBundleEndpointId ());
+}
+
 }} // namespace bundleProtocol, ns3
@@ -60,6 +60,7 @@ private:
   bool DoCanDeleteBundle (const GlobalBundleIdentifier& gbid);
   void DoInsert (Ptr<Bundle> bundle);
   bool MakeRoomForBundle (Ptr<Bundle> bundle);
+  EvictionPolicy DoGetDefaultEvictionPolicy () const;
   bool DoDelete (const GlobalBundleIdentifier& gbid, bool drop);
   bool CanMakeRoomForBundle (Ptr<Bundle> bundle);
   void DoCancelTransmission (Ptr<Bundle> bundle, Ptr<Link> link);
@@ -70,9 +71,9 @@ private:
   
   Ptr<Link> DoCreateLink (const BundleEndpointId& eid, const Address& address);
 
-  LinkBundleList GetAllDeliverableBundles ();
-  LinkBundleList GetAllBundlesForLink (Ptr<Link> link);
-  LinkBundleList GetAllBundlesToAllLinks ();
+  bool VisitDeliverableBundles (LinkBundleVisitor& visitor);
+  bool VisitBundlesForLink (Ptr<Link> link, LinkBundleVisitor& visitor);
+  bool VisitBundlesToAllLinks (LinkBundleVisitor& visitor);
 
   LinkBundle GetNextRouterSpecific ();
 
@@ -98,6 +99,9 @@ private:
 
   void CalculateContactWindow (Ptr<Link> link, const ContactWindowInformation& cwi);
 
+  void DoSendHello (Ptr<Socket> socket, BundleEndpointId eid);
+  void DoHandleHello (Ptr<DecodedHello> hello, Address fromAddress);
+
   void PauseLink (Ptr<Link> link);
   void UnPauseLink (Ptr<Link> link);
 
@@ -147,6 +151,29 @@ struct UtilityPerBitCompare2
   }
 };
 
+// Keeps the candidate that sorting all of them with UtilityPerBitCompare2 would put first
+class BestUtilityPerBit : public LinkBundleVisitor
+{
+public:
+  bool Visit (Ptr<Link> link, Ptr<Bundle> bundle)
+  {
+    LinkBundle candidate (link, bundle);
+    if (m_best.IsNull () || UtilityPerBitCompare2 () (candidate, m_best))
+      {
+        m_best = candidate;
+      }
+    return true;
+  }
+
+  LinkBundle GetLinkBundle () const
+  {
+    return m_best;
+  }
+
+private:
+  LinkBundle m_best;
+};
+
 struct EqualEids : public std::unary_function<Ptr<Bundle>, bool>
 {
   BundleEndpointId m_eid;
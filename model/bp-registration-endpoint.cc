@@ -12,7 +12,11 @@ namespace bundleProtocol {
 NS_LOG_COMPONENT_DEFINE ("RegistrationEndpoint");
 
 RegistrationEndpoint::RegistrationEndpoint (BundleEndpointId eid)
-  : m_endpointId (eid)
+  : m_endpointId (eid),
+    m_pending (),
+    m_forwardUpEvent (),
+    m_freeBytes (0),
+    m_notifySendEvent ()
 {
 }
 
@@ -25,6 +29,9 @@ RegistrationEndpoint::~RegistrationEndpoint ()
   m_rxCallback = MakeNullCallback<void, Ptr<Packet>, BundleEndpointId> ();
   m_sendCallback = MakeNullCallback<void, uint32_t> ();
   m_destroyCallback = MakeNullCallback<void> ();
+  m_forwardUpEvent.Cancel ();
+  m_notifySendEvent.Cancel ();
+  m_pending.clear ();
 }
 
 BundleEndpointId 
@@ -60,31 +67,48 @@ RegistrationEndpoint::SetSendCallback (Callback<void, uint32_t> callback)
 void 
 RegistrationEndpoint::ForwardUp (Ptr<Packet> adu, BundleEndpointId address)
 {
-  if (!m_rxCallback.IsNull ())
+  if (m_rxCallback.IsNull ())
     {
-      Simulator::ScheduleNow (&RegistrationEndpoint::DoForwardUp, this, adu, address);
+      return;
+    }
+  m_pending.push_back (std::make_pair (adu, address));
+  if (!m_forwardUpEvent.IsRunning ())
+    {
+      m_forwardUpEvent = Simulator::ScheduleNow (&RegistrationEndpoint::DoForwardUp, this);
     }
 }
 
 void
 RegistrationEndpoint::NotifySend (uint32_t freeBytes)
 {
-  if (!m_sendCallback.IsNull ())
+  if (m_sendCallback.IsNull ())
+    {
+      return;
+    }
+  m_freeBytes = freeBytes;
+  if (!m_notifySendEvent.IsRunning ())
     {
-      Simulator::ScheduleNow (&RegistrationEndpoint::DoNotifySend, this, freeBytes);
-    } 
+      m_notifySendEvent = Simulator::ScheduleNow (&RegistrationEndpoint::DoNotifySend, this);
+    }
 }
   
 void
-RegistrationEndpoint::DoNotifySend (uint32_t freeBytes)
+RegistrationEndpoint::DoNotifySend ()
 {
-  m_sendCallback (freeBytes);
+  m_sendCallback (m_freeBytes);
 }
 
 void 
-RegistrationEndpoint::DoForwardUp (Ptr<Packet> p, BundleEndpointId address)
+RegistrationEndpoint::DoForwardUp ()
 {
-  m_rxCallback (p, address);
+  // Swapped out first, the callback may queue more adus
+  PendingAdus pending;
+  pending.swap (m_pending);
+  NS_LOG_DEBUG ("Forwarding " << pending.size () << " adus to " << m_endpointId);
+  for (PendingAdus::iterator iter = pending.begin (); iter != pending.end (); ++iter)
+    {
+      m_rxCallback (iter->first, iter->second);
+    }
 }
 
 }} // namespace bundleProtocol, ns3
@@ -3,10 +3,14 @@
 #ifndef BP_REGISTRATION_ENDPOINT_H
 #define BP_REGISTRATION_ENDPOINT_H
 
+#include <deque>
+#include <utility>
+
 #include "bp-bundle-endpoint-id.h"
 #include "ns3/ptr.h"
 #include "ns3/callback.h"
 #include "ns3/packet.h"
+#include "ns3/event-id.h"
 
 namespace ns3 {
 namespace bundleProtocol {
@@ -26,16 +30,34 @@ class RegistrationEndpoint
   void SetDestroyCallback (Callback<void> callback);
   void SetSendCallback (Callback<void, uint32_t> callback);
 
+  /**
+   * \brief Queues the adu for the registration.
+   *
+   * The adus queued at the same time are handed over together, in the order
+   * they were queued, from a single event.
+   */
   void ForwardUp (Ptr<Packet> adu, BundleEndpointId address);
+  /**
+   * \brief Tells the registration how many bytes it can send.
+   *
+   * Only the last value reported before the registration is notified is
+   * handed over.
+   */
   void NotifySend (uint32_t freeBytes);
  private:
-  void DoForwardUp (Ptr<Packet> adu, BundleEndpointId address);
-  void DoNotifySend (uint32_t freeBytes);
+  void DoForwardUp ();
+  void DoNotifySend ();
+
+  typedef std::deque<std::pair<Ptr<Packet>, BundleEndpointId> > PendingAdus;
 
   BundleEndpointId m_endpointId;
   Callback<void, Ptr<Packet>, BundleEndpointId>  m_rxCallback;
   Callback<void, uint32_t> m_sendCallback;
   Callback<void> m_destroyCallback;
+  PendingAdus m_pending;
+  EventId m_forwardUpEvent;
+  uint32_t m_freeBytes;
+  EventId m_notifySendEvent;
 };
 
 }} // namespace bundleProtocol, ns3
@@ -18,11 +18,14 @@ RegistrationManager::RegistrationManager ()
 
 RegistrationManager::~RegistrationManager ()
 {
-  for (EndpointsI i = m_endpoints.begin (); i != m_endpoints.end (); i++) 
+  for (EndpointIndex::iterator iter = m_endpoints.begin (); iter != m_endpoints.end (); ++iter)
     {
-      RegistrationEndpoint *endpoint = *i;
-      delete endpoint;
-      endpoint = 0;
+      for (EndpointsI i = iter->second.begin (); i != iter->second.end (); i++) 
+        {
+          RegistrationEndpoint *endpoint = *i;
+          delete endpoint;
+          endpoint = 0;
+        }
     }
   m_endpoints.clear ();
 }
@@ -30,26 +33,25 @@ RegistrationManager::~RegistrationManager ()
 bool 
 RegistrationManager::LookupLocal (BundleEndpointId eid)
 {
-  for (EndpointsI i = m_endpoints.begin (); i != m_endpoints.end (); i++) 
-    {
-      if ((*i)->GetBundleEndpointId  () == eid) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_endpoints.find (eid) != m_endpoints.end ();
 }
 
 Endpoints
 RegistrationManager::Lookup (BundleEndpointId eid)
 {
   Endpoints ret;
-  for (EndpointsI i = m_endpoints.begin (); i != m_endpoints.end (); i++) 
+  EndpointIndex::iterator iter = m_endpoints.find (eid);
+  if (iter != m_endpoints.end ())
+    {
+      ret = iter->second;
+    }
+  // The registrations to any endpoint id get every bundle
+  if (eid != BundleEndpointId ())
     {
-      if ((*i)->GetBundleEndpointId  () == eid || (*i)->GetBundleEndpointId  () == BundleEndpointId ()) 
+      iter = m_endpoints.find (BundleEndpointId ());
+      if (iter != m_endpoints.end ())
         {
-          RegistrationEndpoint* endp = *i;
-          ret.push_back(endp);
+          ret.insert (ret.end (), iter->second.begin (), iter->second.end ());
         }
     }
   return ret;
@@ -59,22 +61,47 @@ RegistrationEndpoint *
 RegistrationManager::Allocate (BundleEndpointId eid)
 {
   RegistrationEndpoint *endpoint = new RegistrationEndpoint (eid);
-  m_endpoints.push_back (endpoint);
+  m_endpoints[eid].push_back (endpoint);
   return endpoint;
 }
 
 void 
 RegistrationManager::DeAllocate (RegistrationEndpoint *endpoint)
 {
-  for (EndpointsI i = m_endpoints.begin (); i != m_endpoints.end (); i++)
+  if (endpoint == 0)
+    {
+      return;
+    }
+  EndpointIndex::iterator iter = m_endpoints.find (endpoint->GetBundleEndpointId ());
+  if (iter == m_endpoints.end ())
+    {
+      return;
+    }
+  for (EndpointsI i = iter->second.begin (); i != iter->second.end (); i++)
     {
       if (*i == endpoint)
         {
           delete endpoint;
-          m_endpoints.erase (i);
+          iter->second.erase (i);
           break;
         }
     }
+  if (iter->second.empty ())
+    {
+      m_endpoints.erase (iter);
+    }
+}
+
+void
+RegistrationManager::NotifySend (uint32_t freeBytes)
+{
+  for (EndpointIndex::iterator iter = m_endpoints.begin (); iter != m_endpoints.end (); ++iter)
+    {
+      for (EndpointsI i = iter->second.begin (); i != iter->second.end (); i++)
+        {
+          (*i)->NotifySend (freeBytes);
+        }
+    }
 }
 
 }} // namespace bundleProtocol, ns3
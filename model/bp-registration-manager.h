@@ -7,6 +7,7 @@
 #include "bp-bundle-endpoint-id.h"
 #include <stdint.h>
 #include <list>
+#include <tr1/unordered_map>
 
 using namespace std;
 
@@ -21,7 +22,10 @@ typedef list<RegistrationEndpoint *>::iterator EndpointsI;
  *
  * \brief Manages the registrations, demulitplexing bundles to the right application(s).
  *
- *
+ * The endpoints are indexed by their bundle endpoint id, so a lookup only
+ * visits the endpoints registered to the destination and the ones
+ * registered to any endpoint id. The id of an endpoint must not change
+ * while it is allocated.
  */
 class RegistrationManager
 {
@@ -34,9 +38,16 @@ public:
     
   RegistrationEndpoint *Allocate (BundleEndpointId eid);
   void DeAllocate (RegistrationEndpoint *endpoint);
+  /**
+   * \brief Tells every endpoint how many bytes the bundle buffer has free.
+   * \param freeBytes The free bytes of the buffer.
+   */
+  void NotifySend (uint32_t freeBytes);
 
 private:
-  list<RegistrationEndpoint *> m_endpoints;
+  typedef tr1::unordered_map<BundleEndpointId, Endpoints, BundleEndpointIdHash> EndpointIndex;
+
+  EndpointIndex m_endpoints;
 };
 
 }} // namespace bundleProtocol, ns3
@@ -1,5 +1,8 @@
 /* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
 
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+
 #include "bp-registration.h"
 #include "bp-registration-factory.h"
 
@@ -19,6 +22,20 @@ TypeId Registration::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::bundleProtocol::Registration")
     .SetParent<Object> ()
     .AddConstructor<Registration> ()
+    .AddAttribute ("DeliveryHighWater",
+                   "The bytes waiting to be received above which the application is told it can not send.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&Registration::m_deliveryHighWater),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DeliveryLimit",
+                   "The most bytes waiting to be received, adus beyond it are dropped and traced by DeliveryDrop. Zero, the default, means no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Registration::m_deliveryLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("DeliveryQueue", "The adus and bytes waiting to be received, whenever they change",
+                     MakeTraceSourceAccessor (&Registration::m_deliveryQueueLogger))
+    .AddTraceSource ("DeliveryDrop", "An adu was dropped since the delivery queue was full, and where it came from",
+                     MakeTraceSourceAccessor (&Registration::m_deliveryDropLogger))
     ;
   return tid;
 }
@@ -27,7 +44,12 @@ Registration::Registration ()
   : m_bpa (0),
     m_regEndpoint (),
     m_registered (false),
-    m_deliveryQueue ()
+    m_deliveryQueue (),
+    m_deliveryBytes (0),
+    m_deliveryHighWater (65536),
+    m_deliveryLimit (0),
+    m_freeBytes (0),
+    m_sendBlocked (false)
 {}
 
 Registration::~Registration ()
@@ -51,6 +73,7 @@ Registration::DoDispose ()
       *iter = 0;
     }
   m_deliveryQueue.clear ();
+  m_deliveryBytes = 0;
   m_registrationSucceeded = MakeNullCallback<void, Ptr<Registration> > ();
   m_registrationFailed = MakeNullCallback<void, Ptr<Registration> > ();
   m_sendCb = MakeNullCallback<void, Ptr<Registration>, uint32_t> ();
@@ -103,6 +126,11 @@ Registration::DoRegister ()
   m_regEndpoint->SetRxCallback (MakeCallback (&Registration::ForwardUp, this));
   m_regEndpoint->SetDestroyCallback (MakeCallback (&Registration::Destroy, this));
   m_regEndpoint->SetSendCallback (MakeCallback (&Registration::NotifySend, this));
+  // Until the buffer changes the free bytes are the ones at registration
+  if (m_bpa->GetBundleRouter () != 0)
+    {
+      m_freeBytes = m_bpa->GetBundleRouter ()->GetFreeBytes ();
+    }
   NotifyRegistrationSucceeded ();
   m_registered = true;
   return 0;
@@ -170,6 +198,8 @@ Registration::Recv (BundleEndpointId& fromAddress)
 
   Ptr<Packet> adu = m_deliveryQueue.front ();
   m_deliveryQueue.pop_front ();
+  m_deliveryBytes -= adu->GetSize ();
+  m_deliveryQueueLogger (m_deliveryQueue.size (), m_deliveryBytes);
   RegistrationAddressTag tag;
   bool found = adu->PeekPacketTag (tag);
   adu->RemovePacketTag (tag);
@@ -178,16 +208,37 @@ Registration::Recv (BundleEndpointId& fromAddress)
     {
       fromAddress = tag.GetAddress ();
     }
+
+  // The application has caught up, it may send again
+  if (m_sendBlocked && m_deliveryBytes <= m_deliveryHighWater)
+    {
+      m_sendBlocked = false;
+      NotifySend (m_freeBytes);
+    }
   return adu;
 }
 
 void
 Registration::ForwardUp (Ptr<Packet> adu, BundleEndpointId address)
 { 
+  if (m_deliveryLimit != 0 && m_deliveryBytes + adu->GetSize () > m_deliveryLimit)
+    {
+      NS_LOG_DEBUG ("Delivery queue full (" << m_deliveryBytes << " bytes), dropping adu from " << address);
+      m_deliveryDropLogger (adu, address);
+      return;
+    }
+
   RegistrationAddressTag tag;
   tag.SetAddress (address);
   adu->AddPacketTag (tag);
   m_deliveryQueue.push_back (adu);
+  m_deliveryBytes += adu->GetSize ();
+  m_deliveryQueueLogger (m_deliveryQueue.size (), m_deliveryBytes);
+  if (!m_sendBlocked && m_deliveryBytes > m_deliveryHighWater)
+    {
+      m_sendBlocked = true;
+      NotifySend (m_freeBytes);
+    }
   NotifyRecv ();
 }
 
@@ -212,9 +263,10 @@ Registration::NotifyRegistrationFailed (void)
 void
 Registration::NotifySend (uint32_t freeBytes)
 { 
+  m_freeBytes = freeBytes;
   if (!m_sendCb.IsNull ())
     {
-      m_sendCb (this, freeBytes);
+      m_sendCb (this, m_sendBlocked ? 0 : freeBytes);
     }
 }
 
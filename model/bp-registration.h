@@ -14,6 +14,7 @@
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/packet.h"
+#include "ns3/traced-callback.h"
 
 #include "bp-bundle-endpoint-id.h"
 #include "bp-registration-endpoint.h"
@@ -30,7 +31,11 @@ class BundleProtocolAgent;
  *
  * \brief Enables communications between a application and the bundle protocol.
  *
- *
+ * Delivered adus wait in a queue until the application calls Recv. While the
+ * queue holds more than DeliveryHighWater bytes the application is told that
+ * it can not send. The queue is unbounded unless DeliveryLimit is set, then
+ * adus that would take it above DeliveryLimit bytes are dropped. Set it only
+ * when the application calls Recv, or every adu past the limit is lost.
  */
 
 class Registration : public Object 
@@ -77,6 +82,14 @@ private:
   RegistrationEndpoint *m_regEndpoint;
   bool m_registered;
   std::deque<Ptr<Packet> > m_deliveryQueue;
+  uint32_t m_deliveryBytes;
+  uint32_t m_deliveryHighWater;
+  uint32_t m_deliveryLimit;
+  uint32_t m_freeBytes; // Last reported by the bundle protocol agent
+  bool m_sendBlocked;
+
+  TracedCallback<uint32_t, uint32_t> m_deliveryQueueLogger;
+  TracedCallback<Ptr<const Packet>, BundleEndpointId> m_deliveryDropLogger;
 };
 
 class RegistrationAddressTag : public Tag
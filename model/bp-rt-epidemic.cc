@@ -29,6 +29,8 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (RTEpidemic);
 
+static HelloDecoderRegistrar g_epidemicHelloDecoder (4, &DecodeHello<NeighHeader>);
+
 TypeId RTEpidemic::GetTypeId(void) {
 	static TypeId tid = TypeId ("ns3::bundleProtocol::RTEpidemic")
 		.SetParent<BundleRouter> ()
@@ -158,7 +160,7 @@ void RTEpidemic::DoBundleSent(const Address& address,
 			link->GetContact()->ResetRetransmissions();
 		}
 
-		m_forwardLog.AddEntry(bundle, link);
+		AddForwardLogEntry(bundle, link);
 
 		if (finalDelivery) {
 			BundleDelivered(bundle, true);
@@ -235,27 +237,11 @@ bool RTEpidemic::CanMakeRoomForBundle(Ptr<Bundle> bundle)
 
 bool RTEpidemic::MakeRoomForBundle(Ptr<Bundle> bundle)
 {
-	if (bundle->GetSize() < m_maxBytes) {
-		if (bundle->GetSize() < GetFreeBytes()) {
-			return true;
-		}
-
-		    //for (BundleList::reverse_iterator iter = m_bundleList.rbegin(); iter
-                               // != m_bundleList.rend();) {
-				/*Politica atual: remove o elemento mais velho da fila para colocar o que chegou*/
-                for (BundleList::iterator iter = m_bundleList.begin(); iter
-                                                != m_bundleList.end();) {
-                        Ptr<Bundle> currentBundle = *(iter++);
-
-                        DeleteBundle(currentBundle, true);
-                        if (bundle->GetSize() < GetFreeBytes()) {
-                                return true;
-                        }
-                }
+	/* A politica de descarte e escolhida pelo atributo EvictionPolicy (DropOldest por padrao) */
+	if (EvictBundlesFor(bundle)) {
+		return true;
 	}
-
 	SetBufferOverFlow("RTEpidemic.buff");
-
 	return false;
 }
 
@@ -297,7 +283,7 @@ void RTEpidemic::TryToStartSending()
 {
 	NS_LOG_DEBUG("(" << m_node->GetId () << ")" << "TrySend");
 	RemoveExpiredBundles(true);
-	m_forwardLog.RemoveExpiredEntries();
+	RemoveExpiredForwardLogEntries();
 
 	if (!IsSending() && (GetNBundles() > 0)) {
 		LinkBundle linkBundle = FindNextToSend();
@@ -310,9 +296,9 @@ void RTEpidemic::TryToStartSending()
 			SendBundle(linkBundle.GetLink(), linkBundle.GetBundle());
 			NS_LOG_DEBUG("(" << m_node->GetId () << ")" <<" Enviar" );
 			/*Inseri na lista de pacotes que trasnferiram custodia, serve para que ele nao receba novamente o mesmo pacote*/
-			//InsertCustodyHistorical(linkBundle.GetBundle()->GetBundleId());
+			//InsertCustodyHistorical(linkBundle.GetBundle());
 			/*Inseri na lista de pacotes que trasnferiram custodia, mas ainda não esperaram resposta*/
-			//InsertCustodyHistoricalPending(linkBundle.GetBundle()->GetBundleId());
+			//InsertCustodyHistoricalPending(linkBundle.GetBundle());
 			//Simulator::Schedule (Seconds(5.0), &RTEpidemic::EraseCustodyHistoricalPending,this,linkBundle.GetBundle()->GetBundleId());
 		} else {
 			Simulator::Schedule (Seconds(1.0), &RTEpidemic::TryToStartSending, this);
@@ -325,10 +311,9 @@ LinkBundle RTEpidemic::FindNextToSend()
 	NS_LOG_DEBUG("RTEpidemic::FindNextToSend");
 	NS_LOG_DEBUG("(" << m_node->GetId() << ") - m_linkManager->GetConnectedLinks().size()= " << m_linkManager->GetConnectedLinks().size() << " GetNBundles() = " << GetNBundles() );
 	if ((m_linkManager->GetConnectedLinks().size() > 0) && (GetNBundles() > 0)) {
-		LinkBundleList linkBundleList = GetAllDeliverableBundles();
-		if (!linkBundleList.empty()) {
-			return linkBundleList.front();
-		}
+		FirstLinkBundle first;
+		VisitDeliverableBundles(first);
+		return first.GetLinkBundle();
 	}
 	return LinkBundle(0, 0);
 }
@@ -338,53 +323,38 @@ LinkBundle RTEpidemic::GetNextRouterSpecific()
 	return LinkBundle(0, 0);
 }
 
-LinkBundleList RTEpidemic::GetAllDeliverableBundles()
+bool RTEpidemic::VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor)
 {
-	Links links = m_linkManager->GetConnectedLinks();
-	LinkBundleList result;
-	for (Links::iterator iter = links.begin(); iter != links.end(); ++iter) {
-		Ptr<Link> link = *iter;
-		LinkBundleList linkBundleList = GetAllBundlesForLink(link);
-		result.insert(result.end(), linkBundleList.begin(),
-				linkBundleList.end());
+	if (link->GetState() != LINK_CONNECTED) {
+		return true;
 	}
-	return result;
-}
-
-LinkBundleList RTEpidemic::GetAllBundlesForLink(Ptr<Link> link)
-{
-	LinkBundleList linkBundleList;
-	LinkBundleList direct;
-	if (link->GetState() == LINK_CONNECTED) {
-		if (link->GetState() == LINK_CONNECTED) {
-			for (BundleList::iterator iter = m_bundleList.begin(); iter
-					!= m_bundleList.end(); ++iter) {
-				Ptr<Bundle> bundle = *iter;
-				/*
-				if (bundle->HasRetentionConstraint(RC_FORWARDING_PENDING)
-						&& !bundle->HaveBeenReceivedFrom(link)
-						&& (link->GetRemoteEndpointId()
-								== bundle->GetDestinationEndpoint())
-						&& !m_forwardLog.HasEntry(bundle, link)) {
-					linkBundleList.push_back(LinkBundle(link, *iter));
-				}
-				*/
-
-				if(!bundle->HaveBeenReceivedFrom(link->GetRemoteEndpointId().GetId()) && link->GetRemoteEndpointId()
-						== bundle->GetDestinationEndpoint()){
-						direct.push_back(LinkBundle(link,*iter));
-						return direct;
-				}
-				/* agora não tem mais restrição de EID - virou epidêmico */
-				else if (!bundle->HaveBeenReceivedFrom(link->GetRemoteEndpointId().GetId())
-						&& !m_forwardLog.HasEntry(bundle, link)) {
-					linkBundleList.push_back(LinkBundle(link, *iter));
-				}
-
+	BundleEndpointId remote = link->GetRemoteEndpointId();
+	/* A bundle for the peer itself is the only candidate on the link */
+	for (BundleList::iterator iter = m_bundleList.begin(); iter
+			!= m_bundleList.end(); ++iter) {
+		Ptr<Bundle> bundle = *iter;
+		if (!bundle->HaveBeenReceivedFrom(remote.GetId())
+				&& remote == bundle->GetDestinationEndpoint()
+				&& FitsContactWindow(link, bundle)) {
+			return visitor.Visit(link, bundle);
+		}
+	}
+	for (BundleList::iterator iter = m_bundleList.begin(); iter
+			!= m_bundleList.end(); ++iter) {
+		Ptr<Bundle> bundle = *iter;
+		bool direct = !bundle->HaveBeenReceivedFrom(remote.GetId())
+				&& remote == bundle->GetDestinationEndpoint();
+		/* agora não tem mais restrição de EID - virou epidêmico */
+		if (!direct
+				&& !bundle->HaveBeenReceivedFrom(remote.GetId())
+				&& !m_forwardLog.HasEntry(bundle, link)
+				&& FitsContactWindow(link, bundle)) {
+			if (!visitor.Visit(link, bundle)) {
+				return false;
 			}
 		}
 	}
-	return linkBundleList;
+	return true;
 }
 
 uint8_t RTEpidemic::DoCalculateReplicationFactor(
@@ -449,7 +419,7 @@ void RTEpidemic::DoBundleDelivered(Ptr<Bundle> bundle, bool fromAck) {
 		Ptr<Bundle> bundle = *iter;
 		if (m_kdm.Has(bundle)) {
 			bl.push_back(bundle);
-			m_forwardLog.RemoveEntriesFor(bundle->GetBundleId());
+			RemoveForwardLogEntries(bundle->GetBundleId());
 		}
 	}
 
@@ -478,11 +448,16 @@ void RTEpidemic::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid)
 {
 	NeighHeader header;
 	header.SetBundleEndpointId(m_eid);
+	if (m_contactWindowAware) {
+		Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
+		header.SetMobility(mm->GetPosition(), mm->GetVelocity());
+	}
         
         if(Simulator::Now ().GetSeconds () > curTime - 10)
 	{
 		m_nda->Stop();
 		while(!m_bundleList.empty()){m_bundleList.pop_front();}
+		m_evictionIndex.Clear();
 	}
         else
         {
@@ -498,22 +473,12 @@ void RTEpidemic::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid)
 	        socket->Send(hello);
         }
 }
-void RTEpidemic::DoHandleHello(Ptr<Socket> socket)
+void RTEpidemic::DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress)
 {
 	Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
 	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - " << mm->GetPosition ());
 
-	Ptr<Packet> receivedHello;
-	Address fromAddress;
-	receivedHello = socket->RecvFrom(fromAddress);
-
-	NeighHeader header;
-	receivedHello->PeekHeader(header);
-
-	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << header.GetBundleEndpointId());
-
-	Simulator::ScheduleNow(&NeighbourhoodDetectionAgent::NotifyDiscoveredLink,
-			m_nda, receivedHello, fromAddress);
+	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << hello->GetBundleEndpointId());
 }
 /*sergioviera*/
 
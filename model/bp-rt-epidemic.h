@@ -86,8 +86,7 @@ private:
 
 
 
-	LinkBundleList GetAllDeliverableBundles();
-	LinkBundleList GetAllBundlesForLink(Ptr<Link> link);
+	bool VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor);
 	LinkBundle GetNextRouterSpecific();
 
 	// Orwar specific
@@ -96,7 +95,7 @@ private:
 
 	/* sergiosvieira */
 	void DoSendHello(Ptr<Socket> socket, BundleEndpointId eid);
-	void DoHandleHello(Ptr<Socket> socket);
+	void DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress);
 	/* sergiosvieira */
 
 	void PauseLink(Ptr<Link> link);
@@ -15,7 +15,10 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (ProphetHelloHeader);
 
-ProphetHelloHeader::ProphetHelloHeader() {
+/* O bit mais alto do tamanho do eid indica se a posição e a velocidade foram enviadas */
+#define PROPHET_HELLO_MOBILITY_FLAG 0x80000000
+
+ProphetHelloHeader::ProphetHelloHeader() : m_hasMobility(false) {
 
 }
 
@@ -36,7 +39,7 @@ int ProphetHelloHeader::GetSize() {
 	return m_plist.size();
 }
 
-ProbabilitiesList ProphetHelloHeader::GetNeighList() {
+const ProbabilitiesList& ProphetHelloHeader::GetNeighList() const {
 	return m_plist;
 }
 
@@ -69,7 +72,7 @@ uint32_t
 ProphetHelloHeader::GetSerializedSize (void) const
 {
 	uint32_t eid_size = m_eid.GetSerializedSize();
-	return eid_size + 4 + sizeof(uint32_t) + (m_plist.size() * (eid_size + 4 + sizeof(double)));
+	return eid_size + 4 + sizeof(uint32_t) + (m_plist.size() * (eid_size + 4 + sizeof(double))) + (m_hasMobility ? 32 : 0);
 }
 
 
@@ -78,7 +81,7 @@ void ProphetHelloHeader::Serialize(Buffer::Iterator start) const {
 	/* enviando EID, isso é obrigatório pq tá amarrado ao LinkManager */
 	int length = m_eid.GetSerializedSize();
 	Buffer::Iterator i = start;
-	i.WriteU32(length);
+	i.WriteU32(m_hasMobility ? (length | PROPHET_HELLO_MOBILITY_FLAG) : length);
 	uint8_t buf[length];
 	m_eid.Serialize(buf);
 	i.Write(buf, length);
@@ -109,11 +112,20 @@ void ProphetHelloHeader::Serialize(Buffer::Iterator start) const {
 		i.WriteU64(pack754_64(p)); // probabilidade de entrega para esse vizinho
 	}
 
+	if (m_hasMobility) {
+		i.WriteU64(pack754_64(m_position.x));
+		i.WriteU64(pack754_64(m_position.y));
+		i.WriteU64(pack754_64(m_velocity.x));
+		i.WriteU64(pack754_64(m_velocity.y));
+	}
+
 }
 
 uint32_t ProphetHelloHeader::Deserialize(Buffer::Iterator start) {
 	Buffer::Iterator i = start;
 	uint32_t length = i.ReadU32();
+	m_hasMobility = (length & PROPHET_HELLO_MOBILITY_FLAG) != 0;
+	length &= ~PROPHET_HELLO_MOBILITY_FLAG;
 	uint8_t buf[length];
 	i.Read(buf, length);
 	m_eid = BundleEndpointId::Deserialize(buf);
@@ -133,6 +145,13 @@ uint32_t ProphetHelloHeader::Deserialize(Buffer::Iterator start) {
 		m_plist[eid_] = p_;
 	}
 
+	if (m_hasMobility) {
+		m_position.x = unpack754_64(i.ReadU64());
+		m_position.y = unpack754_64(i.ReadU64());
+		m_velocity.x = unpack754_64(i.ReadU64());
+		m_velocity.y = unpack754_64(i.ReadU64());
+	}
+
 	return GetSerializedSize();
 }
 
@@ -148,6 +167,24 @@ ProphetHelloHeader::GetBundleEndpointId () const
   return m_eid;
 }
 
+void ProphetHelloHeader::SetMobility(const Vector &position, const Vector &velocity) {
+	m_hasMobility = true;
+	m_position = position;
+	m_velocity = velocity;
+}
+
+bool ProphetHelloHeader::HasMobility() const {
+	return m_hasMobility;
+}
+
+Vector ProphetHelloHeader::GetPosition() const {
+	return m_position;
+}
+
+Vector ProphetHelloHeader::GetVelocity() const {
+	return m_velocity;
+}
+
 
 }
 }
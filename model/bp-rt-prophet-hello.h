@@ -18,6 +18,7 @@
 #include "ns3/mac48-address.h"
 #include "ns3/callback.h"
 #include "ns3/traced-callback.h"
+#include "ns3/vector.h"
 
 #include "bp-bundle-endpoint-id.h"
 #include "bp-link-manager.h"
@@ -40,7 +41,7 @@ public:
 	void addProbability(const BundleEndpointId &dst_eid, const double &probability);
 	double GetProbability(const BundleEndpointId &dst_eid);
 	int GetSize();
-	ProbabilitiesList GetNeighList();
+	const ProbabilitiesList& GetNeighList() const;
 	/* fim */
 
 	static TypeId GetTypeId(void);
@@ -53,8 +54,17 @@ public:
 	void SetBundleEndpointId(BundleEndpointId eid);
 	BundleEndpointId GetBundleEndpointId() const;
 
+	/* Opcional, enviado apenas quando o roteador estima a janela de contato */
+	void SetMobility(const Vector &position, const Vector &velocity);
+	bool HasMobility() const;
+	Vector GetPosition() const;
+	Vector GetVelocity() const;
+
 protected:
 	BundleEndpointId m_eid;
+	bool m_hasMobility;
+	Vector m_position;
+	Vector m_velocity;
 	ProbabilitiesList m_plist; // Usado para enviar a lista de probabilidades dos nós vizinhos
 };
 
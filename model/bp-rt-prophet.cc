@@ -34,6 +34,9 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (RTProphet);
 
+/* Defino que o identificador de ProphetHelloHeader vale 1 */
+static HelloDecoderRegistrar g_prophetHelloDecoder (1, &DecodeHello<ProphetHelloHeader>);
+
 TypeId RTProphet::GetTypeId(void) {
 	static TypeId tid = TypeId ("ns3::bundleProtocol::RTProphet")
 		.SetParent<BundleRouter> ()
@@ -192,7 +195,7 @@ void RTProphet::DoBundleSent(const Address& address,
 			link->GetContact()->ResetRetransmissions();
 		}
 
-		m_forwardLog.AddEntry(bundle, link);
+		AddForwardLogEntry(bundle, link);
 
 		if (finalDelivery) {
 			BundleDelivered(bundle, true);
@@ -271,23 +274,9 @@ bool RTProphet::CanMakeRoomForBundle(Ptr<Bundle> bundle)
 
 bool RTProphet::MakeRoomForBundle(Ptr<Bundle> bundle)
 {
-	if (bundle->GetSize() < m_maxBytes) {
-		if (bundle->GetSize() < GetFreeBytes()) {
-			return true;
-		}
-
-		    //for (BundleList::reverse_iterator iter = m_bundleList.rbegin(); iter
-                               // != m_bundleList.rend();) {
-				/*Politica atual: remove o elemento mais velho da fila para colocar o que chegou*/
-                for (BundleList::iterator iter = m_bundleList.begin(); iter
-                                                != m_bundleList.end();) {
-                        Ptr<Bundle> currentBundle = *(iter++);
-
-                        DeleteBundle(currentBundle, true);
-                        if (bundle->GetSize() < GetFreeBytes()) {
-                                return true;
-                        }
-                }
+	/* A politica de descarte e escolhida pelo atributo EvictionPolicy (DropOldest por padrao) */
+	if (EvictBundlesFor(bundle)) {
+		return true;
 	}
 	SetBufferOverFlow("RTProphet.buff");
 	return false;
@@ -330,7 +319,7 @@ void RTProphet::TryToStartSending()
 {
 	NS_LOG_DEBUG("(" << m_node->GetId () << ")");
 	RemoveExpiredBundles(true);
-	m_forwardLog.RemoveExpiredEntries();
+	RemoveExpiredForwardLogEntries();
 
 	if (!IsSending() && (GetNBundles() > 0)) {
 		LinkBundle linkBundle = FindNextToSend();
@@ -345,9 +334,9 @@ void RTProphet::TryToStartSending()
 			SendBundle(linkBundle.GetLink(), linkBundle.GetBundle());
 
 			/*Inseri na lista de pacotes que trasnferiram custodia, serve para que ele nao receba novamente o mesmo pacote*/
-			InsertCustodyHistorical(linkBundle.GetBundle()->GetBundleId());
+			InsertCustodyHistorical(linkBundle.GetBundle());
 			/*Inseri na lista de pacotes que trasnferiram custodia, mas ainda não esperaram resposta*/
-			InsertCustodyHistoricalPending(linkBundle.GetBundle()->GetBundleId());
+			InsertCustodyHistoricalPending(linkBundle.GetBundle());
 			Simulator::Schedule (Seconds(5.0), &RTProphet::EraseCustodyHistoricalPending,this,linkBundle.GetBundle()->GetBundleId());
 		} else {
 			Simulator::Schedule (Seconds(1.0), &RTProphet::TryToStartSending, this);
@@ -355,56 +344,59 @@ void RTProphet::TryToStartSending()
 	}
 }
 
-LinkBundle RTProphet::GetBestLink(LinkBundleList lbl) {
+RTProphet::BestLink::BestLink(RTProphet* router) :
+	m_router(router), m_bundle(0), m_lastLink(0), m_direct(), m_max(0), m_maxEid() {
+}
 
-	//PrintTable();
-	LinkBundle lb = lbl.front();
-	Ptr<Link> link = lb.GetLink();
+bool RTProphet::BestLink::Visit(Ptr<Link> link, Ptr<Bundle> bundle) {
+	if (m_bundle == 0) {
+		m_bundle = bundle;
+	}
+	/* The candidates come link by link, each link only needs to be looked at once */
+	if (link == m_lastLink) {
+		return true;
+	}
+	m_lastLink = link;
 
 	BundleEndpointId remote = link->GetRemoteEndpointId();
-
-	NS_LOG_DEBUG("\t Link Source = " << m_eid << " Destination = " <<  remote );
-
-	if (lb.GetBundle()->GetDestinationEndpoint() == remote) {
-		NS_LOG_DEBUG("\t Direct Link");
-		return LinkBundle(link, lb.GetBundle());
+	if (m_bundle->GetDestinationEndpoint() == remote) {
+		m_direct = LinkBundle(link, m_bundle);
+		return false;
 	}
 
-	double max = 0;//m_prob_table[remote].probability;
-	BundleEndpointId max_eid = m_node->GetId();//remote;
-
-	for (LinkBundleList::iterator it = lbl.begin(); it != lbl.end(); ++it) {
-
-		if (lb.GetBundle()->GetDestinationEndpoint() == (*it).GetLink()->GetRemoteEndpointId()) {
-			NS_LOG_DEBUG("\t Direct Link 2");
-			return LinkBundle((*it).GetLink(), lb.GetBundle());
+	/*Lista de Probabilidades do nó remoto*/
+	ProbabilitiesList& prob = m_router->m_prob_table[remote].prob;
+	ProbabilitiesList::iterator itPb = prob.find(m_bundle->GetDestinationEndpoint());
+	if (itPb != prob.end()) {
+		double p = (*itPb).second;
+		NS_LOG_DEBUG("Remote Probability: " <<"(" << remote <<") "<<p);
+		if (p > m_max) {
+			m_max = p;
+			m_maxEid = remote;
 		}
+	}
+	return true;
+}
 
-		//prop_table[(*it).GetLink()->GetRemoteEndpointId()].prob; /*Lista de Probabilidades do nó remoto*/
-
-		ProbabilitiesList::iterator itPb = m_prob_table[(*it).GetLink()->GetRemoteEndpointId()].prob.find(lb.GetBundle()->GetDestinationEndpoint());
-
-		if(itPb != m_prob_table[(*it).GetLink()->GetRemoteEndpointId()].prob.end())
-		{
+LinkBundle RTProphet::GetBestLink(const BestLink& best) {
 
+	//PrintTable();
+	NS_LOG_DEBUG("\t Link Source = " << m_eid << " Bundle Destination = " << best.m_bundle->GetDestinationEndpoint());
 
-			double p = (*itPb).second;//m_prob_table[(*it).GetLink()->GetRemoteEndpointId()].probability;
-			NS_LOG_DEBUG("Remote Probability: " <<"(" <<(*it).GetLink()->GetRemoteEndpointId() <<") "<<p);
-			if (p > max) {
-				max = p;
-				max_eid = (*it).GetLink()->GetRemoteEndpointId();
-			}
-		}
+	if (!best.m_direct.IsNull()) {
+		NS_LOG_DEBUG("\t Direct Link");
+		return best.m_direct;
 	}
+
 	NS_LOG_DEBUG("\t Indirect Link");
-	if(max == 0){
+	if(best.m_max == 0){
 
 		NS_LOG_DEBUG("\t No Send");
 		return LinkBundle(0,0);
 	}
 	//PrintTable();
-	NS_LOG_DEBUG("("<<m_node->GetId() <<") \t Try Send to (" <<max_eid <<")");
-	return LinkBundle(m_linkManager->FindLink(max_eid), lb.GetBundle());
+	NS_LOG_DEBUG("("<<m_node->GetId() <<") \t Try Send to (" <<best.m_maxEid <<")");
+	return LinkBundle(m_linkManager->FindLink(best.m_maxEid), best.m_bundle);
 }
 
 LinkBundle RTProphet::FindNextToSend()
@@ -412,13 +404,12 @@ LinkBundle RTProphet::FindNextToSend()
 	//NS_LOG_DEBUG("RTProphet::FindNextToSend");
 	NS_LOG_DEBUG("(" << m_node->GetId() << ") - m_linkManager->GetConnectedLinks().size()= " << m_linkManager->GetConnectedLinks().size() << " GetNBundles() = " << GetNBundles() );
 	if ((m_linkManager->GetConnectedLinks().size() > 0) && (GetNBundles() > 0)) {
-		LinkBundleList linkBundleList = GetAllDeliverableBundles();
-		if (!linkBundleList.empty()) {
+		BestLink best(this);
+		VisitDeliverableBundles(best);
+		if (best.m_bundle != 0) {
 			NS_LOG_DEBUG("\t Not Empty!!");
 
-			return GetBestLink(linkBundleList);
-
-			//return linkBundleList.front();
+			return GetBestLink(best);
 		} else {
 			NS_LOG_DEBUG("\t Empty!!");
 		}
@@ -431,61 +422,48 @@ LinkBundle RTProphet::GetNextRouterSpecific()
 	return LinkBundle(0, 0);
 }
 
-LinkBundleList RTProphet::GetAllDeliverableBundles()
+bool RTProphet::VisitDeliverableBundles(LinkBundleVisitor& visitor)
 {
-	Links links = m_linkManager->GetConnectedLinks();
-	LinkBundleList result;
-	for (Links::iterator iter = links.begin(); iter != links.end(); ++iter) {
-		Ptr<Link> link = *iter;
-		/* sergiosvieira */
-		//LinkBundleList linkBundleList = GetAllBundlesForLink(link);
-		LinkBundleList linkBundleList = GetAllBundlesToAllLinks();
-		/* sergiosvieira */
-		result.insert(result.end(), linkBundleList.begin(),
-				linkBundleList.end());
-	}
-	return result;
-}
-
-LinkBundleList RTProphet::GetAllBundlesForLink(Ptr<Link> link)
-{
-	LinkBundleList linkBundleList;
-		LinkBundleList direct;
-		if (link->GetState() == LINK_CONNECTED) {
-			if (link->GetState() == LINK_CONNECTED) {
-				for (BundleList::iterator iter = m_bundleList.begin(); iter
-						!= m_bundleList.end(); ++iter) {
-					Ptr<Bundle> bundle = *iter;
-					/*
-					if (bundle->HasRetentionConstraint(AddRetentionConstraint(RC_CUSTODY_ACCEPTED))
-							&& !bundle->HaveBeenReceivedFrom(link)
-							&& (link->GetRemoteEndpointId()
-									== bundle->GetDestinationEndpoint())
-							&& !m_forwardLog.HasEntry(bundle, link)) {
-						linkBundleList.push_back(LinkBundle(link, *iter));
-					}
-					*/
-					 if(!bundle->HaveBeenReceivedFrom(link->GetRemoteEndpointId().GetId()) && link->GetRemoteEndpointId() == bundle->GetDestinationEndpoint()){
-						direct.push_back(LinkBundle(link,*iter));
-						return direct;
-					}
-					/* agora não tem mais restrição de EID - virou epidêmico */
-					if (!bundle->HaveBeenReceivedFrom(link)
-							&& !m_forwardLog.HasEntry(bundle, link)
-							&& !isBundleCustodyPending(bundle->GetBundleId())) {
-						linkBundleList.push_back(LinkBundle(link, *iter));
-					}
+	/* sergiosvieira */
+	/* Every bundle to every link, not only the bundles for each link */
+	return VisitBundlesToAllLinks(visitor);
+}
 
-				}
+bool RTProphet::VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor)
+{
+	if (link->GetState() != LINK_CONNECTED) {
+		return true;
+	}
+	BundleEndpointId remote = link->GetRemoteEndpointId();
+	/* A bundle for the peer itself is the only candidate on the link */
+	for (BundleList::iterator iter = m_bundleList.begin(); iter
+			!= m_bundleList.end(); ++iter) {
+		Ptr<Bundle> bundle = *iter;
+		if (!bundle->HaveBeenReceivedFrom(remote.GetId())
+				&& remote == bundle->GetDestinationEndpoint()
+				&& FitsContactWindow(link, bundle)) {
+			return visitor.Visit(link, bundle);
+		}
+	}
+	/* agora não tem mais restrição de EID - virou epidêmico */
+	for (BundleList::iterator iter = m_bundleList.begin(); iter
+			!= m_bundleList.end(); ++iter) {
+		Ptr<Bundle> bundle = *iter;
+		if (!bundle->HaveBeenReceivedFrom(link)
+				&& !m_forwardLog.HasEntry(bundle, link)
+				&& !isBundleCustodyPending(bundle->GetBundleId())
+				&& FitsContactWindow(link, bundle)) {
+			if (!visitor.Visit(link, bundle)) {
+				return false;
 			}
 		}
-		return linkBundleList;
+	}
+	return true;
 }
 
-LinkBundleList RTProphet::GetAllBundlesToAllLinks() {
+bool RTProphet::VisitBundlesToAllLinks(LinkBundleVisitor& visitor) {
 	Links links = m_linkManager->GetConnectedLinks();
 
-	LinkBundleList linkBundleList;
 	for (Links::iterator iter = links.begin(); iter != links.end(); ++iter) {
 		Ptr<Link> link = *iter;
 		for (BundleList::iterator it = m_bundleList.begin(); it
@@ -493,12 +471,15 @@ LinkBundleList RTProphet::GetAllBundlesToAllLinks() {
 			Ptr<Bundle> bundle = *it;
 			if (bundle->HasRetentionConstraint(RC_FORWARDING_PENDING)
 					&& !bundle->HaveBeenReceivedFrom(link)
-					&& !m_forwardLog.HasEntry(bundle, link)) {
-				linkBundleList.push_back(LinkBundle(link, bundle));
+					&& !m_forwardLog.HasEntry(bundle, link)
+					&& FitsContactWindow(link, bundle)) {
+				if (!visitor.Visit(link, bundle)) {
+					return false;
+				}
 			}
 		}
 	}
-	return linkBundleList;
+	return true;
 }
 
 
@@ -564,7 +545,7 @@ void RTProphet::DoBundleDelivered(Ptr<Bundle> bundle, bool fromAck) {
 		Ptr<Bundle> bundle = *iter;
 		if (m_kdm.Has(bundle)) {
 			bl.push_back(bundle);
-			m_forwardLog.RemoveEntriesFor(bundle->GetBundleId());
+			RemoveForwardLogEntries(bundle->GetBundleId());
 		}
 	}
 
@@ -597,11 +578,16 @@ void RTProphet::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid) {
 	{
 		m_nda->Stop();
 		while(!m_bundleList.empty()){m_bundleList.pop_front();}
+		m_evictionIndex.Clear();
 	}
         else
         {
 	        ProphetHelloHeader header;
 	        header.SetBundleEndpointId(eid);
+	        if (m_contactWindowAware) {
+	        	Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
+	        	header.SetMobility(mm->GetPosition(), mm->GetVelocity());
+	        }
 
 	        NS_LOG_DEBUG("(" << m_node->GetId() <<")" << " eid: " <<eid);
 
@@ -628,21 +614,13 @@ void RTProphet::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid) {
 	//m_sendLogger(hello);
 }
 
-void RTProphet::DoHandleHello(Ptr<Socket> socket) {
+void RTProphet::DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress) {
 	Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
 
-
-
-	Ptr<Packet> receivedHello;
-	Address fromAddress;
-
-	receivedHello = socket->RecvFrom(fromAddress);
-
-	/* Toda vez que criar um novo Header deve-se escolher um valor para ele, e isto deve ser colocado dentro
-	 * LinkManager::DiscoveredLink
+	/* Toda vez que criar um novo Header deve-se escolher um valor para ele, e registrar
+	 * um HelloDecoderRegistrar com este valor
 	 */
-	ProphetHelloHeader header;
-	receivedHello->PeekHeader(header);
+	const ProphetHelloHeader& header = DynamicCast<TypedHello<ProphetHelloHeader> > (hello)->GetHeader();
 
 	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - " << mm->GetPosition () << " From " << header.GetBundleEndpointId());
 
@@ -650,8 +628,6 @@ void RTProphet::DoHandleHello(Ptr<Socket> socket) {
 	updateDeliveryPredFor(header.GetBundleEndpointId());
 	updateTransitivePreds(header.GetBundleEndpointId(), header.GetNeighList());
 	PrintTable();
-
-	Simulator::ScheduleNow(&NeighbourhoodDetectionAgent::NotifyDiscoveredLink, m_nda, receivedHello, fromAddress);
 }
 
 void RTProphet::updateDeliveryPredFor(BundleEndpointId host) {
@@ -676,7 +652,7 @@ void RTProphet::updateDeliveryPredFor(BundleEndpointId host) {
 }
 
 void RTProphet::updateTransitivePreds(BundleEndpointId host,
-		ProbabilitiesList list) {
+		const ProbabilitiesList& list) {
 	ProbTable::iterator tmp;
 	double pForHost;
 
@@ -688,7 +664,7 @@ void RTProphet::updateTransitivePreds(BundleEndpointId host,
 		pForHost = 0.0;
 	}
 
-	for (ProbabilitiesList::iterator m = list.begin(); m != list.end(); ++m) {
+	for (ProbabilitiesList::const_iterator m = list.begin(); m != list.end(); ++m) {
 
 		if ((*m).first == m_eid) {
 			continue;
@@ -64,9 +64,10 @@ private:
 	Transitive getNeigh(BundleEndpointId eid);
 	void ProbabilityExpirationTimer(Ptr<Link> link);
 	void updateDeliveryPredFor(BundleEndpointId host);
-	void updateTransitivePreds(BundleEndpointId host, ProbabilitiesList list);
+	void updateTransitivePreds(BundleEndpointId host, const ProbabilitiesList& list);
 	void ProbabilityReduce();
-	LinkBundle GetBestLink(LinkBundleList lbl);
+	class BestLink;
+	LinkBundle GetBestLink(const BestLink& best);
 	bool DoAcceptCustody(Ptr<Bundle> bundle,
 				CustodySignalReason& reason);
 	/* sergiosvieira */
@@ -108,12 +109,12 @@ private:
 
 	/* sergiosvieira */
 	void DoSendHello(Ptr<Socket> socket, BundleEndpointId eid);
-	void DoHandleHello(Ptr<Socket> socket);
+	void DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress);
 	/* sergiosvieira */
 
-	LinkBundleList GetAllDeliverableBundles();
-	LinkBundleList GetAllBundlesForLink(Ptr<Link> link);
-	LinkBundleList GetAllBundlesToAllLinks();
+	bool VisitDeliverableBundles(LinkBundleVisitor& visitor);
+	bool VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor);
+	bool VisitBundlesToAllLinks(LinkBundleVisitor& visitor);
 	LinkBundle GetNextRouterSpecific();
 
 	// Orwar specific
@@ -171,6 +172,24 @@ private:
 		}
 	};
 
+	/*
+	 * Only the bundle of the first candidate is sent, the links of the other
+	 * candidates are the neighbours it can go to: the destination itself or
+	 * else the one most likely to deliver it.
+	 */
+	class BestLink: public LinkBundleVisitor {
+	public:
+		BestLink(RTProphet* router);
+		bool Visit(Ptr<Link> link, Ptr<Bundle> bundle);
+
+		RTProphet* m_router;
+		Ptr<Bundle> m_bundle;
+		Ptr<Link> m_lastLink;
+		LinkBundle m_direct;
+		double m_max;
+		BundleEndpointId m_maxEid;
+	};
+
 	struct EqualEids: public std::unary_function<Ptr<Bundle> , bool> {
 		BundleEndpointId m_eid;
 
@@ -33,6 +33,8 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (RTSprayAndWait);
 
+static HelloDecoderRegistrar g_sprayAndWaitHelloDecoder (5, &DecodeHello<NeighHeader>);
+
 TypeId RTSprayAndWait::GetTypeId(void) {
 	static TypeId tid = TypeId ("ns3::bundleProtocol::RTSprayAndWait")
 		.SetParent<BundleRouter> ()
@@ -165,7 +167,7 @@ void RTSprayAndWait::DoBundleSent(const Address& address,
 			link->GetContact()->ResetRetransmissions();
 		}
 
-		m_forwardLog.AddEntry(bundle, link);
+		AddForwardLogEntry(bundle, link);
 
 		if (finalDelivery) {
 			BundleDelivered(bundle, true);
@@ -241,26 +243,11 @@ bool RTSprayAndWait::CanMakeRoomForBundle(Ptr<Bundle> bundle)
 
 bool RTSprayAndWait::MakeRoomForBundle(Ptr<Bundle> bundle)
 {
-	if (bundle->GetSize() < m_maxBytes) {
-		if (bundle->GetSize() < GetFreeBytes()) {
-			return true;
-		}
-
-	    //for (BundleList::reverse_iterator iter = m_bundleList.rbegin(); iter
-                               // != m_bundleList.rend();) {
-				/*Politica atual: remove o elemento mais velho da fila para colocar o que chegou*/
-                for (BundleList::iterator iter = m_bundleList.begin(); iter
-                                                != m_bundleList.end();) {
-                        Ptr<Bundle> currentBundle = *(iter++);
-
-                        DeleteBundle(currentBundle, true);
-                        if (bundle->GetSize() < GetFreeBytes()) {
-                                return true;
-                        }
-                }
+	/* A politica de descarte e escolhida pelo atributo EvictionPolicy (DropOldest por padrao) */
+	if (EvictBundlesFor(bundle)) {
+		return true;
 	}
 	SetBufferOverFlow("RTSprayAndWait.buff");
-
 	return false;
 }
 
@@ -309,7 +296,7 @@ void RTSprayAndWait::TryToStartSending()
 {
 	NS_LOG_DEBUG("(" << m_node->GetId () << ")");
 	RemoveExpiredBundles(true);
-	m_forwardLog.RemoveExpiredEntries();
+	RemoveExpiredForwardLogEntries();
 
 	if (!IsSending() && (GetNBundles() > 0)) {
 		LinkBundle linkBundle = FindNextToSend();
@@ -337,10 +324,9 @@ LinkBundle RTSprayAndWait::FindNextToSend()
 	NS_LOG_DEBUG("RTSprayAndWait::FindNextToSend");
 	NS_LOG_DEBUG("(" << m_node->GetId() << ") - m_linkManager->GetConnectedLinks().size()= " << m_linkManager->GetConnectedLinks().size() << " GetNBundles() = " << GetNBundles() );
 	if ((m_linkManager->GetConnectedLinks().size() > 0) && (GetNBundles() > 0)) {
-		LinkBundleList linkBundleList = GetAllDeliverableBundles();
-		if (!linkBundleList.empty()) {
-			return linkBundleList.front();
-		}
+		FirstLinkBundle first;
+		VisitDeliverableBundles(first);
+		return first.GetLinkBundle();
 	}
 	return LinkBundle(0, 0);
 }
@@ -350,50 +336,39 @@ LinkBundle RTSprayAndWait::GetNextRouterSpecific()
 	return LinkBundle(0, 0);
 }
 
-LinkBundleList RTSprayAndWait::GetAllDeliverableBundles()
+bool RTSprayAndWait::VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor)
 {
-	Links links = m_linkManager->GetConnectedLinks();
-	LinkBundleList result;
-	for (Links::iterator iter = links.begin(); iter != links.end(); ++iter) {
-		Ptr<Link> link = *iter;
-		LinkBundleList linkBundleList = GetAllBundlesForLink(link);
-		result.insert(result.end(), linkBundleList.begin(),
-				linkBundleList.end());
+	if (link->GetState() != LINK_CONNECTED) {
+		return true;
 	}
-	return result;
-}
-
-LinkBundleList RTSprayAndWait::GetAllBundlesForLink(Ptr<Link> link)
-{
-	LinkBundleList linkBundleList;
-	LinkBundleList direct;
-	if (link->GetState() == LINK_CONNECTED) {
-		if (link->GetState() == LINK_CONNECTED) {
-			for (BundleList::iterator iter = m_bundleList.begin(); iter
-					!= m_bundleList.end(); ++iter) {
-				Ptr<Bundle> bundle = *iter;
-				/*
-				if (bundle->HasRetentionConstraint(RC_FORWARDING_PENDING)
-						&& !bundle->HaveBeenReceivedFrom(link)
-						&& (link->GetRemoteEndpointId()
-								== bundle->GetDestinationEndpoint())
-						&& !m_forwardLog.HasEntry(bundle, link)) {
-					linkBundleList.push_back(LinkBundle(link, *iter));
-				}
-				*/
-				if(!bundle->HaveBeenReceivedFrom(link->GetRemoteEndpointId().GetId()) && link->GetRemoteEndpointId() == bundle->GetDestinationEndpoint()){
-					direct.push_back(LinkBundle(link,*iter));
-					return direct;
-				}
-				else if (!HasBundleRe(link->GetRemoteEndpointId().GetId(),bundle->GetGlobalId()) && !m_forwardLog.HasEntry(bundle, link) && (bundle->GetReplicationFactor() > 1))
-				{
-					linkBundleList.push_back(LinkBundle(link,*iter));
-				}
-
+	BundleEndpointId remote = link->GetRemoteEndpointId();
+	/* A bundle for the peer itself is the only candidate on the link */
+	for (BundleList::iterator iter = m_bundleList.begin(); iter
+			!= m_bundleList.end(); ++iter) {
+		Ptr<Bundle> bundle = *iter;
+		if (!bundle->HaveBeenReceivedFrom(remote.GetId())
+				&& remote == bundle->GetDestinationEndpoint()
+				&& FitsContactWindow(link, bundle)) {
+			return visitor.Visit(link, bundle);
+		}
+	}
+	for (BundleList::iterator iter = m_bundleList.begin(); iter
+			!= m_bundleList.end(); ++iter) {
+		Ptr<Bundle> bundle = *iter;
+		bool direct = !bundle->HaveBeenReceivedFrom(remote.GetId())
+				&& remote == bundle->GetDestinationEndpoint();
+		// All fragments of a bundle share its global id, the forward log tells them apart
+		if (!direct
+				&& (bundle->IsFragment() || !HasBundleRe(remote.GetId(), bundle->GetGlobalId()))
+				&& !m_forwardLog.HasEntry(bundle, link)
+				&& bundle->GetReplicationFactor() > 1
+				&& FitsContactWindow(link, bundle)) {
+			if (!visitor.Visit(link, bundle)) {
+				return false;
 			}
 		}
 	}
-	return linkBundleList;
+	return true;
 }
 
 uint8_t RTSprayAndWait::DoCalculateReplicationFactor(
@@ -458,7 +433,7 @@ void RTSprayAndWait::DoBundleDelivered(Ptr<Bundle> bundle, bool fromAck) {
 		Ptr<Bundle> bundle = *iter;
 		if (m_kdm.Has(bundle)) {
 			bl.push_back(bundle);
-			m_forwardLog.RemoveEntriesFor(bundle->GetBundleId());
+			RemoveForwardLogEntries(bundle->GetBundleId());
 		}
 	}
 
@@ -487,11 +462,16 @@ void RTSprayAndWait::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid)
 {
 	NeighHeader header;
 	header.SetBundleEndpointId(m_eid);
+	if (m_contactWindowAware) {
+		Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
+		header.SetMobility(mm->GetPosition(), mm->GetVelocity());
+	}
 
 	if(Simulator::Now ().GetSeconds () > curTime - 10)
 	{
 		m_nda->Stop();
 		while(!m_bundleList.empty()){m_bundleList.pop_front();}
+		m_evictionIndex.Clear();
 	}
 	else
 	{
@@ -507,22 +487,12 @@ void RTSprayAndWait::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid)
 		socket->Send(hello);
 	}
 }
-void RTSprayAndWait::DoHandleHello(Ptr<Socket> socket)
+void RTSprayAndWait::DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress)
 {
 	Ptr<MobilityModel> mm = m_node->GetObject<MobilityModel> ();
 	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - " << mm->GetPosition ());
 
-	Ptr<Packet> receivedHello;
-	Address fromAddress;
-	receivedHello = socket->RecvFrom(fromAddress);
-
-	NeighHeader header;
-	receivedHello->PeekHeader(header);
-
-	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << header.GetBundleEndpointId());
-
-	Simulator::ScheduleNow(&NeighbourhoodDetectionAgent::NotifyDiscoveredLink,
-			m_nda, receivedHello, fromAddress);
+	NS_LOG_DEBUG ("(" << m_node->GetId () << ") - eid = " << hello->GetBundleEndpointId());
 }
 /*sergioviera*/
 
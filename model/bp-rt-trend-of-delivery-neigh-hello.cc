@@ -5,12 +5,14 @@
  *      Author: sergio
  */
 
-#include "bp-rt-trend-of-delivery-neigh-hello.h"
-#include "ieee754.h"
-
+#include <cmath>
+#include <limits>
 
-/* IEEE 754 pack unpack */
+#include "ns3/global-value.h"
+#include "ns3/vector.h"
 
+#include "bp-rt-trend-of-delivery-neigh-hello.h"
+#include "bp-sdnv.h"
 
 
 NS_LOG_COMPONENT_DEFINE ("NeighHello");
@@ -20,8 +22,60 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED(NeighHello);
 
+static GlobalValue g_neighHelloOrigin ("NeighHelloOrigin",
+                "The point of the scenario the positions in the trend of delivery hellos are relative to",
+                VectorValue (Vector (0.0, 0.0, 0.0)),
+                MakeVectorChecker ());
+
+static uint64_t ZigZag(int64_t value)
+{
+        return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t value)
+{
+        return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
 
-NeighHello::NeighHello() {
+static double Scale(uint8_t digits)
+{
+        return std::pow(10.0, (double) digits);
+}
+
+/* Whole milliseconds between the time stamp and now, a stamp in the future is sent as now */
+static uint64_t TimeStampDelta(Time timeStamp)
+{
+        int64_t delta = Simulator::Now().GetMilliSeconds() - timeStamp.GetMilliSeconds();
+        return delta > 0 ? (uint64_t) delta : 0;
+}
+
+NeighHello::NeighHello()
+        : m_positionDigits(1),
+          m_velocityDigits(2)
+{
+        VectorValue origin;
+        g_neighHelloOrigin.GetValue(origin);
+        m_origin = Vector2d(origin.Get());
+}
+
+void NeighHello::SetPrecision(uint8_t positionDigits, uint8_t velocityDigits)
+{
+        NS_ASSERT(positionDigits < 16 && velocityDigits < 16);
+        m_positionDigits = positionDigits;
+        m_velocityDigits = velocityDigits;
+}
+
+int64_t NeighHello::QuantizePosition(double value, double origin) const
+{
+        return (int64_t) std::floor((value - origin) * Scale(m_positionDigits) + 0.5);
+}
+
+int16_t NeighHello::QuantizeVelocity(double value) const
+{
+        double scaled = std::floor(value * Scale(m_velocityDigits) + 0.5);
+        scaled = std::max(scaled, (double) -std::numeric_limits<int16_t>::max());
+        scaled = std::min(scaled, (double) std::numeric_limits<int16_t>::max());
+        return (int16_t) scaled;
 }
 
 void NeighHello::SetBundleEndpointId(BundleEndpointId eid) {
@@ -49,44 +103,48 @@ void NeighHello::Print(std::ostream &os) const {
 }
 
 uint32_t NeighHello::GetSerializedSize(void) const {
-        return m_eid.GetSerializedSize() + 4 + 32 + 8;
+        return Sdnv::EncodingLength(m_eid.GetId() + 1)
+                + 1 // precision
+                + Sdnv::EncodingLength(ZigZag(QuantizePosition(m_pos.x, m_origin.x)))
+                + Sdnv::EncodingLength(ZigZag(QuantizePosition(m_pos.y, m_origin.y)))
+                + 4 // velocity
+                + Sdnv::EncodingLength(TimeStampDelta(m_timeStamp));
 }
 
-
-
 void NeighHello::Serialize(Buffer::Iterator start) const {
-        int length = m_eid.GetSerializedSize();
         Buffer::Iterator i = start;
-        i.WriteHtonU32(length);
-        uint8_t buf[length];
-        m_eid.Serialize(buf);
-        i.Write(buf, length);
+        // Adjusted one step as in BundleEndpointId::Serialize, so the any eid is 0
+        Sdnv::Encode(m_eid.GetId() + 1, i);
+        i.WriteU8((m_positionDigits << 4) | m_velocityDigits);
 
-        i.WriteU64(pack754_64(m_pos.x));
-        i.WriteU64(pack754_64(m_pos.y));
+        Sdnv::Encode(ZigZag(QuantizePosition(m_pos.x, m_origin.x)), i);
+        Sdnv::Encode(ZigZag(QuantizePosition(m_pos.y, m_origin.y)), i);
 
-        i.WriteU64(pack754_64(m_vel.x));
-        i.WriteU64(pack754_64(m_vel.y));
+        i.WriteHtonU16((uint16_t) QuantizeVelocity(m_vel.x));
+        i.WriteHtonU16((uint16_t) QuantizeVelocity(m_vel.y));
 
-        i.WriteU64(pack754_64(m_timeStamp.GetSeconds()));
+        Sdnv::Encode(TimeStampDelta(m_timeStamp), i);
 }
 
 uint32_t NeighHello::Deserialize(Buffer::Iterator start) {
         Buffer::Iterator i = start;
-        uint32_t length = i.ReadNtohU32();
-        uint8_t buf[length];
-        i.Read(buf, length);
-        m_eid = BundleEndpointId::Deserialize(buf);
+        m_eid = BundleEndpointId((int) (Sdnv::Decode(i) - 1));
+        uint8_t precision = i.ReadU8();
+        m_positionDigits = precision >> 4;
+        m_velocityDigits = precision & 0x0f;
 
-        m_pos.x = unpack754_64(i.ReadU64());
-        m_pos.y = unpack754_64(i.ReadU64());
+        double positionScale = Scale(m_positionDigits);
+        m_pos.x = m_origin.x + UnZigZag(Sdnv::Decode(i)) / positionScale;
+        m_pos.y = m_origin.y + UnZigZag(Sdnv::Decode(i)) / positionScale;
 
-        m_vel.x = unpack754_64(i.ReadU64());
-        m_vel.y = unpack754_64(i.ReadU64());
+        double velocityScale = Scale(m_velocityDigits);
+        m_vel.x = (int16_t) i.ReadNtohU16() / velocityScale;
+        m_vel.y = (int16_t) i.ReadNtohU16() / velocityScale;
 
-        m_timeStamp = Seconds(unpack754_64(i.ReadU64()));
+        // Against the clock of the receiver, late by the whole milliseconds the hello was on the air
+        m_timeStamp = MilliSeconds(Simulator::Now().GetMilliSeconds() - (int64_t) Sdnv::Decode(i));
 
-        return GetSerializedSize();
+        return i.GetDistanceFrom(start);
 }
 
 void NeighHello::setPos(double x, double y) {
@@ -29,10 +29,25 @@
 namespace ns3 {
 namespace bundleProtocol {
 
+/*
+ * The position is sent as fixed point, relative to the NeighHelloOrigin
+ * global value, the velocity as 16 bit fixed point and the time stamp as
+ * the milliseconds between it and the sending of the hello, all with SDNVs
+ * except the velocity. The number of decimal digits kept is set by the
+ * sender and sent along, so the error of a position is at most half a unit
+ * of its last digit.
+ *
+ * The time stamp is truncated to the millisecond and taken back against
+ * the clock of the receiver: a hello stamped when it is sent costs one byte
+ * and is read as stamped when it is received.
+ */
 class NeighHello: public Header {
 public:
         NeighHello();
 
+        /* Decimal digits kept for the position (meters) and the velocity (m/s) */
+        void SetPrecision(uint8_t positionDigits, uint8_t velocityDigits);
+
         static TypeId GetTypeId(void);
         virtual TypeId GetInstanceTypeId(void) const;
         virtual void Print(std::ostream &os) const;
@@ -53,10 +68,16 @@ public:
         Time getTimeStamp() const;
 
 protected:
+        int64_t QuantizePosition(double value, double origin) const;
+        int16_t QuantizeVelocity(double value) const;
+
         BundleEndpointId m_eid;
         Vector2d m_pos; // current position
         Vector2d m_vel; // velocity
         Time m_timeStamp;
+        uint8_t m_positionDigits;
+        uint8_t m_velocityDigits;
+        Vector2d m_origin;
 };
 
 } /* namespace bundleProtocol */
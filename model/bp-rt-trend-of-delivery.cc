@@ -20,6 +20,7 @@
 #include "bp-header.h"
 #include "bp-contact.h"
 #include "bp-link-manager.h"
+#include "bp-bundle-protocol-agent.h"
 #include "bp-neighbourhood-detection-agent.h"
 #include "bp-rt-trend-of-delivery.h"
 #include "bp-rt-trend-of-delivery-neigh-hello.h"
@@ -34,6 +35,20 @@ namespace bundleProtocol {
 
 NS_OBJECT_ENSURE_REGISTERED (RTTrendOfDelivery);
 
+/* Trend of Delivery always sends its position and velocity */
+static Ptr<DecodedHello> DecodeNeighHello(Ptr<Packet> packet)
+{
+        NeighHello header;
+        packet->PeekHeader(header);
+        Ptr<TypedHello<NeighHello> > hello = Create<TypedHello<NeighHello> > (header);
+        hello->SetBundleEndpointId(header.GetBundleEndpointId());
+        hello->SetMobility(Vector(header.getPos().x, header.getPos().y, 0),
+                        Vector(header.getVel().x, header.getVel().y, 0));
+        return hello;
+}
+
+static HelloDecoderRegistrar g_trendOfDeliveryHelloDecoder (2, &DecodeNeighHello);
+
 TypeId RTTrendOfDelivery::GetTypeId(void) {
         static TypeId tid = TypeId ("ns3::bundleProtocol::RTTrendOfDelivery")
                 .SetParent<BundleRouter> ()
@@ -43,6 +58,21 @@ TypeId RTTrendOfDelivery::GetTypeId(void) {
                                 BooleanValue (false),
                                 MakeBooleanAccessor (&RTTrendOfDelivery::m_alwaysSendHello),
                                 MakeBooleanChecker ())
+                .AddAttribute ("HelloPositionDigits",
+                                "Decimal digits of the position, in meters, sent in the hellos.",
+                                UintegerValue (1),
+                                MakeUintegerAccessor (&RTTrendOfDelivery::m_helloPositionDigits),
+                                MakeUintegerChecker<uint8_t> (0, 6))
+                .AddAttribute ("HelloVelocityDigits",
+                                "Decimal digits of the velocity, in m/s, sent in the hellos. Velocities are limited to 32767 units of the last digit.",
+                                UintegerValue (2),
+                                MakeUintegerAccessor (&RTTrendOfDelivery::m_helloVelocityDigits),
+                                MakeUintegerChecker<uint8_t> (0, 4))
+                .AddAttribute ("PredictionHorizon",
+                                "How far ahead the neighbours and the destination are predicted within range when choosing the next hop.",
+                                TimeValue (Seconds (2.0)),
+                                MakeTimeAccessor (&RTTrendOfDelivery::m_predictionHorizon),
+                                MakeTimeChecker ())
                 .AddTraceSource ("RedundantRelay", "A message already held in the buffer has been received.",
                                 MakeTraceSourceAccessor (&RTTrendOfDelivery::m_redundantRelayLogger));
 
@@ -51,22 +81,12 @@ TypeId RTTrendOfDelivery::GetTypeId(void) {
 
 RTTrendOfDelivery::RTTrendOfDelivery() : BundleRouter(), m_send_timer((Timer::CANCEL_ON_DESTROY))
 {
+        m_helloPositionDigits = 1;
+        m_helloVelocityDigits = 2;
         m_transmissionRange = 350.0;
+        m_predictionHorizon = Seconds(2.0);
 
 	m_flag = false;
-	destinations[1].x = 1800;
-	destinations[1].y = 2000;
-	destinations[2].x = 1800;
-	destinations[2].y = 800;
-	/*Posições dos destinos*/
-        /*destinations[4].x = 600;
-	destinations[4].y = 2000;
-	destinations[5].x = 1200;
-	destinations[5].y = 2000;
-	destinations[6].x = 600;
-	destinations[6].y = 800;
-	destinations[7].x = 1200;
-	destinations[7].y = 800;*/
 	Simulator::ScheduleNow(&RTTrendOfDelivery::TryToStartSending, this);
 	
 }
@@ -85,6 +105,8 @@ void RTTrendOfDelivery::DoInit()
 
 void RTTrendOfDelivery::DoDispose()
 {
+        m_table.clear();
+        m_expirations.clear();
         BundleRouter::DoDispose();
 }
 
@@ -185,7 +207,7 @@ void RTTrendOfDelivery::DoBundleSent(const Address& address,
                         link->GetContact()->ResetRetransmissions();
                 }
 
-                m_forwardLog.AddEntry(bundle, link);
+                AddForwardLogEntry(bundle, link);
 
                 if (finalDelivery) {
                         BundleDelivered(bundle, true);
@@ -222,18 +244,11 @@ bool RTTrendOfDelivery::DoAcceptBundle(Ptr<Bundle> bundle,
                 m_redundantRelayLogger(bundle);
                 Ptr<Bundle> otherBundle = GetBundle(bundle->GetBundleId());
                 otherBundle->AddReceivedFrom(bundle->GetReceivedFrom().front());
-            	if(bundle->IsCustodyTransferRequested())
-            	{
-            		Ptr<Link> link = GetLinkManager()->FindLink(bundle->GetCustodianEndpoint());
-            		if(link)
-            		{
-            			Ptr<Bundle> bundleS = bundle->Copy();//GenerateBundle (Create<Packet> (1), bundle->GetCustodianEndpoint(), bundleProtocol::EXPEDITED,Seconds(100), bundleProtocol::PrimaryProcessingControlFlags ());
-            			bundleS->SetReportCustodyAcceptance(true);
-            			bundleS->SetReplicationFactor(20);
-            			bundleS->SetCustody(bundle->GetBundleId());
-            			SendBundle(link,bundleS);
-            		}
-            	}
+                /* Already have it, the custodian can drop its copy */
+                if (bundle->IsCustodyTransferRequested())
+                        m_node->GetObject<BundleProtocolAgent>()->QueueCustodySignal(
+                                        bundle->GetCustodianEndpoint(),
+                                        bundle->GetBundleId(), true);
                 return false;
         }
         return CanMakeRoomForBundle(bundle);
@@ -295,14 +310,22 @@ bool RTTrendOfDelivery::MakeRoomForBundle(Ptr<Bundle> bundle)
                 double minfuzzy = 999;
                 int j = 0;
                 int id = 0;
+                /* O melhor fuzzy depende so do destino, calculado uma vez por destino */
+                map<uint32_t, double> bestFuzzy;
                 for (BundleList::iterator iter = m_bundleList.begin(); iter
                                                 != m_bundleList.end();) {
                         Ptr<Bundle> currentBundle = *(iter++);
-                        fuzzy = -1;
-                        for(unsigned int i = 0; i < links.size(); i++){
-                        	if(getFuzzy(links[i]->GetRemoteEndpointId().GetId(),currentBundle->GetDestinationEndpoint().GetId() > fuzzy)){
-                        		fuzzy = getFuzzy(links[i]->GetRemoteEndpointId().GetId(),currentBundle->GetDestinationEndpoint().GetId());
-                        	}
+                        uint32_t dest = currentBundle->GetDestinationEndpoint().GetId();
+                        map<uint32_t, double>::iterator known = bestFuzzy.find(dest);
+                        if (known != bestFuzzy.end()) {
+                                fuzzy = known->second;
+                        } else {
+                                Vector2d destination = getDestination(dest);
+                                fuzzy = -1;
+                                for(unsigned int i = 0; i < links.size(); i++){
+                                        fuzzy = max(fuzzy, getFuzzy(links[i]->GetRemoteEndpointId().GetId(), destination));
+                                }
+                                bestFuzzy[dest] = fuzzy;
                         }
                         if(fuzzy < minfuzzy){
                         	minfuzzy = fuzzy;
@@ -366,7 +389,7 @@ bool RTTrendOfDelivery::IsDirectLink(Ptr <Link> link, Ptr <Bundle> bundle)
 void RTTrendOfDelivery::TryToStartSending() {
     //NS_LOG_DEBUG("(" << m_node->GetId () << ")");
      RemoveExpiredBundles(true);
-     m_forwardLog.RemoveExpiredEntries();
+     RemoveExpiredForwardLogEntries();
      if (!IsSending() && GetNBundles() > 0 && m_nda->GetStatus()) {
              LinkBundle linkBundle = FindNextToSend();
 
@@ -379,9 +402,9 @@ void RTTrendOfDelivery::TryToStartSending() {
 							NS_LOG_DEBUG("(" << m_node->GetId() << ") transfer to  "<< linkBundle.GetLink()->GetRemoteEndpointId().GetId() << "Bundle Id :*"<<linkBundle.GetBundle()->GetGlobalId() <<"*");
 
 							/*Inseri na lista de pacotes que trasnferiram custodia, serve para que ele nao receba novamente o mesmo pacote*/
-							InsertCustodyHistorical(linkBundle.GetBundle()->GetBundleId());
+							InsertCustodyHistorical(linkBundle.GetBundle());
 							/*Inseri na lista de pacotes que trasnferiram custodia, mas ainda não esperaram resposta*/
-							InsertCustodyHistoricalPending(linkBundle.GetBundle()->GetBundleId());
+							InsertCustodyHistoricalPending(linkBundle.GetBundle());
 							Simulator::Schedule (Seconds(5.0), &RTTrendOfDelivery::EraseCustodyHistoricalPending,this,linkBundle.GetBundle()->GetBundleId());
                      }
                      else
@@ -414,13 +437,13 @@ LinkBundle RTTrendOfDelivery::FindNextToSend()
         //NS_LOG_DEBUG("RTTrendOfDelivery::FindNextToSend");
         NS_LOG_DEBUG("(" << m_node->GetId() << ") - m_linkManager->GetConnectedLinks().size()= " << m_linkManager->GetConnectedLinks().size() << " GetNBundles() = " << GetNBundles() );
         if ((m_linkManager->GetConnectedLinks().size() > 0) && (GetNBundles() > 0)) {
-                LinkBundleList linkBundleList = GetAllDeliverableBundles();
-                //printLinkBundleList(linkBundleList);
+                BestLink best(this);
+                VisitDeliverableBundles(best);
                 //printTable();
-                if (!linkBundleList.empty()) {
+                if (!best.m_result.IsNull()) {
 		
 			NS_LOG_DEBUG("(" << m_node->GetId() << ")" <<"Lista Com Bundles");
-                        return getBestLink(linkBundleList);
+                        return getBestLink(best);
                 }
 		else
 		{
@@ -432,36 +455,42 @@ LinkBundle RTTrendOfDelivery::FindNextToSend()
 }
 
 
-bool RTTrendOfDelivery::isLinkInList(Ptr <Link> link,LinkBundleList lbl){
-	for (unsigned int i = 0; i < lbl.size(); i++){
-		if(lbl[i].GetLink() == link){
-			return true;
-		}
-	}
-	return false;
+RTTrendOfDelivery::BestLink::BestLink(RTTrendOfDelivery* router) :
+        m_router(router), m_result(), m_direct(false), m_fuzzyBundle(-1), m_links() {
+}
+
+bool RTTrendOfDelivery::BestLink::Visit(Ptr<Link> link, Ptr<Bundle> bundle) {
+        // The candidates come link by link
+        if (m_links.empty() || m_links.back() != link) {
+                m_links.push_back(link);
+        }
+        if (m_result.IsNull()) {
+                m_result = LinkBundle(link, bundle);
+        }
+        if (m_router->IsDirectLink(link, bundle)) {
+                m_result = LinkBundle(link, bundle);
+                m_direct = true;
+                return false;
+        }
+        double fuzzy = m_router->getFuzzy(link->GetRemoteEndpointId(), bundle->GetDestinationEndpoint().GetId());
+        if (fuzzy > m_fuzzyBundle) {
+                m_fuzzyBundle = fuzzy;
+                m_result = LinkBundle(link, bundle);
+        }
+        return true;
 }
 
 bool ta;
 
-LinkBundle RTTrendOfDelivery::getBestLink(LinkBundleList lbl) {
-        LinkBundle result = lbl[0];
+LinkBundle RTTrendOfDelivery::getBestLink(const BestLink& best) {
+        LinkBundle result = best.m_result;
       
-        double fuzzyBundle = -1;
 	//std::cout<<Simulator::Now ().GetSeconds()<<"\n"; 
-        for (unsigned int i = 0 ; i < lbl.size(); i++){
-			if(IsDirectLink(lbl[i].GetLink(), lbl[i].GetBundle())){
-				NS_LOG_DEBUG("(" << m_node->GetId() << ")" <<"Entrega Direta");
-				result = lbl[i];
-				ta = true;
-				getFuzzy(m_node->GetId(),result.GetBundle()->GetDestinationEndpoint().GetId());
-				return lbl[i];
-			}
-
-			if(getFuzzy(lbl[i].GetLink()->GetRemoteEndpointId(),lbl[i].GetBundle()->GetDestinationEndpoint().GetId()) > fuzzyBundle){
-				fuzzyBundle = getFuzzy(lbl[i].GetLink()->GetRemoteEndpointId(),lbl[i].GetBundle()->GetDestinationEndpoint().GetId());
-				result = lbl[i];
-			}
-
+        if (best.m_direct) {
+                NS_LOG_DEBUG("(" << m_node->GetId() << ")" <<"Entrega Direta");
+                ta = true;
+                getFuzzy(m_node->GetId(),result.GetBundle()->GetDestinationEndpoint().GetId());
+                return result;
         }
 
 
@@ -484,12 +513,35 @@ LinkBundle RTTrendOfDelivery::getBestLink(LinkBundleList lbl) {
 
         //printTable();
 
-        for (std::map<BundleEndpointId, TrendOfDeliveryTable>::iterator it =
-                        m_table.begin(); it != m_table.end(); ++it) {
+        /* Os nós que o índice espacial prevê no alcance dentro do horizonte de previsão */
+        Ptr<MobilityModel> mobility = m_node->GetObject<MobilityModel>();
+        vector<uint32_t> nodes = m_spatialIndex.GetNodesInRange(mobility->GetPosition(), mobility->GetVelocity(),
+                        m_transmissionRange, m_predictionHorizon);
+        set<uint32_t> reachable(nodes.begin(), nodes.end());
+
+        uint32_t dest = result.GetBundle()->GetDestinationEndpoint().GetId();
+        if (reachable.find(dest) != reachable.end()) {
+                // The destination itself comes within range before the horizon, carry the bundle to it
+                NS_LOG_DEBUG("(" << m_node->GetId() << ") keep for the destination " << dest);
+                Simulator::Schedule(Seconds(0.3) + JITTERT,&RTTrendOfDelivery::TryToStartSending, this);
+                return LinkBundle(0,0);/*Mantém consigo*/
+        }
+
+        /* Only the neighbours on the links that had candidates, and still within range over the horizon, can be chosen */
+        Vector2d destination = getDestination(dest);
+        for (vector<Ptr<Link> >::const_iterator link = best.m_links.begin(); link != best.m_links.end(); ++link) {
+                if (reachable.find((*link)->GetRemoteEndpointId().GetId()) == reachable.end()) {
+                        continue;
+                }
+                NeighTable::iterator it = m_table.find((*link)->GetRemoteEndpointId());
+                if (it == m_table.end() || (*it).second.m_expTime <= Simulator::Now()) {
+                        continue;
+                }
 
-                double tod = getFuzzy((*it).first,result.GetBundle()->GetDestinationEndpoint().GetId());
+                double tod = getFuzzy((*it).first, destination);
                 //NS_LOG_DEBUG("(" << m_node->GetId() << ") it eid = " << (*it).first << " it tod = " << tod);
-                if (tod > best_tod && (*it).second.m_expTime > Simulator::Now() && isLinkInList(GetLinkManager()->FindLink((*it).first),lbl)) {
+                // Ties go to the lowest eid, as when the whole table was scanned in order
+                if (tod > best_tod || (tod == best_tod && (*it).first < eid)) {
                         //NS_LOG_DEBUG("(" << m_node->GetId() << ") BEST");
                         best_tod = tod;
                         eid = (*it).first;
@@ -532,66 +584,45 @@ LinkBundle RTTrendOfDelivery::getBestLink(LinkBundleList lbl) {
         return LinkBundle(GetLinkManager()->FindLink(eid), result.GetBundle());
 }
 
-void RTTrendOfDelivery::printLinkBundleList(LinkBundleList lbl) {
-        deque<LinkBundle>::iterator it;
-        for (it = lbl.begin(); it != lbl.end(); ++it) {
-                NS_LOG_DEBUG("(" << m_node->GetId() << ") Link = " << (*it).GetLink()->GetRemoteEndpointId() << " Bundle = " << (*it).GetBundle()->GetBundleId());
-        }
-}
 LinkBundle RTTrendOfDelivery::GetNextRouterSpecific()
 {
         return LinkBundle(0, 0);
 }
 
-LinkBundleList RTTrendOfDelivery::GetAllDeliverableBundles()
+bool RTTrendOfDelivery::VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor)
 {
-        Links links = m_linkManager->GetConnectedLinks();
-        LinkBundleList result;
-        for (Links::iterator iter = links.begin(); iter != links.end(); ++iter) {
-                Ptr<Link> link = *iter;
-                LinkBundleList linkBundleList = GetAllBundlesForLink(link);
-                result.insert(result.end(), linkBundleList.begin(),     linkBundleList.end());
+        if (link->GetState() != LINK_CONNECTED) {
+                return true;
         }
-        return result;
-}
-
-LinkBundleList RTTrendOfDelivery::GetAllBundlesForLink(Ptr<Link> link)
-{
-    	LinkBundleList linkBundleList;
-        LinkBundleList direct;
-        if (link->GetState() == LINK_CONNECTED) {
-                if (link->GetState() == LINK_CONNECTED) {
-                        for (BundleList::iterator iter = m_bundleList.begin(); iter
-                                        != m_bundleList.end(); ++iter) {
-                                Ptr<Bundle> bundle = *iter;
-                                /*
-                                if (bundle->HasRetentionConstraint(RC_FORWARDING_PENDING)
-                                                && !bundle->HaveBeenReceivedFrom(link)
-                                                && (link->GetRemoteEndpointId()
-                                                                == bundle->GetDestinationEndpoint())
-                                                && !m_forwardLog.HasEntry(bundle, link)) {
-                                        linkBundleList.push_back(LinkBundle(link, *iter));
-                                }
-                                */
-                                /* agora não tem mais restrição de EID - virou epidêmico */
-
-                                if(!bundle->HaveBeenReceivedFrom(link->GetRemoteEndpointId().GetId()) && link->GetRemoteEndpointId() == bundle->GetDestinationEndpoint()){
-									direct.push_back(LinkBundle(link,*iter));
-									return direct;
-                                }
-
-                                else if (!HasBundleRe(link->GetRemoteEndpointId().GetId(),bundle->GetGlobalId())
-                                                && !m_forwardLog.HasEntry(bundle, link)
-                                                && !isBundleCustodyPending(bundle->GetBundleId())) {
-                                        linkBundleList.push_back(LinkBundle(link, *iter));
-                                        //linkBundleList.addNode(LinkBundle(link, *iter));
-					//cout<<"Get "<<m_node->GetId()<<": remote: "<<link->GetRemoteEndpointId().GetId()<<" " <<bundle->GetGlobalId()<<"\n";
-                                }
-
+        BundleEndpointId remote = link->GetRemoteEndpointId();
+        /* A bundle for the peer itself is the only candidate on the link */
+        for (BundleList::iterator iter = m_bundleList.begin(); iter
+                        != m_bundleList.end(); ++iter) {
+                Ptr<Bundle> bundle = *iter;
+                if (!bundle->HaveBeenReceivedFrom(remote.GetId())
+                                && remote == bundle->GetDestinationEndpoint()
+                                && FitsContactWindow(link, bundle)) {
+                        return visitor.Visit(link, bundle);
+                }
+        }
+        /* agora não tem mais restrição de EID - virou epidêmico */
+        for (BundleList::iterator iter = m_bundleList.begin(); iter
+                        != m_bundleList.end(); ++iter) {
+                Ptr<Bundle> bundle = *iter;
+                bool direct = !bundle->HaveBeenReceivedFrom(remote.GetId())
+                                && remote == bundle->GetDestinationEndpoint();
+                // All fragments of a bundle share its global id, the forward log tells them apart
+                if (!direct
+                                && (bundle->IsFragment() || !HasBundleRe(remote.GetId(), bundle->GetGlobalId()))
+                                && !m_forwardLog.HasEntry(bundle, link)
+                                && !isBundleCustodyPending(bundle->GetBundleId())
+                                && FitsContactWindow(link, bundle)) {
+                        if (!visitor.Visit(link, bundle)) {
+                                return false;
                         }
                 }
         }
-        return linkBundleList;
+        return true;
 }
 
 uint8_t RTTrendOfDelivery::DoCalculateReplicationFactor(
@@ -656,7 +687,7 @@ void RTTrendOfDelivery::DoBundleDelivered(Ptr<Bundle> bundle, bool fromAck) {
                 Ptr<Bundle> bundle = *iter;
                 if (m_kdm.Has(bundle)) {
                         bl.push_back(bundle);
-                        m_forwardLog.RemoveEntriesFor(bundle->GetBundleId());
+                        RemoveForwardLogEntries(bundle->GetBundleId());
                 }
         }
 
@@ -689,6 +720,7 @@ void RTTrendOfDelivery::DoSendHello(Ptr<Socket> socket, BundleEndpointId eid)
 	{
 		m_nda->Stop();
 		while(!m_bundleList.empty()){m_bundleList.pop_front();}
+		m_evictionIndex.Clear();
 	}
 	
         else if (IsTimeToSend()) {
@@ -771,6 +803,7 @@ void RTTrendOfDelivery::SendNeighHello(Ptr<Socket> socket, BundleEndpointId eid)
         header.setPos(mobilityModel->GetPosition().x, mobilityModel->GetPosition().y);
         header.setVel(mobilityModel->GetVelocity().x, mobilityModel->GetVelocity().y);
         header.setTimeStamp(Simulator::Now());
+        header.SetPrecision(m_helloPositionDigits, m_helloVelocityDigits);
 
 //        NS_LOG_DEBUG("(" << m_node->GetId() << ") "<< header);
 	
@@ -782,22 +815,14 @@ void RTTrendOfDelivery::SendNeighHello(Ptr<Socket> socket, BundleEndpointId eid)
 
 }
 
-void RTTrendOfDelivery::DoHandleHello(Ptr<Socket> socket)
+void RTTrendOfDelivery::DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress)
 {
-        Ptr<Packet> receivedHello;
-        Address fromAddress;
-
-        receivedHello = socket->RecvFrom(fromAddress);
-        NeighHello header;
-        receivedHello->PeekHeader(header);
+        const NeighHello& header = DynamicCast<TypedHello<NeighHello> > (hello)->GetHeader();
 
         NS_LOG_DEBUG ("(" << m_node->GetId () << ") - Received Message = " << header);
 
         addNeigh(header);
         //printTable();
-
-        Simulator::ScheduleNow(&NeighbourhoodDetectionAgent::NotifyDiscoveredLink,
-                        m_nda, receivedHello, fromAddress);
 }
 
 void RTTrendOfDelivery::addNeigh(const NeighHello& header) {
@@ -810,14 +835,20 @@ void RTTrendOfDelivery::addNeigh(const NeighHello& header) {
         tmp.m_timeStamp = header.getTimeStamp();
         tmp.m_pos = header.getPos();
         tmp.m_vel = header.getVel();
-        m_table[header.GetBundleEndpointId()] = tmp;
+
+        std::pair<NeighTable::iterator, bool> entry = m_table.insert(std::make_pair(header.GetBundleEndpointId(), tmp));
+        if (!entry.second) {
+                m_expirations.erase(std::make_pair(entry.first->second.m_expTime, entry.first->first));
+                entry.first->second = tmp;
+        }
+        m_expirations.insert(std::make_pair(tmp.m_expTime, entry.first->first));
 }
 
 void RTTrendOfDelivery::printTable() {
         NS_LOG_DEBUG("Neigh Table (" << m_node->GetId() << ")");
         NS_LOG_DEBUG("Neigh\tExp. Time\tTime Stamp\tPosition\tVelocity\tTOD");
         NS_LOG_DEBUG("--------------------------------------------------------------------------------");
-        for (std::map<BundleEndpointId, TrendOfDeliveryTable>::iterator it = m_table.begin(); it != m_table.end(); ++it) {
+        for (NeighTable::iterator it = m_table.begin(); it != m_table.end(); ++it) {
                 NS_LOG_DEBUG((*it).first << "\t" << (*it).second.m_expTime.GetSeconds() << "\t\t" << (*it).second.m_timeStamp.GetSeconds() << "\t\t" << (*it).second.m_pos << "\t" << (*it).second.m_vel << "\t\t" << getFuzzy((*it).first,3));
                 NS_LOG_DEBUG((*it).first << "\t" << (*it).second.m_expTime.GetSeconds() << "\t\t" << (*it).second.m_timeStamp.GetSeconds() << "\t\t" << (*it).second.m_pos << "\t" << (*it).second.m_vel << "\t\t" << getFuzzy((*it).first,4));
                 NS_LOG_DEBUG((*it).first << "\t" << (*it).second.m_expTime.GetSeconds() << "\t\t" << (*it).second.m_timeStamp.GetSeconds() << "\t\t" << (*it).second.m_pos << "\t" << (*it).second.m_vel << "\t\t" << getFuzzy((*it).first,5));
@@ -828,30 +859,64 @@ void RTTrendOfDelivery::printTable() {
 }
 
 void RTTrendOfDelivery::removeExpiredNeighs() {
-        for (std::map<BundleEndpointId, TrendOfDeliveryTable>::iterator it = m_table.begin(); it != m_table.end();) {
-                if (Simulator::Now().GetSeconds() > (*it).second.m_expTime.GetSeconds()) {
-                        NS_LOG_DEBUG("(" << m_node->GetId() << ") Delete " << (*it).first);
-                        std::map<BundleEndpointId, TrendOfDeliveryTable>::iterator toErase = it;
-                        ++it;
-                        m_table.erase(toErase);
-                }
-                else
-                {
-                	++it;
-                }
-        }
+        /* Only the neighbours that have expired are visited */
+        while (!m_expirations.empty() && Simulator::Now() > m_expirations.begin()->first) {
+                BundleEndpointId eid = m_expirations.begin()->second;
+                NS_LOG_DEBUG("(" << m_node->GetId() << ") Delete " << eid);
+                m_expirations.erase(m_expirations.begin());
+                m_spatialIndex.Remove(eid.GetId());
+                m_table.erase(eid);
+        }
+}
+
+const destTable& RTTrendOfDelivery::GetDestinations() {
+        static destTable destinations;
+        if (destinations.empty()) {
+                destinations[1].x = 1800;
+                destinations[1].y = 2000;
+                destinations[2].x = 1800;
+                destinations[2].y = 800;
+                /*Posições dos destinos*/
+                /*destinations[4].x = 600;
+                destinations[4].y = 2000;
+                destinations[5].x = 1200;
+                destinations[5].y = 2000;
+                destinations[6].x = 600;
+                destinations[6].y = 800;
+                destinations[7].x = 1200;
+                destinations[7].y = 800;*/
+        }
+        return destinations;
+}
+
+Vector2d RTTrendOfDelivery::getDestination(uint32_t id) const {
+        /* Um destino desconhecido fica na origem, sem ser inserido na tabela */
+        const destTable& destinations = GetDestinations();
+        destTable::const_iterator it = destinations.find(id);
+        if (it == destinations.end())
+                return Vector2d();
+        return it->second;
 }
 
 double RTTrendOfDelivery::getFuzzy(BundleEndpointId eid,uint32_t id) {
+        return getFuzzy(eid, getDestination(id));
+}
+
+double RTTrendOfDelivery::getFuzzy(BundleEndpointId eid, const Vector2d& destination) {
         double result = 0.0;
 	Vector2d my_pos_, my_vel_;
 
         
 	if(eid != m_node->GetId()){
+		/* A neighbour not heard from yet counts as standing still at the origin */
+		TrendOfDeliveryTable neigh = TrendOfDeliveryTable();
+		NeighTable::const_iterator it = m_table.find(eid);
+		if (it != m_table.end())
+			neigh = it->second;
 		double now_ = Simulator::Now().GetSeconds();
-        	my_pos_.x = m_table[eid].m_pos.x + m_table[eid].m_vel.x * (now_ - m_table[eid].m_timeStamp.GetSeconds() + 2.0);
-        	my_pos_.y = m_table[eid].m_pos.y + m_table[eid].m_vel.y * (now_ - m_table[eid].m_timeStamp.GetSeconds() + 2.0);
-        	my_vel_ = m_table[eid].m_vel;
+        	my_pos_.x = neigh.m_pos.x + neigh.m_vel.x * (now_ - neigh.m_timeStamp.GetSeconds() + 2.0);
+        	my_pos_.y = neigh.m_pos.y + neigh.m_vel.y * (now_ - neigh.m_timeStamp.GetSeconds() + 2.0);
+        	my_vel_ = neigh.m_vel;
         }
         else
         {
@@ -864,9 +929,11 @@ double RTTrendOfDelivery::getFuzzy(BundleEndpointId eid,uint32_t id) {
 
 
 
-        m_tod.setFuzzy(my_pos_, destinations[id], m_transmissionRange);
+        // setFuzzy takes the destination by non const reference
+        Vector2d dest_ = destination;
+        m_tod.setFuzzy(my_pos_, dest_, m_transmissionRange);
 
-        Vector2d w = destinations[id] - my_pos_;
+        Vector2d w = dest_ - my_pos_;
         double theta_vel = w.angle(my_vel_);
 
 	NS_LOG_DEBUG("(" << eid << ")" <<" velK:" << my_vel_.length());
@@ -8,6 +8,7 @@
 
 
 #include <deque>
+#include <vector>
 
 #include "ns3/traced-callback.h"
 #include "ns3/timer.h"
@@ -19,6 +20,9 @@
 #include "link-life-time.h"
 #include "trend-of-delivery.xfs.hpp"
 #include <map>
+#include <set>
+#include <tr1/unordered_map>
+#include <utility>
 #define JITTERT (Seconds (UniformVariable ().GetValue (0, 0.1)))
 
 using namespace std;
@@ -44,6 +48,11 @@ typedef struct {
         Vector2d m_vel;
 } TrendOfDeliveryTable;
 
+/* Tabela de vizinhança, indexada pelo endpoint id do vizinho */
+typedef std::tr1::unordered_map<BundleEndpointId, TrendOfDeliveryTable, BundleEndpointIdHash> NeighTable;
+/* The neighbours by expiration time, the first one expires first */
+typedef std::set<std::pair<Time, BundleEndpointId> > NeighExpirations;
+
 //typedef CircularLinkedList<LinkBundle> LinkBundleCircularList;
 
 class RTTrendOfDelivery: public BundleRouter {
@@ -96,40 +105,44 @@ private:
 
 
 
-        LinkBundleList GetAllDeliverableBundles();
-        LinkBundleList GetAllBundlesForLink(Ptr<Link> link);
+        bool VisitBundlesForLink(Ptr<Link> link, LinkBundleVisitor& visitor);
         LinkBundle GetNextRouterSpecific();
 
         // Orwar specific
         void TryToStartSending();
         LinkBundle FindNextToSend();
-        LinkBundle getBestLink(LinkBundleList lbl);
-        void printLinkBundleList(LinkBundleList lbl);
+        class BestLink;
+        LinkBundle getBestLink(const BestLink& best);
         /* sergiosvieira */
         void DoSendHello(Ptr<Socket> socket, BundleEndpointId eid);
         bool IsTimeToSend();
         Vector2d CalcMyPredictedPosition(double time);
         void DoNeighCalc();
         void SendNeighHello(Ptr<Socket> socket, BundleEndpointId eid);
-        void DoHandleHello(Ptr<Socket> socket);
+        void DoHandleHello(Ptr<DecodedHello> hello, Address fromAddress);
         void addNeigh(const NeighHello& header);
         void printTable();
         void removeExpiredNeighs();
         double getFuzzy(BundleEndpointId eid, uint32_t id);
+        /* The same with the position of the destination already looked up */
+        double getFuzzy(BundleEndpointId eid, const Vector2d& destination);
+        Vector2d getDestination(uint32_t id) const;
+        /* Posições dos destinos, uma tabela só para todos os roteadores */
+        static const destTable& GetDestinations();
         /* sergiosvieira */
 
         /*Joao*/
         bool IsDirectLink(Ptr <Link> link, Ptr <Bundle> bundle);
-	bool isLinkInList(Ptr <Link> link,LinkBundleList lbl);
         /*Joao*/
 
         void PauseLink(Ptr<Link> link);
         void UnPauseLink(Ptr<Link> link);
 
         trendofdelivery m_tod;
-        std::map<BundleEndpointId, TrendOfDeliveryTable> m_table; // Tabela de vizinhança
-        destTable destinations;
+        NeighTable m_table; // Tabela de vizinhança
+        NeighExpirations m_expirations;
         double m_transmissionRange; // alcance de transmissão
+        Time m_predictionHorizon; // até quando os vizinhos e o destino são previstos no alcance
         bool m_flag; // usado para enviar a primeira mensagem, pois não existe posição anterior.
         Vector2d m_myLastPosition; // minha posição quando enviei a mensagem
         Vector2d m_myLastVelocity; // minha velocidade quando enviei a mensagem
@@ -142,6 +155,8 @@ private:
         uint8_t m_deltaReplicationFactor;
         bool m_estimateCw;
         bool m_alwaysSendHello;
+        uint8_t m_helloPositionDigits;
+        uint8_t m_helloVelocityDigits;
         Time m_pauseTime;
         uint32_t m_maxRetries;
         KnownDeliveredMessages m_kdm;
@@ -183,6 +198,22 @@ private:
                 }
         };
 
+        /*
+         * The first candidate for its own destination, or else the one with the
+         * best trend of delivery, and the links that had any candidate.
+         */
+        class BestLink: public LinkBundleVisitor {
+        public:
+                BestLink(RTTrendOfDelivery* router);
+                bool Visit(Ptr<Link> link, Ptr<Bundle> bundle);
+
+                RTTrendOfDelivery* m_router;
+                LinkBundle m_result;
+                bool m_direct;
+                double m_fuzzyBundle;
+                vector<Ptr<Link> > m_links;
+        };
+
         struct EqualEids: public std::unary_function<Ptr<Bundle> , bool> {
                 BundleEndpointId m_eid;
 
@@ -0,0 +1,204 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cmath>
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include "bp-spatial-index.h"
+
+namespace ns3 {
+namespace bundleProtocol {
+
+NS_LOG_COMPONENT_DEFINE ("SpatialIndex");
+
+SpatialIndex::SpatialIndex ()
+  : m_cellSize (100),
+    m_maxAge (Seconds (10)),
+    m_maxSpeed (0),
+    m_entries (),
+    m_cells ()
+{}
+
+SpatialIndex::~SpatialIndex ()
+{
+  Clear ();
+}
+
+void
+SpatialIndex::Configure (double cellSize, Time maxAge)
+{
+  NS_ASSERT (cellSize > 0);
+  m_maxAge = maxAge;
+  if (cellSize == m_cellSize)
+    {
+      return;
+    }
+
+  // Rebucket the entries for the new cell size
+  m_cellSize = cellSize;
+  m_cells.clear ();
+  for (Entries::iterator iter = m_entries.begin (); iter != m_entries.end (); ++iter)
+    {
+      iter->second.m_cell = GetCell (iter->second.m_position.x, iter->second.m_position.y);
+      m_cells[iter->second.m_cell].insert (iter->first);
+    }
+}
+
+SpatialIndex::Cell
+SpatialIndex::GetCell (double x, double y) const
+{
+  return Cell ((int32_t) floor (x / m_cellSize), (int32_t) floor (y / m_cellSize));
+}
+
+bool
+SpatialIndex::IsExpired (const Entry& entry) const
+{
+  return Simulator::Now () - entry.m_heard > m_maxAge;
+}
+
+void
+SpatialIndex::Update (uint32_t id, const Vector& position, const Vector& velocity)
+{
+  Cell cell = GetCell (position.x, position.y);
+  Entries::iterator iter = m_entries.find (id);
+  if (iter == m_entries.end ())
+    {
+      iter = m_entries.insert (make_pair (id, Entry ())).first;
+    }
+  else if (iter->second.m_cell != cell)
+    {
+      Cells::iterator old = m_cells.find (iter->second.m_cell);
+      old->second.erase (id);
+      if (old->second.empty ())
+        {
+          m_cells.erase (old);
+        }
+    }
+
+  iter->second.m_position = position;
+  iter->second.m_velocity = velocity;
+  iter->second.m_heard = Simulator::Now ();
+  iter->second.m_cell = cell;
+  m_cells[cell].insert (id);
+
+  m_maxSpeed = max (m_maxSpeed, sqrt (velocity.x * velocity.x + velocity.y * velocity.y));
+}
+
+void
+SpatialIndex::Remove (uint32_t id)
+{
+  Entries::iterator iter = m_entries.find (id);
+  if (iter == m_entries.end ())
+    {
+      return;
+    }
+
+  Cells::iterator cell = m_cells.find (iter->second.m_cell);
+  cell->second.erase (id);
+  if (cell->second.empty ())
+    {
+      m_cells.erase (cell);
+    }
+  m_entries.erase (iter);
+}
+
+bool
+SpatialIndex::GetMobility (uint32_t id, Vector& position, Vector& velocity) const
+{
+  Entries::const_iterator iter = m_entries.find (id);
+  if (iter == m_entries.end () || IsExpired (iter->second))
+    {
+      return false;
+    }
+
+  double elapsed = (Simulator::Now () - iter->second.m_heard).GetSeconds ();
+  position = Vector (iter->second.m_position.x + iter->second.m_velocity.x * elapsed,
+                     iter->second.m_position.y + iter->second.m_velocity.y * elapsed,
+                     iter->second.m_position.z);
+  velocity = iter->second.m_velocity;
+  return true;
+}
+
+double
+SpatialIndex::GetClosestDistance (const Entry& entry, const Vector& position, const Vector& velocity, double horizon) const
+{
+  double elapsed = (Simulator::Now () - entry.m_heard).GetSeconds ();
+
+  // Relative position and velocity of the node, in the plane
+  double px = entry.m_position.x + entry.m_velocity.x * elapsed - position.x;
+  double py = entry.m_position.y + entry.m_velocity.y * elapsed - position.y;
+  double vx = entry.m_velocity.x - velocity.x;
+  double vy = entry.m_velocity.y - velocity.y;
+
+  // The time within the horizon when the nodes are closest
+  double a = vx * vx + vy * vy;
+  double t = 0;
+  if (a > 0)
+    {
+      t = min (horizon, max (0.0, - (px * vx + py * vy) / a));
+    }
+
+  double dx = px + vx * t;
+  double dy = py + vy * t;
+  return sqrt (dx * dx + dy * dy);
+}
+
+vector<uint32_t>
+SpatialIndex::GetNodesInRange (const Vector& position, const Vector& velocity, double range, Time horizon)
+{
+  vector<uint32_t> result;
+  double t = horizon.GetSeconds ();
+  double speed = sqrt (velocity.x * velocity.x + velocity.y * velocity.y);
+
+  // A node can at most have moved m_maxSpeed since it was heard and during the horizon
+  double reach = range + speed * t + m_maxSpeed * (m_maxAge.GetSeconds () + t);
+  Cell low = GetCell (position.x - reach, position.y - reach);
+  Cell high = GetCell (position.x + reach, position.y + reach);
+
+  vector<uint32_t> expired;
+  for (int32_t x = low.first; x <= high.first; ++x)
+    {
+      // Only cells with nodes in them are stored
+      Cells::const_iterator iter = m_cells.lower_bound (Cell (x, low.second));
+      Cells::const_iterator end = m_cells.upper_bound (Cell (x, high.second));
+      for (; iter != end; ++iter)
+        {
+          for (set<uint32_t>::const_iterator id = iter->second.begin (); id != iter->second.end (); ++id)
+            {
+              const Entry& entry = m_entries.find (*id)->second;
+              if (IsExpired (entry))
+                {
+                  expired.push_back (*id);
+                }
+              else if (GetClosestDistance (entry, position, velocity, t) <= range)
+                {
+                  result.push_back (*id);
+                }
+            }
+        }
+    }
+
+  for (vector<uint32_t>::iterator id = expired.begin (); id != expired.end (); ++id)
+    {
+      Remove (*id);
+    }
+
+  NS_LOG_DEBUG ("GetNodesInRange found " << result.size () << " of " << m_entries.size () << " nodes");
+  return result;
+}
+
+uint32_t
+SpatialIndex::GetNNodes () const
+{
+  return m_entries.size ();
+}
+
+void
+SpatialIndex::Clear ()
+{
+  m_entries.clear ();
+  m_cells.clear ();
+}
+
+}} // namespace bundleProtocol, ns3
@@ -0,0 +1,97 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef BP_SPATIAL_INDEX_H
+#define BP_SPATIAL_INDEX_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+using namespace std;
+
+namespace ns3 {
+namespace bundleProtocol {
+
+/**
+ * \ingroup bundleRouter
+ *
+ * \brief A uniform grid over the last known positions and velocities of other nodes.
+ *
+ * Fed from the mobility in received hellos. A query only visits the cells
+ * that a node could have reached since it was heard, so the cost depends on
+ * the node density around the querying node and not on the network size.
+ * Entries older than the maximum age are ignored and removed lazily.
+ */
+class SpatialIndex
+{
+ public:
+  SpatialIndex ();
+  ~SpatialIndex ();
+
+  /**
+   * \param cellSize The side of a grid cell in meters, about the transmission range is a good value.
+   * \param maxAge How long an entry is kept after the node was last heard.
+   */
+  void Configure (double cellSize, Time maxAge);
+
+  /**
+   * \brief Stores where a node was when it was heard.
+   * \param id The node, i.e the id of its bundle endpoint.
+   * \param position The position of the node when heard.
+   * \param velocity The velocity of the node when heard.
+   */
+  void Update (uint32_t id, const Vector& position, const Vector& velocity);
+  void Remove (uint32_t id);
+
+  /**
+   * \brief The mobility of a node, extrapolated from when it was heard to now.
+   * \return False if the node is unknown or its entry is too old.
+   */
+  bool GetMobility (uint32_t id, Vector& position, Vector& velocity) const;
+
+  /**
+   * \brief Finds the nodes that are predicted to be within range at some time during the horizon.
+   * \param position The position of the querying node.
+   * \param velocity The velocity of the querying node.
+   * \param range The transmission range.
+   * \param horizon How far ahead to look, zero means in range now.
+   * \return The ids of the nodes, in no particular order.
+   */
+  vector<uint32_t> GetNodesInRange (const Vector& position, const Vector& velocity, double range, Time horizon);
+
+  uint32_t GetNNodes () const;
+  void Clear ();
+
+ private:
+  typedef pair<int32_t, int32_t> Cell;
+
+  struct Entry
+  {
+    Vector m_position;
+    Vector m_velocity;
+    Time m_heard;
+    Cell m_cell;
+  };
+
+  typedef map<uint32_t, Entry> Entries;
+  typedef map<Cell, set<uint32_t> > Cells;
+
+  Cell GetCell (double x, double y) const;
+  bool IsExpired (const Entry& entry) const;
+  double GetClosestDistance (const Entry& entry, const Vector& position, const Vector& velocity, double horizon) const;
+
+  double m_cellSize;
+  Time m_maxAge;
+  double m_maxSpeed; // The highest speed seen, bounds how far a node can have moved
+  Entries m_entries;
+  Cells m_cells;
+};
+
+}} // namespace bundleProtocol, ns3
+
+#endif /* BP_SPATIAL_INDEX_H */
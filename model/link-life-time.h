@@ -8,6 +8,10 @@
 #ifndef LINKLIFETIME_H_
 #define LINKLIFETIME_H_
 
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
 #include "ns3/vector2d.h"
 #include "ns3/nstime.h"
 
@@ -47,7 +51,7 @@ public:
                 Vector2d neighbour_velocity = vel_b;
                 double trange = transmission_range;
 
-                double let, a, b, c, x_1, x_2, delta;
+                double let = 0.0, a, b, c, x_1, x_2, delta; // 0 se o enlace já acabou
                 //se os carros estão parados
                 if ((my_velocity.x == 0.0) && (my_velocity.y == 0.0)
                                 && (neighbour_velocity.x == 0.0) && (neighbour_velocity.y
@@ -105,8 +109,50 @@ public:
                 return result;
         }
 
-};
+        /*
+         * Os mesmos tempos de vida de getExpirationTime para todos os vizinhos
+         * de uma vez, em segundos a partir de agora. As posições e velocidades
+         * dos vizinhos vêm em vetores separados (structure of arrays) e o laço
+         * não tem desvios, o GCC o vetoriza com -O3 -fno-math-errno
+         * -fno-trapping-math.
+         */
+        inline static void getLinkLifeTimes(double pos_x, double pos_y,
+                        double vel_x, double vel_y,
+                        const double *neigh_pos_x, const double *neigh_pos_y,
+                        const double *neigh_vel_x, const double *neigh_vel_y,
+                        uint32_t n, double transmission_range, double *let) {
+                const double inf = 50.0;
+                const double eps = 0.00001;
+                const double r2 = transmission_range * transmission_range;
+                const bool i_am_stopped = (vel_x == 0.0) & (vel_y == 0.0);
+
+                for (uint32_t i = 0; i < n; i++) {
+                        bool stopped = i_am_stopped & (neigh_vel_x[i] == 0.0)
+                                        & (neigh_vel_y[i] == 0.0);
+                        double dvx = vel_x - neigh_vel_x[i];
+                        double dvy = vel_y - neigh_vel_y[i];
+                        double dx = pos_x - neigh_pos_x[i];
+                        double dy = pos_y - neigh_pos_y[i];
+                        dvx = dvx == 0.0 ? -eps : dvx;
+                        dvy = dvy == 0.0 ? -eps : dvy;
+                        dx = dx == 0.0 ? -eps : dx;
+                        dy = dy == 0.0 ? -eps : dy;
+
+                        double a = dvx * dvx + dvy * dvy;
+                        double b = 2.0 * (dx * dvx + dy * dvy);
+                        double c = dx * dx + dy * dy - r2;
+                        double delta = b * b - 4.0 * a * c;
+                        // a > 0, a maior raiz é a única que pode estar no futuro
+                        double x_1 = (-b + std::sqrt(std::max(delta, 0.0))) / (2.0 * a);
+
+                        double t = delta < 0.0 ? inf : std::max(x_1, 0.0);
+                        t = stopped ? inf : t;
+                        let[i] = std::min(t, inf);
+                }
+        }
 
-#endif /* LINKLIFETIME_H_ */
+};
 
 }
+
+#endif /* LINKLIFETIME_H_ */
@@ -0,0 +1,135 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/bp-global-bundle-identifier.h"
+#include "ns3/bp-aggregate-custody-signal.h"
+#include "ns3/bp-administrative-record-header.h"
+
+using namespace ns3;
+using namespace ns3::bundleProtocol;
+
+static GlobalBundleIdentifier
+Whole (uint32_t source, uint64_t seconds, uint64_t sequence)
+{
+  return GlobalBundleIdentifier (BundleEndpointId (source), CreationTimestamp (seconds, sequence));
+}
+
+static GlobalBundleIdentifier
+Fragment (uint32_t source, uint64_t seconds, uint64_t sequence, uint64_t offset, uint64_t length)
+{
+  return GlobalBundleIdentifier (BundleEndpointId (source), CreationTimestamp (seconds, sequence), offset, length);
+}
+
+/*
+ * AggregateCustodySignal through a packet and back, as the custody signal
+ * bundles carry it: several sources, bundles created in the same second,
+ * fragments mixed with whole bundles, and an empty signal.
+ */
+class AggregateCustodySignalTestCase : public TestCase
+{
+public:
+  AggregateCustodySignalTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void CheckRoundTrip (const AggregateCustodySignal& sent, const std::string& name);
+};
+
+AggregateCustodySignalTestCase::AggregateCustodySignalTestCase ()
+  : TestCase ("Aggregate custody signal round trip")
+{
+}
+
+void
+AggregateCustodySignalTestCase::CheckRoundTrip (const AggregateCustodySignal& sent, const std::string& name)
+{
+  AdministrativeRecordHeader header (sent);
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), header.GetSerializedSize (), name << ": serialized size");
+
+  AdministrativeRecordHeader read;
+  uint32_t bytes = packet->RemoveHeader (read);
+  NS_TEST_EXPECT_MSG_EQ ((bytes == header.GetSerializedSize () && packet->GetSize () == 0), true, name << ": the whole signal is read");
+  NS_TEST_ASSERT_MSG_EQ (read.GetRecordType (), AGGREGATE_CUSTODY_SIGNAL, name << ": record type");
+
+  AggregateCustodySignal received = read.GetAggregateCustodySignal ();
+  NS_TEST_EXPECT_MSG_EQ (received.GetCustodyTransferSucceeded (), sent.GetCustodyTransferSucceeded (), name << ": status");
+  NS_TEST_EXPECT_MSG_EQ (received.GetReasonCode (), sent.GetReasonCode (), name << ": reason");
+  NS_TEST_ASSERT_MSG_EQ (received.GetNBundles (), sent.GetNBundles (), name << ": number of bundles");
+
+  GlobalBundleIdentifiers expected = sent.GetBundles ();
+  GlobalBundleIdentifiers bundles = received.GetBundles ();
+  for (uint32_t i = 0; i < expected.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((bundles[i] == expected[i]), true, name << ": bundle " << i);
+    }
+}
+
+void
+AggregateCustodySignalTestCase::DoRun (void)
+{
+  CheckRoundTrip (AggregateCustodySignal (true, CUSTODY_NO_ADDITIONAL_INFORMATION), "empty");
+
+  AggregateCustodySignal signal (true, CUSTODY_REDUNDANT_RECEPTION);
+  // Added out of order and once twice, the signal sorts and merges them
+  signal.AddBundle (Whole (300, 10, 3));
+  signal.AddBundle (Whole (1, 10, 2));
+  signal.AddBundle (Whole (1, 10, 0));
+  signal.AddBundle (Whole (1, 10, 1));
+  signal.AddBundle (Whole (1, 10, 2));
+  // Same second further apart, the next seconds and far later
+  signal.AddBundle (Whole (1, 10, 500000000));
+  signal.AddBundle (Whole (1, 10, 999999999));
+  signal.AddBundle (Whole (1, 11, 0));
+  signal.AddBundle (Whole (1, 11, 7));
+  signal.AddBundle (Whole (1, 4000000, 123456789));
+  // Fragments of a bundle, the bundle itself and the bundles around it in the same second
+  signal.AddBundle (Fragment (7, 20, 5, 100, 100));
+  signal.AddBundle (Fragment (7, 20, 5, 0, 100));
+  signal.AddBundle (Whole (7, 20, 5));
+  signal.AddBundle (Whole (7, 20, 4));
+  signal.AddBundle (Fragment (7, 20, 6, 250, 1));
+  signal.AddBundle (Whole (7, 20, 7));
+  signal.AddBundle (Fragment (7, 21, 0, 70000, 300000));
+  // A source between the others
+  signal.AddBundle (Whole (5, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (signal.GetNBundles (), 17u, "duplicates are merged");
+  CheckRoundTrip (signal, "mixed");
+
+  // Every bundle of a source in one second
+  AggregateCustodySignal run (false, CUSTODY_DEPLETED_STORAGE);
+  for (uint64_t sequence = 0; sequence < 100; sequence++)
+    {
+      run.AddBundle (Whole (2, 30, 700000000 + sequence));
+    }
+  CheckRoundTrip (run, "same second");
+
+  // Only fragments, from several sources
+  AggregateCustodySignal fragments (false, CUSTODY_NO_TIMELY_CONTACT);
+  for (uint32_t source = 1; source <= 3; source++)
+    {
+      for (uint64_t offset = 0; offset < 1000; offset += 250)
+        {
+          fragments.AddBundle (Fragment (source, 40 + source, 1000 * source, offset, 250));
+        }
+    }
+  CheckRoundTrip (fragments, "fragments");
+}
+
+class AggregateCustodySignalTestSuite : public TestSuite
+{
+public:
+  AggregateCustodySignalTestSuite ();
+};
+
+AggregateCustodySignalTestSuite::AggregateCustodySignalTestSuite ()
+  : TestSuite ("bundle-protocol-aggregate-custody-signal", UNIT)
+{
+  AddTestCase (new AggregateCustodySignalTestCase);
+}
+
+static AggregateCustodySignalTestSuite g_aggregateCustodySignalTestSuite;
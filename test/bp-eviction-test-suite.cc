@@ -0,0 +1,146 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <deque>
+#include <vector>
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/bp-bundle.h"
+#include "ns3/bp-eviction-policy.h"
+
+using namespace ns3;
+using namespace ns3::bundleProtocol;
+
+static Ptr<Bundle>
+MakeBundle (uint64_t seq, uint32_t payload, BundlePriority priority, double lifetime)
+{
+  Ptr<Bundle> bundle = CreateObject<Bundle> ();
+  bundle->SetPayload (Create<Packet> (payload));
+  bundle->SetSourceEndpoint (BundleEndpointId (1));
+  bundle->SetCreationTimestamp (CreationTimestamp (10, seq));
+  bundle->SetPriority (priority);
+  bundle->SetLifetime (Seconds (lifetime));
+  // The bundle id is only updated with the primary header
+  bundle->SetPrimaryHeader (bundle->GetPrimaryHeader ());
+  return bundle;
+}
+
+/*
+ * The order in which EvictionIndex hands out victims for each eviction
+ * policy, and MostForwarded following the forward counts up and down.
+ */
+class EvictionOrderTestCase : public TestCase
+{
+public:
+  EvictionOrderTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /* Drains the index and compares the victims with the expected order of bundles */
+  void CheckOrder (EvictionIndex& index, const uint32_t* order, const std::string& name);
+
+  std::vector<Ptr<Bundle> > m_bundles;
+};
+
+EvictionOrderTestCase::EvictionOrderTestCase ()
+  : TestCase ("Victim order of every eviction policy")
+{
+}
+
+void
+EvictionOrderTestCase::CheckOrder (EvictionIndex& index, const uint32_t* order, const std::string& name)
+{
+  for (uint32_t i = 0; i < m_bundles.size (); i++)
+    {
+      Ptr<Bundle> victim = index.GetVictim ();
+      std::ostringstream what;
+      what << name << ": victim " << i;
+      NS_TEST_EXPECT_MSG_EQ ((victim != 0 && victim->GetBundleId () == m_bundles[order[i]]->GetBundleId ()), true, what.str ());
+      if (victim == 0)
+        {
+          return;
+        }
+      index.Remove (victim->GetBundleId ());
+    }
+  NS_TEST_EXPECT_MSG_EQ ((index.IsEmpty () && index.GetVictim () == 0), true, name << ": empty after draining");
+}
+
+void
+EvictionOrderTestCase::DoRun (void)
+{
+  // Inserted in this order, oldest first
+  m_bundles.push_back (MakeBundle (0, 100, NORMAL, 300));
+  m_bundles.push_back (MakeBundle (1, 400, BULK, 100));
+  m_bundles.push_back (MakeBundle (2, 200, EXPEDITED, 400));
+  m_bundles.push_back (MakeBundle (3, 300, NORMAL, 200));
+  std::deque<Ptr<Bundle> > buffer (m_bundles.begin (), m_bundles.end ());
+  std::deque<uint32_t> forwarded;
+  forwarded.push_back (1);
+  forwarded.push_back (0);
+  forwarded.push_back (3);
+  forwarded.push_back (2);
+
+  EvictionIndex index;
+
+  const uint32_t oldest[] = { 0, 1, 2, 3 };
+  index.SetPolicy (EVICT_DROP_OLDEST, buffer, forwarded);
+  CheckOrder (index, oldest, "DropOldest");
+
+  const uint32_t youngest[] = { 3, 2, 1, 0 };
+  index.SetPolicy (EVICT_DROP_YOUNGEST, buffer, forwarded);
+  CheckOrder (index, youngest, "DropYoungest");
+
+  const uint32_t largest[] = { 1, 3, 2, 0 };
+  index.SetPolicy (EVICT_DROP_LARGEST, buffer, forwarded);
+  CheckOrder (index, largest, "DropLargest");
+
+  const uint32_t lifetime[] = { 1, 3, 0, 2 };
+  index.SetPolicy (EVICT_SHORTEST_LIFETIME, buffer, forwarded);
+  CheckOrder (index, lifetime, "ShortestRemainingLifetime");
+
+  const uint32_t most[] = { 2, 3, 0, 1 };
+  index.SetPolicy (EVICT_MOST_FORWARDED, buffer, forwarded);
+  CheckOrder (index, most, "MostForwarded");
+
+  // Priority per byte: 2/100, 1/400, 3/200, 2/300
+  const uint32_t utility[] = { 1, 3, 2, 0 };
+  index.SetPolicy (EVICT_LOWEST_UTILITY_PER_BIT, buffer, forwarded);
+  CheckOrder (index, utility, "LowestUtilityPerBit");
+
+  // The forward counts change after the bundles were inserted
+  index.SetPolicy (EVICT_MOST_FORWARDED, buffer, forwarded);
+  index.Forwarded (m_bundles[1]->GetBundleId (), 5);
+  NS_TEST_EXPECT_MSG_EQ ((index.GetVictim ()->GetBundleId () == m_bundles[1]->GetBundleId ()), true, "MostForwarded: forwarded more");
+  index.Forwarded (m_bundles[1]->GetBundleId (), 0);
+  NS_TEST_EXPECT_MSG_EQ ((index.GetVictim ()->GetBundleId () == m_bundles[2]->GetBundleId ()), true, "MostForwarded: forward log entries expired");
+  index.Forwarded (m_bundles[0]->GetBundleId (), 3);
+  NS_TEST_EXPECT_MSG_EQ ((index.GetVictim ()->GetBundleId () == m_bundles[0]->GetBundleId ()), true, "MostForwarded: ties go to the oldest");
+  NS_TEST_EXPECT_MSG_EQ (index.GetNBundles (), 4u, "MostForwarded: re-ranking keeps every bundle");
+
+  // The other policies do not depend on the forward counts
+  index.SetPolicy (EVICT_DROP_OLDEST, buffer, forwarded);
+  index.Forwarded (m_bundles[3]->GetBundleId (), 10);
+  NS_TEST_EXPECT_MSG_EQ ((index.GetVictim ()->GetBundleId () == m_bundles[0]->GetBundleId ()), true, "DropOldest: forwards are ignored");
+
+  // A removed bundle is never a victim, inserting it again makes it the youngest
+  index.Remove (m_bundles[0]->GetBundleId ());
+  NS_TEST_EXPECT_MSG_EQ ((index.GetVictim ()->GetBundleId () == m_bundles[1]->GetBundleId ()), true, "Remove");
+  index.Insert (m_bundles[0], 0);
+  const uint32_t reinserted[] = { 1, 2, 3, 0 };
+  CheckOrder (index, reinserted, "Insert after Remove");
+}
+
+class EvictionTestSuite : public TestSuite
+{
+public:
+  EvictionTestSuite ();
+};
+
+EvictionTestSuite::EvictionTestSuite ()
+  : TestSuite ("bundle-protocol-eviction", UNIT)
+{
+  AddTestCase (new EvictionOrderTestCase);
+}
+
+static EvictionTestSuite g_evictionTestSuite;
@@ -0,0 +1,165 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/bp-bundle.h"
+#include "ns3/bp-header.h"
+#include "ns3/bp-fragmentation.h"
+
+using namespace ns3;
+using namespace ns3::bundleProtocol;
+
+static const uint32_t ADU_SIZE = 1000;
+
+/* A whole bundle whose payload byte i is i % 251, so misplaced bytes are noticed */
+static Ptr<Bundle>
+MakeBundle (uint64_t seq)
+{
+  std::vector<uint8_t> data (ADU_SIZE);
+  for (uint32_t i = 0; i < ADU_SIZE; i++)
+    {
+      data[i] = i % 251;
+    }
+
+  PrimaryBundleHeader primaryHeader;
+  primaryHeader.SetSourceEndpoint (BundleEndpointId (1));
+  primaryHeader.SetDestinationEndpoint (BundleEndpointId (2));
+  primaryHeader.SetCreationTimestamp (CreationTimestamp (10, seq));
+  primaryHeader.SetLifetime (Seconds (100));
+  CanonicalBundleHeader payloadHeader (PAYLOAD_BLOCK);
+  payloadHeader.SetLastBlock (true);
+  payloadHeader.SetBlockLength (ADU_SIZE);
+
+  Ptr<Bundle> bundle = Create<Bundle> ();
+  bundle->SetPayload (Create<Packet> (&data[0], ADU_SIZE));
+  bundle->SetPrimaryHeader (primaryHeader);
+  bundle->AddCanonicalHeader (payloadHeader);
+  return bundle;
+}
+
+static bool
+SamePayload (Ptr<Bundle> bundle)
+{
+  if (bundle->GetPayload ()->GetSize () != ADU_SIZE)
+    {
+      return false;
+    }
+  std::vector<uint8_t> data (ADU_SIZE);
+  bundle->GetPayload ()->CopyData (&data[0], ADU_SIZE);
+  for (uint32_t i = 0; i < ADU_SIZE; i++)
+    {
+      if (data[i] != i % 251)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/*
+ * FragmentBundle and FragmentReassembler: offsets of fragments of
+ * fragments, reassembly from out of order and overlapping pieces, holes,
+ * duplicates before and after reassembly, and expiration.
+ */
+class FragmentationTestCase : public TestCase
+{
+public:
+  FragmentationTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void CheckExpired (FragmentReassembler* reassembler, Ptr<Bundle> whole);
+};
+
+FragmentationTestCase::FragmentationTestCase ()
+  : TestCase ("Fragments and their reassembly")
+{
+}
+
+void
+FragmentationTestCase::CheckExpired (FragmentReassembler* reassembler, Ptr<Bundle> whole)
+{
+  reassembler->RemoveExpired ();
+  NS_TEST_EXPECT_MSG_EQ ((reassembler->GetNPending () == 0 && reassembler->GetNReassembled () == 0), true, "expired bundles are forgotten");
+  // Once expired the marker is gone, a copy received now would start over
+  NS_TEST_EXPECT_MSG_EQ ((reassembler->AddFragment (FragmentBundle (whole, 0, 10)) == 0 && reassembler->GetNPending () == 1), true,
+                         "fragment after expiration");
+  reassembler->Clear ();
+}
+
+void
+FragmentationTestCase::DoRun (void)
+{
+  // FragmentBundle
+  Ptr<Bundle> whole = MakeBundle (1);
+  Ptr<Bundle> fragment = FragmentBundle (whole, 200, 300);
+  NS_TEST_EXPECT_MSG_EQ ((fragment->IsFragment () && fragment->GetFragmentOffset () == 200
+                          && fragment->GetPayload ()->GetSize () == 300
+                          && fragment->GetTotalApplicationLength () == ADU_SIZE), true, "fragment of a whole bundle");
+  NS_TEST_EXPECT_MSG_EQ ((fragment->GetBundleId ().GetWholeBundleId () == whole->GetBundleId ()), true, "fragment id");
+  NS_TEST_EXPECT_MSG_EQ (fragment->GetCanonicalHeaders ().front ().GetBlockLength (), 300, "fragment block length");
+  Ptr<Bundle> inner = FragmentBundle (fragment, 100, 50);
+  NS_TEST_EXPECT_MSG_EQ ((inner->GetFragmentOffset () == 300 && inner->GetPayload ()->GetSize () == 50
+                          && inner->GetTotalApplicationLength () == ADU_SIZE), true, "fragment of a fragment is relative to the ADU");
+  NS_TEST_EXPECT_MSG_EQ ((!whole->IsFragment () && whole->GetPayload ()->GetSize () == ADU_SIZE), true, "fragmenting leaves the bundle untouched");
+
+  FragmentReassembler reassembler;
+
+  // Out of order and overlapping pieces
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (whole, 600, 400)) == 0), true, "out of order: tail alone");
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (whole, 0, 400)) == 0), true, "out of order: hole in the middle");
+  Ptr<Bundle> reassembled = reassembler.AddFragment (FragmentBundle (whole, 300, 400));
+  NS_TEST_ASSERT_MSG_EQ ((reassembled != 0), true, "overlap: reassembled");
+  NS_TEST_EXPECT_MSG_EQ ((!reassembled->IsFragment () && reassembled->GetBundleId () == whole->GetBundleId ()), true, "reassembled id");
+  NS_TEST_EXPECT_MSG_EQ (SamePayload (reassembled), true, "reassembled payload");
+  NS_TEST_EXPECT_MSG_EQ (reassembled->GetCanonicalHeaders ().front ().GetBlockLength (), ADU_SIZE, "reassembled block length");
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.GetNPending () == 0 && reassembler.GetNReassembled () == 1), true, "reassembled bundle is no longer pending");
+
+  // Late duplicates of a reassembled bundle are not delivered twice
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (whole, 0, 400)) == 0), true, "late duplicate");
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (whole, 0, 1000)) == 0), true, "late copy covering the ADU");
+  NS_TEST_EXPECT_MSG_EQ (reassembler.GetNPending (), 0u, "late duplicates are not kept");
+
+  // Duplicates before the bundle is complete
+  Ptr<Bundle> other = MakeBundle (2);
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (other, 0, 500)) == 0), true, "duplicate: first copy");
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (other, 0, 500)) == 0), true, "duplicate: second copy");
+  reassembled = reassembler.AddFragment (FragmentBundle (other, 500, 500));
+  NS_TEST_EXPECT_MSG_EQ ((reassembled != 0 && SamePayload (reassembled)), true, "duplicate: reassembled once");
+
+  // Reactive fragments cut at different points of the same bundle
+  Ptr<Bundle> third = MakeBundle (3);
+  Ptr<Bundle> remainder = FragmentBundle (third, 250, 750);
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (third, 0, 250)) == 0), true, "nested: head");
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (remainder, 0, 100)) == 0), true, "nested: part of the remainder");
+  reassembled = reassembler.AddFragment (FragmentBundle (remainder, 50, 700));
+  NS_TEST_EXPECT_MSG_EQ ((reassembled != 0 && SamePayload (reassembled)), true, "nested: reassembled");
+
+  // A hole is never filled
+  Ptr<Bundle> holed = MakeBundle (4);
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (holed, 0, 300)) == 0), true, "hole: head");
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.AddFragment (FragmentBundle (holed, 400, 600)) == 0), true, "hole: tail");
+  NS_TEST_EXPECT_MSG_EQ ((reassembler.GetNPending () == 1 && reassembler.GetNReassembled () == 3), true, "hole: still pending");
+
+  // Every bundle expires at 110 s
+  Simulator::Schedule (Seconds (200), &FragmentationTestCase::CheckExpired, this, &reassembler, holed);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+class FragmentationTestSuite : public TestSuite
+{
+public:
+  FragmentationTestSuite ();
+};
+
+FragmentationTestSuite::FragmentationTestSuite ()
+  : TestSuite ("bundle-protocol-fragmentation", UNIT)
+{
+  AddTestCase (new FragmentationTestCase);
+}
+
+static FragmentationTestSuite g_fragmentationTestSuite;
@@ -0,0 +1,205 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cmath>
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/config.h"
+#include "ns3/vector.h"
+#include "ns3/random-variable.h"
+#include "ns3/packet.h"
+#include "ns3/bp-rt-trend-of-delivery-neigh-hello.h"
+
+using namespace ns3;
+using namespace ns3::bundleProtocol;
+
+/* Meters, the scenario is placed around it to have negative coordinates too */
+static const Vector ORIGIN (500.0, -200.0, 0.0);
+/* Slack for the rounding of the doubles, far below the last digit kept */
+static const double EPSILON = 1e-9;
+/* Random hellos for each precision */
+static const uint32_t HELLOS = 200;
+
+static NeighHello
+MakeHello (uint32_t id, double x, double y, double vx, double vy, uint8_t positionDigits, uint8_t velocityDigits)
+{
+  NeighHello header;
+  header.SetBundleEndpointId (BundleEndpointId (id));
+  header.setPos (x, y);
+  header.setVel (vx, vy);
+  header.setTimeStamp (Simulator::Now ());
+  header.SetPrecision (positionDigits, velocityDigits);
+  return header;
+}
+
+/*
+ * The trend of delivery hello through a packet and back: the error of the
+ * position and the velocity at every precision, the clamping of fast
+ * velocities, the truncation of the time stamp, read at once and after
+ * some time on the air, and the size of a hello with the default precision.
+ */
+class NeighHelloTestCase : public TestCase
+{
+public:
+  NeighHelloTestCase ();
+
+private:
+  virtual void DoRun (void);
+  Ptr<Packet> Send (const NeighHello& header);
+  NeighHello Receive (Ptr<Packet> packet);
+  void CheckPrecision (void);
+  void CheckClamping (void);
+  void CheckTimeStamps (void);
+  void CheckOnTheAir (Ptr<Packet> packet, Time stamp, Time sent);
+};
+
+NeighHelloTestCase::NeighHelloTestCase ()
+  : TestCase ("Compact trend of delivery hello round trip")
+{
+}
+
+Ptr<Packet>
+NeighHelloTestCase::Send (const NeighHello& header)
+{
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), header.GetSerializedSize (), "serialized size");
+  return packet;
+}
+
+NeighHello
+NeighHelloTestCase::Receive (Ptr<Packet> packet)
+{
+  NeighHello header;
+  uint32_t read = packet->RemoveHeader (header);
+  NS_TEST_EXPECT_MSG_EQ ((read > 0 && packet->GetSize () == 0), true, "the whole hello is read");
+  return header;
+}
+
+void
+NeighHelloTestCase::CheckPrecision (void)
+{
+  UniformVariable position (-3000.0, 3000.0);
+  UniformVariable velocity (-40.0, 40.0);
+  UniformVariable id (0, 20000);
+  for (uint8_t pd = 0; pd <= 6; pd++)
+    {
+      for (uint8_t vd = 0; vd <= 4; vd++)
+        {
+          double positionError = 0.5 / std::pow (10.0, pd) + EPSILON;
+          double velocityScale = std::pow (10.0, vd);
+          double velocityError = 0.5 / velocityScale + EPSILON;
+          std::ostringstream what;
+          what << "precision " << (int) pd << "/" << (int) vd;
+          for (uint32_t n = 0; n < HELLOS; n++)
+            {
+              NeighHello sent = MakeHello ((uint32_t) id.GetValue (), ORIGIN.x + position.GetValue (),
+                                           ORIGIN.y + position.GetValue (), velocity.GetValue (), velocity.GetValue (), pd, vd);
+              NeighHello received = Receive (Send (sent));
+              NS_TEST_EXPECT_MSG_EQ ((received.GetBundleEndpointId () == sent.GetBundleEndpointId ()), true, what.str () << " eid");
+              NS_TEST_EXPECT_MSG_EQ_TOL (received.getPos ().x, sent.getPos ().x, positionError, what.str () << " position error");
+              NS_TEST_EXPECT_MSG_EQ_TOL (received.getPos ().y, sent.getPos ().y, positionError, what.str () << " position error");
+              // The clamped velocities are checked apart
+              if (std::fabs (sent.getVel ().x) * velocityScale < 32767 - 0.5)
+                {
+                  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().x, sent.getVel ().x, velocityError, what.str () << " velocity error");
+                }
+              if (std::fabs (sent.getVel ().y) * velocityScale < 32767 - 0.5)
+                {
+                  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().y, sent.getVel ().y, velocityError, what.str () << " velocity error");
+                }
+            }
+        }
+    }
+}
+
+void
+NeighHelloTestCase::CheckClamping (void)
+{
+  NeighHello received = Receive (Send (MakeHello (1, ORIGIN.x, ORIGIN.y, 500.0, -500.0, 1, 2)));
+  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().x, 327.67, EPSILON, "velocity clamped to 32767 hundredths");
+  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().y, -327.67, EPSILON, "velocity clamped to 32767 hundredths");
+  received = Receive (Send (MakeHello (1, ORIGIN.x, ORIGIN.y, 3.5, -1e9, 1, 4)));
+  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().x, 3.2767, EPSILON, "velocity clamped to 32767 ten thousandths");
+  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().y, -3.2767, EPSILON, "velocity clamped to 32767 ten thousandths");
+  received = Receive (Send (MakeHello (1, ORIGIN.x, ORIGIN.y, 3.27669, -3.27669, 1, 4)));
+  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().x, 3.2767, EPSILON, "velocity at the limit is kept");
+  NS_TEST_EXPECT_MSG_EQ_TOL (received.getVel ().y, -3.2767, EPSILON, "velocity at the limit is kept");
+}
+
+void
+NeighHelloTestCase::CheckOnTheAir (Ptr<Packet> packet, Time stamp, Time sent)
+{
+  NeighHello received = Receive (packet);
+  // Late by the millisecond boundaries crossed on the air
+  int64_t late = Simulator::Now ().GetMilliSeconds () - sent.GetMilliSeconds ();
+  NS_TEST_EXPECT_MSG_EQ (received.getTimeStamp (), MilliSeconds (stamp.GetMilliSeconds () + late), "time stamp after time on the air");
+  NS_TEST_EXPECT_MSG_EQ ((received.getTimeStamp () >= stamp - MilliSeconds (1)
+                          && received.getTimeStamp () <= stamp + (Simulator::Now () - sent) + MilliSeconds (1)), true,
+                         "time stamp late by at most the time on the air");
+}
+
+void
+NeighHelloTestCase::CheckTimeStamps (void)
+{
+  Time now = Simulator::Now ();
+  Time ages[] = { Seconds (0), NanoSeconds (400000), MilliSeconds (1), NanoSeconds (999900000), Seconds (60), Seconds (1000) };
+  for (uint32_t a = 0; a < sizeof (ages) / sizeof (ages[0]); a++)
+    {
+      NeighHello sent = MakeHello (1, ORIGIN.x, ORIGIN.y, 0, 0, 1, 2);
+      sent.setTimeStamp (now - ages[a]);
+      NeighHello received = Receive (Send (sent));
+      NS_TEST_EXPECT_MSG_EQ (received.getTimeStamp (), MilliSeconds ((now - ages[a]).GetMilliSeconds ()),
+                             "time stamp " << ages[a].GetSeconds () << " s old truncated to the millisecond");
+    }
+
+  // A stamp ahead of the clock is read as now
+  NeighHello ahead = MakeHello (1, ORIGIN.x, ORIGIN.y, 0, 0, 1, 2);
+  ahead.setTimeStamp (now + Seconds (5));
+  NS_TEST_EXPECT_MSG_EQ (Receive (Send (ahead)).getTimeStamp (), MilliSeconds (now.GetMilliSeconds ()), "time stamp in the future");
+
+  // A hello stamped when it is sent, in a 3 km scenario, with less than 16383 nodes
+  NeighHello fresh = MakeHello (16382, ORIGIN.x + 3000.0, ORIGIN.y - 3000.0, -40.0, 40.0, 1, 2);
+  NS_TEST_EXPECT_MSG_EQ ((fresh.GetSerializedSize () <= 14), true, "default hello in 14 bytes");
+
+  Time delays[] = { MicroSeconds (2), NanoSeconds (2500000), MilliSeconds (40) };
+  for (uint32_t d = 0; d < sizeof (delays) / sizeof (delays[0]); d++)
+    {
+      Time stamp = now - NanoSeconds (123456);
+      NeighHello sent = MakeHello (1, ORIGIN.x, ORIGIN.y, 0, 0, 1, 2);
+      sent.setTimeStamp (stamp);
+      Simulator::Schedule (delays[d], &NeighHelloTestCase::CheckOnTheAir, this, Send (sent), stamp, now);
+    }
+}
+
+void
+NeighHelloTestCase::DoRun (void)
+{
+  SeedManager::SetSeed (1978);
+  // Read by the constructor of every hello
+  Config::SetGlobal ("NeighHelloOrigin", VectorValue (ORIGIN));
+
+  CheckPrecision ();
+  CheckClamping ();
+  // Not on a millisecond boundary
+  Simulator::Schedule (NanoSeconds (1234567890123LL), &NeighHelloTestCase::CheckTimeStamps, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  Config::SetGlobal ("NeighHelloOrigin", VectorValue (Vector (0.0, 0.0, 0.0)));
+}
+
+class NeighHelloTestSuite : public TestSuite
+{
+public:
+  NeighHelloTestSuite ();
+};
+
+NeighHelloTestSuite::NeighHelloTestSuite ()
+  : TestSuite ("bundle-protocol-neigh-hello", UNIT)
+{
+  AddTestCase (new NeighHelloTestCase);
+}
+
+static NeighHelloTestSuite g_neighHelloTestSuite;
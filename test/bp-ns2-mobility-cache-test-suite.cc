@@ -0,0 +1,165 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-model.h"
+#include "ns3/ns2-mobility-helper.h"
+#include "ns3/ns2-mobility-cache-helper.h"
+
+using namespace ns3;
+
+/* Meters, the helpers add the moves up in a different order */
+static const double POSITION_TOLERANCE = 1e-3;
+static const double VELOCITY_TOLERANCE = 1e-6;
+static const double SIMULATION_TIME = 200.0;
+static const double STEP = 0.5;
+
+/* Written and removed by the test, in the directory it runs from */
+static const char *TRACE = "bp-ns2-mobility-cache-test.tcl";
+
+/*
+ * Ns2MobilityCacheHelper moves the nodes as Ns2MobilityHelper does, both
+ * when it reads the trace and when it reads the cache it wrote, and the
+ * start and end times of the nodes survive the cache.
+ */
+class Ns2MobilityCacheTestCase : public TestCase
+{
+public:
+  Ns2MobilityCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void WriteTrace (void) const;
+  void CheckVector (const Vector& actual, const Vector& limit, double tolerance, const std::string& what);
+  void Compare (void);
+
+  NodeContainer m_reference;
+  NodeContainer m_fromTrace;
+  NodeContainer m_fromCache;
+};
+
+Ns2MobilityCacheTestCase::Ns2MobilityCacheTestCase ()
+  : TestCase ("Cached ns-2 mobility against Ns2MobilityHelper")
+{
+}
+
+void
+Ns2MobilityCacheTestCase::WriteTrace (void) const
+{
+  // Initial positions, moves that overlap, a coordinate set while moving and a late start
+  std::ofstream trace (TRACE);
+  trace << "$node_(0) set X_ 10.0\n"
+        << "$node_(0) set Y_ 20.0\n"
+        << "$node_(0) set Z_ 0.0\n"
+        << "$node_(1) set X_ 500.0\n"
+        << "$node_(1) set Y_ 500.0\n"
+        << "$node_(2) set X_ 0.0\n"
+        << "$node_(2) set Y_ 0.0\n"
+        << "$ns_ at 1.0 \"$node_(0) setdest 300.0 400.0 5.0\"\n"
+        << "$ns_ at 5.0 \"$node_(1) setdest 0.0 900.0 3.0\"\n"
+        << "$ns_ at 20.0 \"$node_(1) set X_ 700.0\"\n"
+        << "$ns_ at 30.0 \"$node_(2) setdest 1000.0 1000.0 8.0\"\n"
+        << "$ns_ at 50.0 \"$node_(0) setdest 100.0 50.0 12.5\"\n"
+        << "$ns_ at 80.0 \"$node_(1) setdest 900.0 100.0 20.0\"\n"
+        << "$ns_ at 120.5 \"$node_(0) setdest 120.0 80.0 1.5\"\n"
+        << "$ns_ at 150.0 \"$node_(2) setdest 10.0 10.0 15.0\"\n";
+}
+
+void
+Ns2MobilityCacheTestCase::CheckVector (const Vector& actual, const Vector& limit, double tolerance, const std::string& what)
+{
+  NS_TEST_EXPECT_MSG_EQ_TOL (actual.x, limit.x, tolerance, what << " x at " << Simulator::Now ().GetSeconds () << " s");
+  NS_TEST_EXPECT_MSG_EQ_TOL (actual.y, limit.y, tolerance, what << " y at " << Simulator::Now ().GetSeconds () << " s");
+  NS_TEST_EXPECT_MSG_EQ_TOL (actual.z, limit.z, tolerance, what << " z at " << Simulator::Now ().GetSeconds () << " s");
+}
+
+void
+Ns2MobilityCacheTestCase::Compare (void)
+{
+  for (uint32_t i = 0; i < m_reference.GetN (); i++)
+    {
+      Ptr<MobilityModel> reference = m_reference.Get (i)->GetObject<MobilityModel> ();
+      Ptr<MobilityModel> trace = m_fromTrace.Get (i)->GetObject<MobilityModel> ();
+      Ptr<MobilityModel> cache = m_fromCache.Get (i)->GetObject<MobilityModel> ();
+      std::ostringstream what;
+      what << "node " << i;
+      NS_TEST_ASSERT_MSG_EQ ((reference != 0 && trace != 0 && cache != 0), true, what.str () << " has a movement");
+      CheckVector (trace->GetPosition (), reference->GetPosition (), POSITION_TOLERANCE, what.str () + " position from the trace");
+      CheckVector (trace->GetVelocity (), reference->GetVelocity (), VELOCITY_TOLERANCE, what.str () + " velocity from the trace");
+      // Read back from the cache the movements must be the very same
+      CheckVector (cache->GetPosition (), trace->GetPosition (), 0, what.str () + " position from the cache");
+      CheckVector (cache->GetVelocity (), trace->GetVelocity (), 0, what.str () + " velocity from the cache");
+    }
+  Simulator::Schedule (Seconds (STEP), &Ns2MobilityCacheTestCase::Compare, this);
+}
+
+void
+Ns2MobilityCacheTestCase::DoRun (void)
+{
+  std::string cacheName = std::string (TRACE) + ".cache";
+  WriteTrace ();
+  remove (cacheName.c_str ());
+
+  // The first cache helper reads the trace and writes the cache, the second one reads the cache
+  Ns2MobilityCacheHelper trace (TRACE);
+  FILE *fp = fopen (cacheName.c_str (), "rb");
+  NS_TEST_EXPECT_MSG_EQ ((fp != 0), true, "the cache is written");
+  if (fp != 0)
+    {
+      fclose (fp);
+    }
+  Ns2MobilityCacheHelper cache (TRACE);
+
+  Ptr<bundleProtocol::NodeActivity> read = trace.GetNodeActivity ();
+  Ptr<bundleProtocol::NodeActivity> cached = cache.GetNodeActivity ();
+  uint32_t nodes = read->GetNNodes ();
+  NS_TEST_ASSERT_MSG_EQ (nodes, 3u, "nodes in the trace");
+  NS_TEST_ASSERT_MSG_EQ (cached->GetNNodes (), nodes, "nodes in the cache");
+  double starts[] = { 1.0, 5.0, 30.0 };
+  double ends[] = { 120.5, 80.0, 150.0 };
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      double a = -1, b = -1;
+      NS_TEST_EXPECT_MSG_EQ ((read->GetStartTime (i, a) && a == starts[i]), true, "node " << i << " start time");
+      NS_TEST_EXPECT_MSG_EQ ((cached->GetStartTime (i, b) && a == b), true, "node " << i << " start time from the cache");
+      a = b = -1;
+      NS_TEST_EXPECT_MSG_EQ ((read->GetEndTime (i, a) && a == ends[i]), true, "node " << i << " end time");
+      NS_TEST_EXPECT_MSG_EQ ((cached->GetEndTime (i, b) && a == b), true, "node " << i << " end time from the cache");
+    }
+
+  m_reference.Create (nodes);
+  m_fromTrace.Create (nodes);
+  m_fromCache.Create (nodes);
+  Ns2MobilityHelper ns2 (TRACE);
+  ns2.Install (m_reference.Begin (), m_reference.End ());
+  trace.Install (m_fromTrace.Begin (), m_fromTrace.End ());
+  cache.Install (m_fromCache.Begin (), m_fromCache.End ());
+
+  Simulator::ScheduleNow (&Ns2MobilityCacheTestCase::Compare, this);
+  Simulator::Stop (Seconds (SIMULATION_TIME));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  remove (cacheName.c_str ());
+  remove (TRACE);
+}
+
+class Ns2MobilityCacheTestSuite : public TestSuite
+{
+public:
+  Ns2MobilityCacheTestSuite ();
+};
+
+Ns2MobilityCacheTestSuite::Ns2MobilityCacheTestSuite ()
+  : TestSuite ("bundle-protocol-ns2-mobility-cache", UNIT)
+{
+  AddTestCase (new Ns2MobilityCacheTestCase);
+}
+
+static Ns2MobilityCacheTestSuite g_ns2MobilityCacheTestSuite;
@@ -0,0 +1,236 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+
+#include <cmath>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable.h"
+#include "ns3/bp-spatial-index.h"
+
+using namespace ns3;
+using namespace ns3::bundleProtocol;
+
+static const uint32_t NODES = 500;
+static const double RANGE = 350.0;
+static const double MAX_AGE = 10.0;
+
+/*
+ * SpatialIndex against a scan of all nodes: range queries now and over a
+ * horizon, nodes moving between cells, a new cell size, expired entries
+ * and removed nodes.
+ */
+class SpatialIndexTestCase : public TestCase
+{
+public:
+  SpatialIndexTestCase ();
+
+private:
+  /* What the scan knows of a node */
+  struct Heard
+  {
+    Vector position;
+    Vector velocity;
+    double heard;
+    bool removed;
+  };
+
+  virtual void DoRun (void);
+  void Update (uint32_t id, const Vector& position, const Vector& velocity);
+  /* The closest distance between the node, extrapolated from when it was heard, and the query */
+  double Closest (const Heard& node, const Vector& position, const Vector& velocity, double horizon) const;
+  void CheckQueries (const std::string& phase);
+  void CheckMobility (const std::string& phase);
+  void HeardAgain (void);
+  void Reconfigured (void);
+  void Expired (void);
+
+  SpatialIndex m_index;
+  std::vector<Heard> m_nodes;
+};
+
+SpatialIndexTestCase::SpatialIndexTestCase ()
+  : TestCase ("Spatial index against a scan of all nodes")
+{
+}
+
+void
+SpatialIndexTestCase::Update (uint32_t id, const Vector& position, const Vector& velocity)
+{
+  m_nodes[id].position = position;
+  m_nodes[id].velocity = velocity;
+  m_nodes[id].heard = Simulator::Now ().GetSeconds ();
+  m_nodes[id].removed = false;
+  m_index.Update (id, position, velocity);
+}
+
+double
+SpatialIndexTestCase::Closest (const Heard& node, const Vector& position, const Vector& velocity, double horizon) const
+{
+  double elapsed = Simulator::Now ().GetSeconds () - node.heard;
+  double px = node.position.x + node.velocity.x * elapsed - position.x;
+  double py = node.position.y + node.velocity.y * elapsed - position.y;
+  double vx = node.velocity.x - velocity.x;
+  double vy = node.velocity.y - velocity.y;
+  double best = std::sqrt (px * px + py * py);
+  // Sampled finely enough for the speeds used here, the borderline cases are skipped below
+  for (uint32_t step = 1; step <= 1000 && horizon > 0; step++)
+    {
+      double t = horizon * step / 1000;
+      best = std::min (best, std::sqrt ((px + vx * t) * (px + vx * t) + (py + vy * t) * (py + vy * t)));
+    }
+  return best;
+}
+
+void
+SpatialIndexTestCase::CheckQueries (const std::string& phase)
+{
+  UniformVariable position (0.0, 2000.0);
+  UniformVariable velocity (-20.0, 20.0);
+  double now = Simulator::Now ().GetSeconds ();
+  double horizons[] = { 0.0, 10.0 };
+
+  for (uint32_t q = 0; q < 20; q++)
+    {
+      Vector where (position.GetValue (), position.GetValue (), 0);
+      Vector moving (velocity.GetValue (), velocity.GetValue (), 0);
+      for (uint32_t h = 0; h < 2; h++)
+        {
+          std::vector<uint32_t> found = m_index.GetNodesInRange (where, moving, RANGE, Seconds (horizons[h]));
+          std::set<uint32_t> result (found.begin (), found.end ());
+          std::ostringstream what;
+          what << phase << ": query " << q << " horizon " << horizons[h];
+          NS_TEST_EXPECT_MSG_EQ (result.size (), found.size (), what.str () << " has no duplicates");
+
+          for (uint32_t id = 0; id < m_nodes.size (); id++)
+            {
+              const Heard& node = m_nodes[id];
+              bool known = !node.removed && now - node.heard <= MAX_AGE;
+              double distance = known ? Closest (node, where, moving, horizons[h]) : 0;
+              bool in = result.find (id) != result.end ();
+              if (!known)
+                {
+                  NS_TEST_EXPECT_MSG_EQ (in, false, what.str () << " node " << id << " is gone");
+                }
+              else if (distance < RANGE - 0.5)
+                {
+                  NS_TEST_EXPECT_MSG_EQ (in, true, what.str () << " node " << id << " in range");
+                }
+              else if (distance > RANGE + 0.5)
+                {
+                  NS_TEST_EXPECT_MSG_EQ (in, false, what.str () << " node " << id << " out of range");
+                }
+            }
+        }
+    }
+}
+
+void
+SpatialIndexTestCase::CheckMobility (const std::string& phase)
+{
+  double now = Simulator::Now ().GetSeconds ();
+  for (uint32_t id = 0; id < m_nodes.size (); id++)
+    {
+      const Heard& node = m_nodes[id];
+      Vector position, velocity;
+      bool found = m_index.GetMobility (id, position, velocity);
+      bool known = !node.removed && now - node.heard <= MAX_AGE;
+      NS_TEST_EXPECT_MSG_EQ (found, known, phase << ": mobility of node " << id << " known");
+      if (found && known)
+        {
+          double elapsed = now - node.heard;
+          NS_TEST_EXPECT_MSG_EQ_TOL (position.x, node.position.x + node.velocity.x * elapsed, 1e-6, phase << ": node " << id << " extrapolated");
+          NS_TEST_EXPECT_MSG_EQ_TOL (position.y, node.position.y + node.velocity.y * elapsed, 1e-6, phase << ": node " << id << " extrapolated");
+          NS_TEST_EXPECT_MSG_EQ ((velocity.x == node.velocity.x && velocity.y == node.velocity.y), true, phase << ": node " << id << " velocity");
+        }
+    }
+}
+
+void
+SpatialIndexTestCase::HeardAgain (void)
+{
+  // Half of the nodes are heard again, many of them in another cell
+  UniformVariable position (0.0, 2000.0);
+  UniformVariable velocity (-20.0, 20.0);
+  for (uint32_t id = 0; id < m_nodes.size (); id += 2)
+    {
+      Update (id, Vector (position.GetValue (), position.GetValue (), 0), Vector (velocity.GetValue (), velocity.GetValue (), 0));
+    }
+  CheckMobility ("heard again");
+  CheckQueries ("heard again");
+}
+
+void
+SpatialIndexTestCase::Reconfigured (void)
+{
+  // Smaller cells than the range, the entries are bucketed again
+  m_index.Configure (RANGE / 3, Seconds (MAX_AGE));
+  CheckQueries ("smaller cells");
+}
+
+void
+SpatialIndexTestCase::Expired (void)
+{
+  // Only the nodes heard at 3 s are left
+  CheckMobility ("expired");
+  CheckQueries ("expired");
+  // A query over the whole area drops every expired entry
+  m_index.GetNodesInRange (Vector (1000, 1000, 0), Vector (0, 0, 0), 1e6, Seconds (0));
+  NS_TEST_EXPECT_MSG_EQ (m_index.GetNNodes (), (m_nodes.size () + 1) / 2, "expired entries are removed");
+
+  for (uint32_t id = 0; id < m_nodes.size (); id += 4)
+    {
+      m_index.Remove (id);
+      m_nodes[id].removed = true;
+    }
+  CheckMobility ("removed");
+  CheckQueries ("removed");
+
+  m_index.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (m_index.GetNNodes (), 0u, "cleared");
+}
+
+void
+SpatialIndexTestCase::DoRun (void)
+{
+  SeedManager::SetSeed (1978);
+  m_index.Configure (RANGE, Seconds (MAX_AGE));
+  m_nodes.resize (NODES);
+  UniformVariable position (0.0, 2000.0);
+  UniformVariable velocity (-20.0, 20.0);
+  UniformVariable stopped (0.0, 1.0);
+  for (uint32_t id = 0; id < NODES; id++)
+    {
+      Vector moving (velocity.GetValue (), velocity.GetValue (), 0);
+      // Some nodes stand still
+      if (stopped.GetValue () < 0.1)
+        {
+          moving = Vector (0, 0, 0);
+        }
+      Update (id, Vector (position.GetValue (), position.GetValue (), 0), moving);
+    }
+  CheckMobility ("heard");
+  CheckQueries ("heard");
+
+  Simulator::Schedule (Seconds (3), &SpatialIndexTestCase::HeardAgain, this);
+  Simulator::Schedule (Seconds (5), &SpatialIndexTestCase::Reconfigured, this);
+  Simulator::Schedule (Seconds (12), &SpatialIndexTestCase::Expired, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+class SpatialIndexTestSuite : public TestSuite
+{
+public:
+  SpatialIndexTestSuite ();
+};
+
+SpatialIndexTestSuite::SpatialIndexTestSuite ()
+  : TestSuite ("bundle-protocol-spatial-index", UNIT)
+{
+  AddTestCase (new SpatialIndexTestCase);
+}
+
+static SpatialIndexTestSuite g_spatialIndexTestSuite;